@@ -0,0 +1,115 @@
+#include "AdpcmCodec.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const int16_t kStepTable[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767
+};
+const int8_t kIndexTable[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+// Reconstruct the next sample from a nibble, updating the state
+inline int step(int& predictor, int& index, unsigned int nibble)
+{
+    int stepSize = kStepTable[index];
+    int diff = stepSize >> 3;
+    if (nibble & 4) diff += stepSize;
+    if (nibble & 2) diff += stepSize >> 1;
+    if (nibble & 1) diff += stepSize >> 2;
+    predictor += (nibble & 8) ? -diff : diff;
+    predictor = std::min(32767, std::max(-32768, predictor));
+    index = std::min(88, std::max(0, index + kIndexTable[nibble]));
+    return predictor;
+}
+
+inline int toInt16(float sample)
+{
+    return (int)std::lrintf(std::min(1.0f, std::max(-1.0f, sample)) * 32767.0f);
+}
+} // namespace
+
+bool AdpcmCodec::setup(unsigned int channels)
+{
+    if (channels == 0 || channels > 255)
+        return false;
+    this->channels = channels;
+    encoderState.assign(channels, State{0, 0});
+    return true;
+}
+
+void AdpcmCodec::reset()
+{
+    std::fill(encoderState.begin(), encoderState.end(), State{0, 0});
+}
+
+unsigned int AdpcmCodec::encode(const float* in, unsigned int frames, char* out)
+{
+    frames &= ~1u;
+    uint8_t* p = (uint8_t*)out;
+    *p++ = kVersion;
+    *p++ = channels;
+    *p++ = frames & 0xff;
+    *p++ = frames >> 8;
+
+    for (unsigned int ch = 0; ch < channels; ch++) {
+        State& state = encoderState[ch];
+        *p++ = state.predictor & 0xff;
+        *p++ = (state.predictor >> 8) & 0xff;
+        *p++ = state.index;
+        *p++ = 0;
+
+        for (unsigned int f = 0; f < frames; f++) {
+            // Quantise the prediction error to a sign and three magnitude bits
+            int diff = toInt16(in[f * channels + ch]) - state.predictor;
+            int stepSize = kStepTable[state.index];
+            unsigned int nibble = 0;
+            if (diff < 0) {
+                nibble = 8;
+                diff = -diff;
+            }
+            if (diff >= stepSize) { nibble |= 4; diff -= stepSize; }
+            if (diff >= stepSize >> 1) { nibble |= 2; diff -= stepSize >> 1; }
+            if (diff >= stepSize >> 2) { nibble |= 1; }
+            step(state.predictor, state.index, nibble);
+
+            if (f & 1)
+                *p++ |= nibble << 4;
+            else
+                *p = nibble;
+        }
+    }
+    return p - (uint8_t*)out;
+}
+
+unsigned int AdpcmCodec::decode(const char* in, unsigned int bytes, float* out, unsigned int maxFrames) const
+{
+    const uint8_t* p = (const uint8_t*)in;
+    if (bytes < kHeaderBytes || p[0] != kVersion || p[1] != channels)
+        return 0;
+    unsigned int frames = p[2] | (p[3] << 8);
+    if (frames > maxFrames || (frames & 1) || bytes < getPacketBytes(channels, frames))
+        return 0;
+    p += kHeaderBytes;
+
+    const float scale = 1.0f / 32768.0f;
+    for (unsigned int ch = 0; ch < channels; ch++) {
+        int predictor = (int16_t)(p[0] | (p[1] << 8));
+        int index = std::min<int>(88, p[2]);
+        p += kChannelHeaderBytes;
+        for (unsigned int f = 0; f < frames; f += 2) {
+            uint8_t pair = *p++;
+            out[f * channels + ch] = step(predictor, index, pair & 0x0f) * scale;
+            out[(f + 1) * channels + ch] = step(predictor, index, pair >> 4) * scale;
+        }
+    }
+    return frames;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// IMA ADPCM packets for sending audio as byte-buffer (cf_string) samples.
+//
+// Each packet carries `frames` frames of every channel at 4 bits per sample,
+// i.e. a quarter of int16 and an eighth of float32 bandwidth. Packets are
+// self-contained: every channel starts with its predictor and step index, so
+// a lost packet costs only its own frames and the decoder keeps no state.
+//
+// Layout (little endian):
+//   uint8 version, uint8 channels, uint16 frames
+//   per channel: int16 predictor, uint8 step index, uint8 reserved,
+//                frames / 2 bytes of nibbles, first sample in the low nibble
+class AdpcmCodec {
+public:
+    static constexpr unsigned int kVersion = 1;
+    static constexpr unsigned int kHeaderBytes = 4;
+    static constexpr unsigned int kChannelHeaderBytes = 4;
+
+    // Bytes needed for a packet; `frames` must be even
+    static unsigned int getPacketBytes(unsigned int channels, unsigned int frames)
+    {
+        return kHeaderBytes + channels * (kChannelHeaderBytes + frames / 2);
+    }
+
+    AdpcmCodec() {}
+
+    bool setup(unsigned int channels);
+    void reset();
+
+    // Encode `frames` (even) interleaved frames into `out`, which must hold
+    // getPacketBytes() bytes. Returns the packet size.
+    unsigned int encode(const float* in, unsigned int frames, char* out);
+
+    // Decode a packet into interleaved frames. Returns the number of frames
+    // written, or 0 if the packet is malformed, has a different channel
+    // count or does not fit in `maxFrames`.
+    unsigned int decode(const char* in, unsigned int bytes, float* out, unsigned int maxFrames) const;
+
+    unsigned int getNumChannels() const { return channels; }
+
+private:
+    struct State {
+        int predictor;
+        int index;
+    };
+
+    unsigned int channels = 0;
+    std::vector<State> encoderState;
+};
@@ -0,0 +1,138 @@
+#include "BandPowerExtractor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+bool BandPowerExtractor::setup(const lsl::stream_info& source, const Settings& settings, int32_t maxBuffered)
+{
+    double sampleRate = source.nominal_srate();
+    if (sampleRate == lsl::IRREGULAR_RATE || source.channel_count() <= 0 || settings.bands.empty())
+        return false;
+    if (settings.hop == 0 || settings.hop > settings.windowSize || settings.batchWindows == 0)
+        return false;
+    if (!fft.setup(settings.windowSize))
+        return false;
+
+    channels = source.channel_count();
+    windowSize = settings.windowSize;
+    hop = settings.hop;
+    numBands = settings.bands.size();
+    numFeatures = channels * (numBands + 1);
+    batchWindows = settings.batchWindows;
+    batchCount = 0;
+    filled = 0;
+
+    // Room for a few hops of slack so a slow worker does not drop data
+    input.setup(channels, std::max(4 * hop, windowSize));
+
+    // Band edges as bin ranges, clipped to the spectrum
+    bandFirstBin.clear();
+    bandEndBin.clear();
+    double binWidth = sampleRate / windowSize;
+    for (const auto& band : settings.bands) {
+        unsigned int first = std::min<unsigned int>(std::ceil(band.low / binWidth), fft.getNumBins());
+        unsigned int end = std::min<unsigned int>(std::ceil(band.high / binWidth), fft.getNumBins());
+        bandFirstBin.push_back(first);
+        bandEndBin.push_back(std::max(first, end));
+    }
+
+    hann.resize(windowSize);
+    double windowPower = 0.0;
+    for (unsigned int n = 0; n < windowSize; n++) {
+        hann[n] = 0.5f - 0.5f * std::cos(2.0 * M_PI * n / windowSize);
+        windowPower += hann[n] * hann[n];
+    }
+    // Integrating the one-sided PSD over a band: 2 |X[k]|^2 / (N * sum(w^2))
+    powerScale = 2.0 / (windowSize * windowPower);
+
+    history.assign(channels * windowSize, 0.0f);
+    windowed.assign(windowSize, 0.0f);
+    spectrum.assign(fft.getNumBins(), 0.0f);
+    hopData.assign(hop * channels, 0.0f);
+    hopTimestamps.assign(hop, 0.0);
+    batch.assign(batchWindows * numFeatures, 0.0f);
+    batchTimestamps.assign(batchWindows, 0.0);
+
+    // Describe the features so consumers can route them by label
+    lsl::stream_info info(source.name() + " BandPower", "BandPower", numFeatures,
+        sampleRate / hop, lsl::cf_float32, source.source_id() + "-bandpower");
+    lsl::xml_element features = info.desc().append_child("channels");
+    for (unsigned int c = 0; c < channels; c++) {
+        std::string prefix = "ch" + std::to_string(c) + "_";
+        for (const auto& band : settings.bands)
+            features.append_child("channel")
+                .append_child_value("label", prefix + band.name)
+                .append_child_value("type", "BandPower");
+        features.append_child("channel")
+            .append_child_value("label", prefix + "rms")
+            .append_child_value("type", "RMS");
+    }
+    info.desc().append_child("analysis")
+        .append_child_value("window", std::to_string(windowSize))
+        .append_child_value("hop", std::to_string(hop))
+        .append_child_value("taper", "hann");
+    if (maxBuffered > 0)
+        outlet.reset(new lsl::stream_outlet(info, batchWindows, maxBuffered, transp_bufsize_samples));
+    else
+        outlet.reset(new lsl::stream_outlet(info, batchWindows));
+    return true;
+}
+
+unsigned int BandPowerExtractor::push(const float* data, const double* timestamps, unsigned int frames)
+{
+    return input.write(data, timestamps, frames);
+}
+
+void BandPowerExtractor::process()
+{
+    while (input.getReadAvailable() >= hop) {
+        input.read(hopData.data(), hopTimestamps.data(), hop);
+
+        // Slide each channel's history by one hop and append the new frames
+        for (unsigned int c = 0; c < channels; c++) {
+            float* row = &history[c * windowSize];
+            std::memmove(row, row + hop, (windowSize - hop) * sizeof(float));
+            float* tail = row + windowSize - hop;
+            for (unsigned int f = 0; f < hop; f++)
+                tail[f] = hopData[f * channels + c];
+        }
+
+        filled = std::min(filled + hop, windowSize);
+        if (filled == windowSize)
+            analyse(hopTimestamps[hop - 1]);
+    }
+}
+
+void BandPowerExtractor::analyse(double timestamp)
+{
+    float* row = &batch[batchCount * numFeatures];
+    for (unsigned int c = 0; c < channels; c++) {
+        const float* samples = &history[c * windowSize];
+        float sumSquares = 0.0f;
+        for (unsigned int n = 0; n < windowSize; n++) {
+            sumSquares += samples[n] * samples[n];
+            windowed[n] = samples[n] * hann[n];
+        }
+        fft.power(windowed.data(), spectrum.data());
+
+        for (unsigned int b = 0; b < numBands; b++) {
+            float power = 0.0f;
+            for (unsigned int k = bandFirstBin[b]; k < bandEndBin[b]; k++)
+                power += spectrum[k];
+            *row++ = power * powerScale;
+        }
+        *row++ = std::sqrt(sumSquares / windowSize);
+    }
+    batchTimestamps[batchCount] = timestamp;
+
+    if (++batchCount == batchWindows)
+        flush();
+}
+
+void BandPowerExtractor::flush()
+{
+    if (batchCount == 0 || !outlet)
+        return;
+    outlet->push_chunk_multiplexed(batch.data(), batchTimestamps.data(), batchCount * numFeatures);
+    batchCount = 0;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <lsl_cpp.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "FrameRing.h"
+#include "RealFft.h"
+
+// Windowed band power and RMS per channel of a regular-rate stream,
+// published as a new LSL outlet.
+//
+// The pull side hands chunks to push(), which only copies them into a
+// lock-free ring. process() runs on a worker (a low-priority auxiliary task)
+// and, for every `hop` new frames, analyses the last `windowSize` frames of
+// each channel with a Hann window and a reused FFT plan. Feature rows are
+// collected and pushed to the outlet `batchWindows` at a time, each with the
+// timestamp of the newest frame in its window. All buffers are allocated in
+// setup().
+//
+// Each output sample holds, for every input channel, one value per band
+// (power in the band, in squared input units) followed by the channel RMS.
+class BandPowerExtractor {
+public:
+    struct Band {
+        std::string name;
+        float low;  // Hz, inclusive
+        float high; // Hz, exclusive
+    };
+
+    struct Settings {
+        unsigned int windowSize;   // frames, power of two
+        unsigned int hop;          // frames between windows
+        unsigned int batchWindows; // feature rows per outlet push
+        std::vector<Band> bands;
+    };
+
+    BandPowerExtractor() {}
+
+    // Allocate the buffers and create the outlet. Returns false if the
+    // stream or settings are unsuitable. `maxBuffered` is the outlet's buffer
+    // in feature rows (a MemoryBudget grant), or 0 for liblsl's 360 s.
+    // Throws if the outlet cannot be created.
+    bool setup(const lsl::stream_info& source, const Settings& settings, int32_t maxBuffered = 0);
+
+    // Pull side: queue interleaved frames. Returns the number accepted.
+    unsigned int push(const float* data, const double* timestamps, unsigned int frames);
+
+    // Worker side: analyse every complete hop that is queued
+    void process();
+    // Worker side: push out a partially filled batch
+    void flush();
+
+    // Destroy the outlet. Buffers are kept, so setting up again for a stream
+    // of no more channels does not allocate them.
+    void close() { outlet.reset(); }
+    bool isOpen() const { return outlet != nullptr; }
+    // The feature outlet's source_id, empty when closed
+    std::string getSourceId() const { return outlet ? outlet->info().source_id() : std::string(); }
+
+    // True if process() has a complete hop to work on
+    bool isPending() const { return input.getReadAvailable() >= hop; }
+
+    unsigned int getNumFeatures() const { return numFeatures; }
+
+private:
+    void analyse(double timestamp);
+
+    unsigned int channels = 0;
+    unsigned int windowSize = 0;
+    unsigned int hop = 0;
+    unsigned int numBands = 0;
+    unsigned int numFeatures = 0;
+    unsigned int batchWindows = 0;
+    unsigned int batchCount = 0;
+    unsigned int filled = 0;
+    float powerScale = 0.0f;
+
+    FrameRing input;
+    RealFft fft;
+    std::vector<unsigned int> bandFirstBin;
+    std::vector<unsigned int> bandEndBin;
+    std::vector<float> history;        // channels * windowSize, one row per channel
+    std::vector<float> hann;
+    std::vector<float> windowed;
+    std::vector<float> spectrum;
+    std::vector<float> hopData;        // hop * channels, interleaved
+    std::vector<double> hopTimestamps;
+    std::vector<float> batch;          // batchWindows * numFeatures
+    std::vector<double> batchTimestamps;
+    std::unique_ptr<lsl::stream_outlet> outlet;
+};
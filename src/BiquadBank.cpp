@@ -0,0 +1,149 @@
+#include "BiquadBank.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+bool BiquadBank::setup(unsigned int channels, float sampleRate, const std::vector<Stage>& stages, unsigned int maxFrames)
+{
+    if (channels == 0 || sampleRate <= 0.0f || maxFrames == 0)
+        return false;
+
+    this->channels = channels;
+    this->maxFrames = maxFrames;
+    numGroups = (channels + kLanes - 1) / kLanes;
+    numStages = 0;
+
+    // RBJ cookbook designs, normalised so that a0 == 1
+    for (const auto& stage : stages) {
+        if (numStages >= kMaxStages)
+            break;
+        if (stage.frequency <= 0.0f || stage.frequency >= sampleRate * 0.5f || stage.q <= 0.0f)
+            continue;
+
+        double w0 = 2.0 * M_PI * stage.frequency / sampleRate;
+        double cosw0 = std::cos(w0);
+        double alpha = std::sin(w0) / (2.0 * stage.q);
+        double b0, b1, b2;
+        switch (stage.type) {
+        case lowpass:
+            b0 = (1.0 - cosw0) * 0.5;
+            b1 = 1.0 - cosw0;
+            b2 = b0;
+            break;
+        case highpass:
+            b0 = (1.0 + cosw0) * 0.5;
+            b1 = -(1.0 + cosw0);
+            b2 = b0;
+            break;
+        case notch:
+        default:
+            b0 = 1.0;
+            b1 = -2.0 * cosw0;
+            b2 = 1.0;
+            break;
+        }
+        double a0 = 1.0 + alpha;
+        float* c = coefficients[numStages++];
+        c[0] = b0 / a0;
+        c[1] = b1 / a0;
+        c[2] = b2 / a0;
+        c[3] = -2.0 * cosw0 / a0;
+        c[4] = (1.0 - alpha) / a0;
+    }
+
+    z1.assign(numGroups * kMaxStages * kLanes, 0.0f);
+    z2.assign(numGroups * kMaxStages * kLanes, 0.0f);
+    scratch.assign(channels % kLanes ? maxFrames * kLanes : 0, 0.0f);
+    return true;
+}
+
+void BiquadBank::reserve(unsigned int channels, unsigned int maxFrames)
+{
+    unsigned int groups = (channels + kLanes - 1) / kLanes;
+    z1.reserve(groups * kMaxStages * kLanes);
+    z2.reserve(groups * kMaxStages * kLanes);
+    scratch.reserve(maxFrames * kLanes);
+}
+
+void BiquadBank::reset()
+{
+    std::fill(z1.begin(), z1.end(), 0.0f);
+    std::fill(z2.begin(), z2.end(), 0.0f);
+}
+
+void BiquadBank::process(float* data, unsigned int frames)
+{
+    if (numStages == 0 || frames == 0)
+        return;
+    if (frames > maxFrames)
+        frames = maxFrames;
+
+    unsigned int fullGroups = channels / kLanes;
+    for (unsigned int g = 0; g < fullGroups; g++)
+        processGroup(data + g * kLanes, channels, frames, g);
+
+    unsigned int tail = channels % kLanes;
+    if (tail) {
+        // Stage the remaining channels through a zero-padded buffer so they
+        // can use the same four-lane kernel
+        float* src = data + fullGroups * kLanes;
+        for (unsigned int f = 0; f < frames; f++)
+            std::memcpy(&scratch[f * kLanes], src + f * channels, tail * sizeof(float));
+        processGroup(scratch.data(), kLanes, frames, fullGroups);
+        for (unsigned int f = 0; f < frames; f++)
+            std::memcpy(src + f * channels, &scratch[f * kLanes], tail * sizeof(float));
+    }
+}
+
+// Transposed direct form II over four adjacent channels:
+//   y = b0 * x + z1
+//   z1 = b1 * x - a1 * y + z2
+//   z2 = b2 * x - a2 * y
+void BiquadBank::processGroup(float* data, unsigned int stride, unsigned int frames, unsigned int group)
+{
+    float* groupZ1 = &z1[group * kMaxStages * kLanes];
+    float* groupZ2 = &z2[group * kMaxStages * kLanes];
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    float32x4_t s1[kMaxStages];
+    float32x4_t s2[kMaxStages];
+    for (unsigned int s = 0; s < numStages; s++) {
+        s1[s] = vld1q_f32(groupZ1 + s * kLanes);
+        s2[s] = vld1q_f32(groupZ2 + s * kLanes);
+    }
+    for (unsigned int f = 0; f < frames; f++) {
+        float* frame = data + f * stride;
+        float32x4_t x = vld1q_f32(frame);
+        for (unsigned int s = 0; s < numStages; s++) {
+            const float* c = coefficients[s];
+            float32x4_t y = vmlaq_n_f32(s1[s], x, c[0]);
+            s1[s] = vmlsq_n_f32(vmlaq_n_f32(s2[s], x, c[1]), y, c[3]);
+            s2[s] = vmlsq_n_f32(vmulq_n_f32(x, c[2]), y, c[4]);
+            x = y;
+        }
+        vst1q_f32(frame, x);
+    }
+    for (unsigned int s = 0; s < numStages; s++) {
+        vst1q_f32(groupZ1 + s * kLanes, s1[s]);
+        vst1q_f32(groupZ2 + s * kLanes, s2[s]);
+    }
+#else
+    for (unsigned int f = 0; f < frames; f++) {
+        float* frame = data + f * stride;
+        for (unsigned int s = 0; s < numStages; s++) {
+            const float* c = coefficients[s];
+            float* s1 = groupZ1 + s * kLanes;
+            float* s2 = groupZ2 + s * kLanes;
+            for (unsigned int l = 0; l < kLanes; l++) {
+                float x = frame[l];
+                float y = c[0] * x + s1[l];
+                s1[l] = c[1] * x - c[3] * y + s2[l];
+                s2[l] = c[2] * x - c[4] * y;
+                frame[l] = y;
+            }
+        }
+    }
+#endif
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+
+// Cascaded biquad filters applied to every channel of an interleaved
+// multichannel chunk.
+//
+// All channels share the same cascade of coefficients; the filter state is
+// kept in a structure-of-arrays layout (one float per channel, per stage) so
+// that four adjacent channels of an interleaved frame can be loaded into one
+// NEON vector and filtered in parallel lanes. Channel counts that are not a
+// multiple of four are handled by staging the remaining channels through a
+// padded scratch buffer.
+//
+// setup() allocates; process() and reset() do not, so the bank can be
+// designed when a stream connects and then run from any thread.
+class BiquadBank {
+public:
+    enum Type {
+        lowpass,
+        highpass,
+        notch,
+    };
+
+    struct Stage {
+        Type type;
+        float frequency; // Hz
+        float q;
+    };
+
+    static constexpr unsigned int kLanes = 4;
+    static constexpr unsigned int kMaxStages = 8;
+
+    BiquadBank() {}
+
+    // Design the cascade for a stream of `channels` channels at `sampleRate`.
+    // Stages whose frequency is not below Nyquist are skipped. `maxFrames` is
+    // the largest chunk that will be passed to process().
+    // Returns false if the arguments are invalid.
+    bool setup(unsigned int channels, float sampleRate, const std::vector<Stage>& stages, unsigned int maxFrames);
+
+    // Allocate for up to `channels` channels and `maxFrames` frames, so that
+    // later setup() calls within those limits do not allocate.
+    void reserve(unsigned int channels, unsigned int maxFrames);
+
+    // Filter `frames` interleaved frames in place.
+    void process(float* data, unsigned int frames);
+
+    // Clear the filter state, e.g. after a gap in the stream.
+    void reset();
+
+    unsigned int getNumChannels() const { return channels; }
+    unsigned int getNumStages() const { return numStages; }
+
+private:
+    void processGroup(float* data, unsigned int stride, unsigned int frames, unsigned int group);
+
+    unsigned int channels = 0;
+    unsigned int numGroups = 0;
+    unsigned int numStages = 0;
+    unsigned int maxFrames = 0;
+    // b0, b1, b2, a1, a2 per stage (shared across channels)
+    float coefficients[kMaxStages][5] = {};
+    // per group, per stage, kLanes lanes
+    std::vector<float> z1;
+    std::vector<float> z2;
+    // frames * kLanes, for the trailing group when channels % kLanes != 0
+    std::vector<float> scratch;
+};
@@ -0,0 +1,64 @@
+#include "CoalescingOutlet.h"
+#include <algorithm>
+
+CoalescingOutlet::CoalescingOutlet(const lsl::stream_info& info, unsigned int maxFrames, double maxLatency, int32_t maxBuffered)
+    : outlet(info, 0, maxBuffered), channels(info.channel_count()), maxFrames(std::max(maxFrames, 1u)), maxLatency(maxLatency)
+{
+    data.resize(this->maxFrames * channels);
+    timestamps.resize(this->maxFrames);
+}
+
+CoalescingOutlet::~CoalescingOutlet()
+{
+    try {
+        flush();
+    } catch (std::exception&) {
+    }
+}
+
+void CoalescingOutlet::push_sample(const float* frame, double timestamp)
+{
+    append(frame, timestamp == 0.0 ? lsl::local_clock() : timestamp);
+}
+
+void CoalescingOutlet::push_chunk_multiplexed(const float* data, const double* timestamps, std::size_t elements)
+{
+    std::size_t frames = elements / channels;
+    if (frames >= maxFrames) {
+        // Keep the frames in order, and send the chunk without copying it
+        flush();
+        outlet.push_chunk_multiplexed(data, timestamps, frames * channels);
+        chunksSent++;
+        framesSent += frames;
+        return;
+    }
+    for (std::size_t f = 0; f < frames; f++)
+        append(data + f * channels, timestamps[f]);
+}
+
+void CoalescingOutlet::append(const float* frame, double timestamp)
+{
+    // One clock read per chunk, for poll()
+    if (pending == 0)
+        pendingSince = lsl::local_clock();
+    std::copy(frame, frame + channels, data.begin() + pending * channels);
+    timestamps[pending++] = timestamp;
+    if (pending == maxFrames || timestamp - timestamps[0] >= maxLatency)
+        flush();
+}
+
+void CoalescingOutlet::poll(double now)
+{
+    if (pending > 0 && now - pendingSince >= maxLatency)
+        flush();
+}
+
+void CoalescingOutlet::flush()
+{
+    if (pending == 0)
+        return;
+    outlet.push_chunk_multiplexed(data.data(), timestamps.data(), pending * channels);
+    chunksSent++;
+    framesSent += pending;
+    pending = 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <lsl_cpp.h>
+#include <vector>
+
+// An outlet that gathers pushed frames and sends them as one chunk with
+// per-sample timestamps, instead of one network send per push.
+//
+// A chunk goes out as soon as `maxFrames` frames are waiting, or once the
+// waiting frames' timestamps span `maxLatency` seconds. The two thresholds
+// are the whole trade-off: a consumer sees each frame at most `maxLatency`
+// later than with pushthrough sends, and the outlet sends at most once per
+// `maxFrames` frames. maxFrames = 1 gives the plain outlet's behaviour. A
+// pushed chunk of maxFrames or more is already as large as a coalesced one:
+// the waiting frames go out first, then the chunk as it is. When
+// pushes can stop (e.g. an irregular stream), call poll() regularly so the
+// last frames do not wait for the next push.
+//
+// Frames are float32; setup happens in the constructor, pushing does not
+// allocate.
+class CoalescingOutlet {
+public:
+    CoalescingOutlet(const lsl::stream_info& info, unsigned int maxFrames, double maxLatency, int32_t maxBuffered = 360);
+    // Sends what is waiting; a failure then is dropped, not thrown
+    ~CoalescingOutlet();
+
+    // Without a timestamp the frame is stamped with lsl::local_clock()
+    void push_sample(const float* frame, double timestamp = 0.0);
+    // `elements` is frames * channels
+    void push_chunk_multiplexed(const float* data, const double* timestamps, std::size_t elements);
+
+    // Send the waiting frames if the first of them arrived maxLatency or
+    // more before `now` (local clock)
+    void poll(double now);
+    // Send the waiting frames now
+    void flush();
+
+    unsigned int getPending() const { return pending; }
+    unsigned long getChunksSent() const { return chunksSent; }
+    unsigned long getFramesSent() const { return framesSent; }
+    bool have_consumers() { return outlet.have_consumers(); }
+
+private:
+    void append(const float* frame, double timestamp);
+
+    lsl::stream_outlet outlet;
+    unsigned int channels;
+    unsigned int maxFrames;
+    double maxLatency;
+    std::vector<float> data;
+    std::vector<double> timestamps;
+    unsigned int pending = 0;
+    double pendingSince = 0.0;
+    unsigned long chunksSent = 0;
+    unsigned long framesSent = 0;
+};
@@ -0,0 +1,52 @@
+#include "DeadlinePuller.h"
+#include <cstring>
+
+bool DeadlinePuller::setup(unsigned int maxChannels, unsigned int capacity)
+{
+    if (maxChannels == 0 || capacity == 0)
+        return false;
+    this->maxChannels = maxChannels;
+    this->capacity = capacity;
+    data.assign(maxChannels * capacity, 0.0f);
+    timestamps.assign(capacity, 0.0);
+    return restart(maxChannels);
+}
+
+bool DeadlinePuller::restart(unsigned int channels)
+{
+    if (channels == 0 || channels > maxChannels)
+        return false;
+    this->channels = channels;
+    size = 0;
+    due = 0;
+    return true;
+}
+
+unsigned int DeadlinePuller::pullUntil(lsl::stream_inlet& inlet, double deadline, double offset)
+{
+    // The frames handed out last time are done with; keep the rest
+    if (due > 0) {
+        unsigned int kept = size - due;
+        std::memmove(data.data(), data.data() + due * channels, kept * channels * sizeof(float));
+        std::memmove(timestamps.data(), timestamps.data() + due, kept * sizeof(double));
+        size = kept;
+        due = 0;
+    }
+
+    // Take what has arrived, as far as there is room
+    while (size < capacity) {
+        unsigned int room = capacity - size;
+        unsigned int frames = inlet.pull_chunk_multiplexed(data.data() + size * channels, timestamps.data() + size,
+            room * channels, room, 0.0) / channels;
+        if (offset != 0.0)
+            for (unsigned int n = size; n < size + frames; n++)
+                timestamps[n] += offset;
+        size += frames;
+        if (frames < room)
+            break;
+    }
+
+    while (due < size && timestamps[due] <= deadline)
+        due++;
+    return due;
+}
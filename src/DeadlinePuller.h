@@ -0,0 +1,50 @@
+#pragma once
+
+#include <lsl_cpp.h>
+#include <vector>
+
+// Pulls a stream in blocks bounded by time rather than by what happens to be
+// buffered: pullUntil(deadline) returns every sample whose timestamp is at
+// or before `deadline`, as one contiguous interleaved chunk, and keeps the
+// later ones for the next call.
+//
+// Samples are pulled from the inlet straight into a lookahead buffer and
+// handed out from there, so the returned chunk is never copied; only the
+// few samples held back past a deadline move to the front on the next call.
+// A sample earlier than the deadline that arrives after a later one (out of
+// order) waits for the later one, so the chunk stays in arrival order.
+//
+// Timestamps must be in the local clock: pull with lsl::post_clocksync, or
+// pass the inlet's time_correction() as `offset`. When the lookahead is
+// full, nothing more is pulled until calls free it, so samples wait in the
+// inlet's buffer instead of being dropped.
+//
+// setup() allocates; nothing else does. Float streams only.
+class DeadlinePuller {
+public:
+    DeadlinePuller() {}
+
+    bool setup(unsigned int maxChannels, unsigned int capacity);
+    // Start over for a stream of `channels` channels
+    bool restart(unsigned int channels);
+
+    // Pull what has arrived and return the number of frames at the front of
+    // getData() / getTimestamps() that are due by `deadline`. Throws what
+    // the inlet's pull throws.
+    unsigned int pullUntil(lsl::stream_inlet& inlet, double deadline, double offset = 0.0);
+
+    float* getData() { return data.data(); }
+    double* getTimestamps() { return timestamps.data(); }
+    // Frames pulled but not yet due, and the timestamp of the first of them
+    unsigned int getLookahead() const { return size - due; }
+    double getNextTimestamp() const { return timestamps[due]; }
+
+private:
+    unsigned int maxChannels = 0;
+    unsigned int capacity = 0;
+    unsigned int channels = 0;
+    unsigned int size = 0; // frames in the buffer
+    unsigned int due = 0;  // frames returned by the last call
+    std::vector<float> data;
+    std::vector<double> timestamps;
+};
@@ -0,0 +1,270 @@
+#include "DeltaPackCodec.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+// Little-endian bit stream of up to 32 bits per value
+class BitWriter {
+public:
+    explicit BitWriter(uint8_t* out) : out(out) {}
+    void write(uint32_t value, unsigned int width)
+    {
+        accumulator |= (uint64_t)value << fill;
+        fill += width;
+        while (fill >= 8) {
+            *out++ = accumulator & 0xff;
+            accumulator >>= 8;
+            fill -= 8;
+        }
+    }
+    uint8_t* finish()
+    {
+        if (fill)
+            *out++ = accumulator & 0xff;
+        return out;
+    }
+
+private:
+    uint8_t* out;
+    uint64_t accumulator = 0;
+    unsigned int fill = 0;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* in, const uint8_t* end) : in(in), end(end) {}
+    uint32_t read(unsigned int width)
+    {
+        while (fill < width) {
+            accumulator |= (uint64_t)(in < end ? *in : 0) << fill;
+            in++;
+            fill += 8;
+        }
+        uint32_t value = accumulator & (width == 32 ? 0xffffffffu : ((1u << width) - 1));
+        accumulator >>= width;
+        fill -= width;
+        return value;
+    }
+private:
+    const uint8_t* in;
+    const uint8_t* end;
+    uint64_t accumulator = 0;
+    unsigned int fill = 0;
+};
+
+inline unsigned int bitWidth(uint64_t mask)
+{
+    unsigned int width = 0;
+    while (mask) {
+        width++;
+        mask >>= 1;
+    }
+    return width;
+}
+
+inline void putLittleEndian(uint8_t*& p, uint64_t value, unsigned int bytes)
+{
+    for (unsigned int b = 0; b < bytes; b++)
+        *p++ = (value >> (8 * b)) & 0xff;
+}
+
+inline uint64_t getLittleEndian(const uint8_t*& p, unsigned int bytes)
+{
+    uint64_t value = 0;
+    for (unsigned int b = 0; b < bytes; b++)
+        value |= (uint64_t)*p++ << (8 * b);
+    return value;
+}
+
+unsigned int formatBytes(lsl::channel_format_t format)
+{
+    switch (format) {
+    case lsl::cf_int8: return 1;
+    case lsl::cf_int16: return 2;
+    case lsl::cf_int32: return 4;
+    case lsl::cf_int64: return 8;
+    default: return 0;
+    }
+}
+} // namespace
+
+bool DeltaPackCodec::setup(unsigned int channels, lsl::channel_format_t format, unsigned int maxFrames)
+{
+    sampleBytes = formatBytes(format);
+    if (channels == 0 || channels > 0xffff || maxFrames == 0 || maxFrames > 0xffff || sampleBytes == 0)
+        return false;
+
+    this->channels = channels;
+    this->format = format;
+    this->maxFrames = maxFrames;
+    wide.assign(sampleBytes < 4 ? maxFrames * channels : 0, 0);
+    deltas.assign(maxFrames * channels, 0);
+    widthMask.assign(channels, 0);
+    return true;
+}
+
+unsigned int DeltaPackCodec::getMaxPacketBytes(unsigned int frames) const
+{
+    unsigned int deltaBytes = frames ? ((frames - 1) * sampleBytes * 8 + 7) / 8 : 0;
+    return kHeaderBytes + channels * (sampleBytes + 1 + deltaBytes);
+}
+
+// Delta, narrow to the sample width, zigzag and OR-reduce per channel, then
+// pack each channel with its own width. Works for samples of up to 32 bits.
+unsigned int DeltaPackCodec::encodeNarrow(const int32_t* in, unsigned int frames, unsigned int bits, char* out)
+{
+    const unsigned int shift = 32 - bits;
+    std::fill(widthMask.begin(), widthMask.end(), 0);
+    unsigned int c = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const int32x4_t up = vdupq_n_s32(shift);
+    const int32x4_t down = vdupq_n_s32(-(int32_t)shift);
+    const int32x4_t sign = vdupq_n_s32(-31);
+    for (; c + 4 <= channels; c += 4) {
+        uint32x4_t mask = vdupq_n_u32(0);
+        int32x4_t previous = vld1q_s32(in + c);
+        for (unsigned int f = 1; f < frames; f++) {
+            int32x4_t current = vld1q_s32(in + f * channels + c);
+            // Wrap the delta to the sample width so it fits in `bits` bits
+            int32x4_t d = vreinterpretq_s32_u32(vsubq_u32(vreinterpretq_u32_s32(current), vreinterpretq_u32_s32(previous)));
+            d = vshlq_s32(vshlq_s32(d, up), down);
+            uint32x4_t zz = veorq_u32(vshlq_n_u32(vreinterpretq_u32_s32(d), 1),
+                                      vreinterpretq_u32_s32(vshlq_s32(d, sign)));
+            vst1q_u32(&deltas[(f - 1) * channels + c], zz);
+            mask = vorrq_u32(mask, zz);
+            previous = current;
+        }
+        vst1q_u32(&widthMask[c], mask);
+    }
+#endif
+    for (; c < channels; c++) {
+        uint32_t mask = 0;
+        for (unsigned int f = 1; f < frames; f++) {
+            uint32_t raw = (uint32_t)in[f * channels + c] - (uint32_t)in[(f - 1) * channels + c];
+            int32_t d = (int32_t)(raw << shift) >> shift;
+            uint32_t zz = ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+            deltas[(f - 1) * channels + c] = zz;
+            mask |= zz;
+        }
+        widthMask[c] = mask;
+    }
+
+    uint8_t* p = (uint8_t*)out;
+    for (c = 0; c < channels; c++) {
+        unsigned int width = bitWidth(widthMask[c]);
+        putLittleEndian(p, (uint32_t)in[c], sampleBytes);
+        *p++ = width;
+        if (width == 0)
+            continue;
+        BitWriter writer(p);
+        for (unsigned int f = 1; f < frames; f++)
+            writer.write(deltas[(f - 1) * channels + c], width);
+        p = writer.finish();
+    }
+    return p - (uint8_t*)out;
+}
+
+template <class T>
+unsigned int DeltaPackCodec::encode(const T* in, unsigned int frames, char* out)
+{
+    if (sizeof(T) != sampleBytes || frames == 0)
+        return 0;
+    frames = std::min(frames, maxFrames);
+
+    uint8_t* p = (uint8_t*)out;
+    *p++ = kVersion;
+    *p++ = format;
+    putLittleEndian(p, channels, 2);
+    putLittleEndian(p, frames, 2);
+
+    if (sizeof(T) == 4)
+        return kHeaderBytes + encodeNarrow((const int32_t*)in, frames, 32, (char*)p);
+
+    if (sizeof(T) < 4) {
+        for (unsigned int n = 0; n < frames * channels; n++)
+            wide[n] = in[n];
+        return kHeaderBytes + encodeNarrow(wide.data(), frames, sizeof(T) * 8, (char*)p);
+    }
+
+    // 64-bit samples: scalar, each delta written as two 32-bit halves
+    for (unsigned int c = 0; c < channels; c++) {
+        uint64_t mask = 0;
+        for (unsigned int f = 1; f < frames; f++) {
+            int64_t d = (int64_t)((uint64_t)in[f * channels + c] - (uint64_t)in[(f - 1) * channels + c]);
+            mask |= ((uint64_t)d << 1) ^ (uint64_t)(d >> 63);
+        }
+        unsigned int width = bitWidth(mask);
+        putLittleEndian(p, (uint64_t)in[c], 8);
+        *p++ = width;
+        if (width == 0)
+            continue;
+        BitWriter writer(p);
+        for (unsigned int f = 1; f < frames; f++) {
+            int64_t d = (int64_t)((uint64_t)in[f * channels + c] - (uint64_t)in[(f - 1) * channels + c]);
+            uint64_t zz = ((uint64_t)d << 1) ^ (uint64_t)(d >> 63);
+            writer.write(zz & 0xffffffffu, std::min(width, 32u));
+            if (width > 32)
+                writer.write(zz >> 32, width - 32);
+        }
+        p = writer.finish();
+    }
+    return p - (uint8_t*)out;
+}
+
+template <class T>
+unsigned int DeltaPackCodec::decode(const char* in, unsigned int bytes, T* out, unsigned int maxFrames)
+{
+    typedef typename std::conditional<sizeof(T) == 8, uint64_t, uint32_t>::type Unsigned;
+    const uint8_t* p = (const uint8_t*)in;
+    const uint8_t* end = p + bytes;
+    if (sizeof(T) != sampleBytes || bytes < kHeaderBytes || p[0] != kVersion || p[1] != format)
+        return 0;
+    p += 2;
+    unsigned int packetChannels = getLittleEndian(p, 2);
+    unsigned int frames = getLittleEndian(p, 2);
+    if (packetChannels != channels || frames == 0 || frames > maxFrames)
+        return 0;
+
+    for (unsigned int c = 0; c < channels; c++) {
+        if (end - p < (long)sampleBytes + 1)
+            return 0;
+        Unsigned value = getLittleEndian(p, sampleBytes);
+        unsigned int width = *p++;
+        if (width > sampleBytes * 8)
+            return 0;
+        out[c] = (T)value;
+
+        BitReader reader(p, end);
+        for (unsigned int f = 1; f < frames; f++) {
+            Unsigned zz = 0;
+            if (width > 32) {
+                uint64_t low = reader.read(32);
+                uint64_t high = reader.read(width - 32);
+                zz = (Unsigned)(low | (high << 32));
+            } else if (width) {
+                zz = reader.read(width);
+            }
+            // Undo the zigzag and accumulate, wrapping like the encoder did
+            Unsigned delta = (zz >> 1) ^ (Unsigned)(-(typename std::make_signed<Unsigned>::type)(zz & 1));
+            value += delta;
+            out[f * channels + c] = (T)value;
+        }
+        p += ((frames - 1) * width + 7) / 8;
+        if (p > end)
+            return 0;
+    }
+    return frames;
+}
+
+template unsigned int DeltaPackCodec::encode<int8_t>(const int8_t*, unsigned int, char*);
+template unsigned int DeltaPackCodec::encode<int16_t>(const int16_t*, unsigned int, char*);
+template unsigned int DeltaPackCodec::encode<int32_t>(const int32_t*, unsigned int, char*);
+template unsigned int DeltaPackCodec::encode<int64_t>(const int64_t*, unsigned int, char*);
+template unsigned int DeltaPackCodec::decode<int8_t>(const char*, unsigned int, int8_t*, unsigned int);
+template unsigned int DeltaPackCodec::decode<int16_t>(const char*, unsigned int, int16_t*, unsigned int);
+template unsigned int DeltaPackCodec::decode<int32_t>(const char*, unsigned int, int32_t*, unsigned int);
+template unsigned int DeltaPackCodec::decode<int64_t>(const char*, unsigned int, int64_t*, unsigned int);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <lsl_cpp.h>
+#include <cstdint>
+#include <vector>
+
+// Lossless codec for chunks of integer samples (cf_int8, cf_int16, cf_int32
+// and cf_int64), carried as one byte-buffer (cf_string) sample per chunk.
+//
+// Each channel is delta-encoded along time, the deltas are zigzag-mapped to
+// unsigned values and bit-packed with the smallest width that holds all of
+// them in the chunk (a frame-of-reference scheme). Biosignals with small
+// sample-to-sample changes typically pack into well under half their raw
+// size. Deltas are computed four channels at a time on interleaved frames
+// with NEON, so encoding needs no transposition.
+//
+// Packets are self-contained. Layout (little endian):
+//   uint8 version, uint8 channel format, uint16 channels, uint16 frames
+//   per channel: first sample (sizeof(T) bytes), uint8 bit width,
+//                (frames - 1) * width bits of zigzag deltas, byte aligned
+//
+// The packet timestamp is that of its first frame; for regular-rate streams
+// the remaining timestamps follow from the nominal rate.
+class DeltaPackCodec {
+public:
+    static constexpr unsigned int kVersion = 1;
+    static constexpr unsigned int kHeaderBytes = 6;
+
+    DeltaPackCodec() {}
+
+    // `format` must be one of the integer channel formats
+    bool setup(unsigned int channels, lsl::channel_format_t format, unsigned int maxFrames);
+
+    // Upper bound on the packet size for `frames` frames
+    unsigned int getMaxPacketBytes(unsigned int frames) const;
+
+    // Encode `frames` interleaved frames into `out`, which must hold
+    // getMaxPacketBytes(frames) bytes. Returns the packet size.
+    template <class T> unsigned int encode(const T* in, unsigned int frames, char* out);
+
+    // Decode a packet straight into an interleaved chunk buffer, as filled by
+    // stream_inlet::pull_chunk_multiplexed(). Returns the number of frames,
+    // or 0 if the packet is malformed or does not match the setup.
+    template <class T> unsigned int decode(const char* in, unsigned int bytes, T* out, unsigned int maxFrames);
+
+    unsigned int getNumChannels() const { return channels; }
+    lsl::channel_format_t getFormat() const { return format; }
+
+private:
+    unsigned int encodeNarrow(const int32_t* in, unsigned int frames, unsigned int bits, char* out);
+
+    unsigned int channels = 0;
+    unsigned int maxFrames = 0;
+    unsigned int sampleBytes = 0;
+    lsl::channel_format_t format = lsl::cf_undefined;
+    std::vector<int32_t> wide;     // maxFrames * channels, for 8 and 16 bit input
+    std::vector<uint32_t> deltas;  // maxFrames * channels, zigzag deltas
+    std::vector<uint32_t> widthMask; // OR of each channel's deltas
+};
@@ -0,0 +1,81 @@
+#include "DeltaPackOutlet.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+static const char* formatName(lsl::channel_format_t format)
+{
+    switch (format) {
+    case lsl::cf_int8: return "int8";
+    case lsl::cf_int16: return "int16";
+    case lsl::cf_int32: return "int32";
+    case lsl::cf_int64: return "int64";
+    default: return nullptr;
+    }
+}
+
+bool DeltaPackOutlet::open(const lsl::stream_info& info, unsigned int packetFrames, int32_t maxBuffered)
+{
+    const char* format = formatName(info.channel_format());
+    double sampleRate = info.nominal_srate();
+    if (!format || sampleRate <= 0.0 || !codec.setup(info.channel_count(), info.channel_format(), packetFrames))
+        return false;
+
+    lsl::stream_info packed(info.name(), info.type() + "/delta", 1, sampleRate / packetFrames,
+        lsl::cf_string, info.source_id());
+    packed.desc().append_child("encoding")
+        .append_child_value("codec", "delta-for")
+        .append_child_value("channel_format", format)
+        .append_child_value("channel_count", std::to_string(info.channel_count()))
+        .append_child_value("frames_per_packet", std::to_string(packetFrames))
+        .append_child_value("nominal_srate", std::to_string(sampleRate));
+
+    channels = info.channel_count();
+    this->packetFrames = packetFrames;
+    this->sampleRate = sampleRate;
+    sampleBytes = info.channel_bytes();
+    pending.resize(packetFrames * channels * sampleBytes);
+    pendingFrames = 0;
+    packet.resize(codec.getMaxPacketBytes(packetFrames));
+    rawBytes = 0;
+    packetBytes = 0;
+    if (maxBuffered > 0)
+        outlet.reset(new lsl::stream_outlet(packed, 0, maxBuffered, transp_bufsize_samples));
+    else
+        outlet.reset(new lsl::stream_outlet(packed));
+    return true;
+}
+
+template <class T>
+unsigned int DeltaPackOutlet::push(const T* frames, unsigned int count, double timestamp)
+{
+    if (!outlet || sizeof(T) != sampleBytes)
+        return 0;
+    rawBytes += count * channels * sizeof(T);
+    unsigned int packets = 0;
+    unsigned int done = 0;
+    while (done < count) {
+        if (pendingFrames == 0)
+            pendingTime = timestamp + done / sampleRate;
+        unsigned int taken = std::min(count - done, packetFrames - pendingFrames);
+        std::memcpy(&pending[pendingFrames * channels * sizeof(T)], &frames[done * channels],
+                    taken * channels * sizeof(T));
+        pendingFrames += taken;
+        done += taken;
+        if (pendingFrames < packetFrames)
+            break;
+
+        uint32_t bytes = codec.encode(reinterpret_cast<const T*>(pending.data()), packetFrames, packet.data());
+        const char* data = packet.data();
+        lsl_push_sample_buft(outlet->handle().get(), &data, &bytes, pendingTime);
+        packetBytes += bytes;
+        pendingFrames = 0;
+        packets++;
+    }
+    return packets;
+}
+
+template unsigned int DeltaPackOutlet::push<int8_t>(const int8_t*, unsigned int, double);
+template unsigned int DeltaPackOutlet::push<int16_t>(const int16_t*, unsigned int, double);
+template unsigned int DeltaPackOutlet::push<int32_t>(const int32_t*, unsigned int, double);
+template unsigned int DeltaPackOutlet::push<int64_t>(const int64_t*, unsigned int, double);
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <lsl_cpp.h>
+#include <memory>
+#include <vector>
+#include "DeltaPackCodec.h"
+
+// Publishes a regular-rate integer stream as DeltaPackCodec packets: one
+// byte-buffer sample per packet of `packetFrames` frames, in a stream of
+// type "<type>/delta" whose desc()/encoding describes the original format.
+// That is the layout render.cpp decodes.
+//
+// push() gathers frames until a packet is full, then encodes and pushes it
+// with the timestamp of its first frame. open() allocates; push() does not.
+class DeltaPackOutlet {
+public:
+    DeltaPackOutlet() {}
+
+    // `info` describes the original stream: an integer channel format and a
+    // regular rate. `maxBuffered` is the outlet's buffer in packets (a
+    // MemoryBudget grant), or 0 for liblsl's 360 s. Throws if the outlet
+    // cannot be created.
+    bool open(const lsl::stream_info& info, unsigned int packetFrames, int32_t maxBuffered = 0);
+    void close() { outlet.reset(); }
+    bool isOpen() const { return outlet != nullptr; }
+
+    // Queue interleaved frames in the stream's format, the first sampled at
+    // `timestamp`. Returns the number of packets pushed.
+    template <class T> unsigned int push(const T* frames, unsigned int count, double timestamp);
+
+    // Sample bytes queued so far, and packet bytes sent for them
+    unsigned long getRawBytes() const { return rawBytes; }
+    unsigned long getPacketBytes() const { return packetBytes; }
+
+private:
+    DeltaPackCodec codec;
+    std::unique_ptr<lsl::stream_outlet> outlet;
+    unsigned int channels = 0;
+    unsigned int packetFrames = 0;
+    unsigned int sampleBytes = 0;
+    double sampleRate = 0.0;
+    std::vector<char> pending; // packetFrames frames waiting to be packed
+    unsigned int pendingFrames = 0;
+    double pendingTime = 0.0;  // timestamp of the first pending frame
+    std::vector<char> packet;
+    unsigned long rawBytes = 0;
+    unsigned long packetBytes = 0;
+};
@@ -0,0 +1,105 @@
+#include "EventScheduler.h"
+#include <algorithm>
+
+bool EventScheduler::setup(unsigned int capacity, float sampleRate, double latency)
+{
+    if (capacity == 0 || sampleRate <= 0.0f || latency < 0.0)
+        return false;
+
+    unsigned int size = 1;
+    while (size < capacity)
+        size *= 2;
+
+    mask = size - 1;
+    ring.assign(size, Event());
+    heap.assign(size, Event());
+    heapSize = 0;
+    writeCount = 0;
+    readCount = 0;
+    dropped = 0;
+    this->sampleRate = sampleRate;
+    this->latency = latency;
+    clock.setup(sampleRate);
+    blockFrames = 0;
+    late = 0;
+    return true;
+}
+
+bool EventScheduler::schedule(double time, unsigned int stream, const float* values, unsigned int channels)
+{
+    unsigned int start = writeCount.load(std::memory_order_relaxed);
+    if (start - readCount.load(std::memory_order_acquire) > mask) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    Event& event = ring[start & mask];
+    event.time = time;
+    event.stream = stream;
+    event.channels = channels < kMaxValues ? channels : kMaxValues;
+    std::copy(values, values + event.channels, event.values);
+    writeCount.store(start + 1, std::memory_order_release);
+    return true;
+}
+
+void EventScheduler::beginBlock(uint64_t framesElapsed, unsigned int frames, double now)
+{
+    blockStart = clock.update(framesElapsed, now) - latency;
+    blockEnd = blockStart + frames / sampleRate;
+    blockFrames = frames;
+
+    // Move what the pull task queued into the heap
+    unsigned int start = readCount.load(std::memory_order_relaxed);
+    unsigned int end = writeCount.load(std::memory_order_acquire);
+    unsigned int count = std::min<unsigned int>(end - start, heap.size() - heapSize);
+    for (unsigned int n = 0; n < count; n++)
+        heapPush(ring[(start + n) & mask]);
+    readCount.store(start + count, std::memory_order_release);
+}
+
+const EventScheduler::Event* EventScheduler::next(unsigned int& frame)
+{
+    if (heapSize == 0 || heap[0].time >= blockEnd)
+        return nullptr;
+
+    current = heap[0];
+    heapPop();
+    double position = (current.time - blockStart) * sampleRate;
+    if (position < 0.0) {
+        late++;
+        frame = 0;
+    } else {
+        frame = std::min((unsigned int)position, blockFrames - 1);
+    }
+    return &current;
+}
+
+void EventScheduler::heapPush(const Event& event)
+{
+    unsigned int n = heapSize++;
+    while (n > 0) {
+        unsigned int parent = (n - 1) / 2;
+        if (heap[parent].time <= event.time)
+            break;
+        heap[n] = heap[parent];
+        n = parent;
+    }
+    heap[n] = event;
+}
+
+void EventScheduler::heapPop()
+{
+    const Event& last = heap[--heapSize];
+    unsigned int n = 0;
+    for (;;) {
+        unsigned int child = 2 * n + 1;
+        if (child >= heapSize)
+            break;
+        if (child + 1 < heapSize && heap[child + 1].time < heap[child].time)
+            child++;
+        if (last.time <= heap[child].time)
+            break;
+        heap[n] = heap[child];
+        n = child;
+    }
+    heap[n] = last;
+}
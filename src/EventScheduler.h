@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "FrameClock.h"
+
+// Delivers samples of irregular-rate (marker / trigger) streams to the audio
+// thread at the frame they belong to, instead of at whichever block happens
+// to follow the pull task.
+//
+// The pull task schedule()s each sample with its timestamp in the local
+// clock (pull with lsl::post_clocksync). Events travel to the audio thread
+// through a lock-free single-producer / single-consumer ring; the audio
+// thread moves them into a binary min-heap ordered by time, so events of
+// several streams come out in time order whatever order they were pulled in.
+//
+// The audio thread maps its frame counter to the local clock with a
+// FrameClock and plays every event `latency` seconds after its timestamp.
+// With the latency above the pull task's worst case, every event lands on
+// the frame its timestamp calls for, to within the clock mapping's error
+// rather than a block plus the pull task's delay. Events that arrive too
+// late are played at the start of the next block and counted.
+//
+// setup() allocates; schedule(), beginBlock() and next() only copy.
+class EventScheduler {
+public:
+    static constexpr unsigned int kMaxValues = 8;
+
+    struct Event {
+        double time = 0.0;        // local clock, without the latency
+        unsigned int stream = 0;
+        unsigned int channels = 0;
+        float values[kMaxValues] = {};
+    };
+
+    EventScheduler() {}
+
+    // Room for `capacity` pending events (rounded up to a power of two)
+    bool setup(unsigned int capacity, float sampleRate, double latency);
+
+    // Producer side. Values beyond kMaxValues are dropped. Returns false, and
+    // counts the event as dropped, if the queue is full.
+    bool schedule(double time, unsigned int stream, const float* values, unsigned int channels);
+
+    // Audio thread: call once per block with the block's first frame number
+    // and the local clock read at the start of render()
+    void beginBlock(uint64_t framesElapsed, unsigned int frames, double now);
+    // Audio thread: the next event due in the current block and its frame
+    // index within the block, in time order. Returns nullptr when there are
+    // no more; the event stays valid until the next call.
+    const Event* next(unsigned int& frame);
+
+    double getLatency() const { return latency; }
+    unsigned long getLate() const { return late; }
+    unsigned long getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    void heapPush(const Event& event);
+    void heapPop();
+
+    unsigned int mask = 0;
+    std::vector<Event> ring;
+    std::atomic<unsigned int> writeCount{0};
+    std::atomic<unsigned int> readCount{0};
+    std::atomic<unsigned long> dropped{0};
+
+    std::vector<Event> heap; // earliest first
+    unsigned int heapSize = 0;
+    Event current;
+
+    double sampleRate = 0.0;
+    double latency = 0.0;
+    FrameClock clock;
+    double blockStart = 0.0;  // when, on the local clock, the block's events are due
+    double blockEnd = 0.0;
+    unsigned int blockFrames = 0;
+    unsigned long late = 0;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// Maps the audio thread's frame counter to lsl::local_clock().
+//
+// The local clock is read whenever render() gets to run, so readings are
+// late by a varying scheduling delay but never early. The frame-to-clock
+// offset therefore follows the earliest readings: it drops to any lower
+// reading at once and creeps up towards higher ones, slowly enough to ignore
+// the delays while still tracking drift between the audio and system clocks.
+class FrameClock {
+public:
+    FrameClock() {}
+
+    void setup(double sampleRate)
+    {
+        this->sampleRate = sampleRate;
+        synced = false;
+    }
+
+    // Call once per block with the block's first frame and the local clock
+    // read in render(). Returns the local time of that frame.
+    double update(uint64_t framesElapsed, double now)
+    {
+        double elapsed = framesElapsed / sampleRate;
+        double offset = now - elapsed;
+        if (!synced || std::fabs(offset - clockOffset) > kResync) {
+            clockOffset = offset;
+            synced = true;
+        } else if (offset < clockOffset) {
+            clockOffset = offset;
+        } else {
+            clockOffset += kRise * (offset - clockOffset);
+        }
+        return clockOffset + elapsed;
+    }
+
+    // Local time of any frame, once update() has been called
+    double getTime(uint64_t frame) const { return clockOffset + frame / sampleRate; }
+    double getSampleRate() const { return sampleRate; }
+
+private:
+    static constexpr double kRise = 0.001;
+    // Readings further off than this mean the stream of blocks was interrupted
+    static constexpr double kResync = 0.05;
+
+    double sampleRate = 0.0;
+    double clockOffset = 0.0; // local clock minus framesElapsed / sampleRate
+    bool synced = false;
+};
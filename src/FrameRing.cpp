@@ -0,0 +1,71 @@
+#include "FrameRing.h"
+#include <algorithm>
+#include <cstring>
+
+bool FrameRing::setup(unsigned int channels, unsigned int capacity)
+{
+    if (channels == 0 || capacity == 0)
+        return false;
+
+    unsigned int size = 1;
+    while (size < capacity)
+        size *= 2;
+
+    this->channels = channels;
+    mask = size - 1;
+    data.assign(size * channels, 0.0f);
+    timestamps.assign(size, 0.0);
+    writeCount = 0;
+    readCount = 0;
+    return true;
+}
+
+unsigned int FrameRing::getWriteAvailable() const
+{
+    return getCapacity() - (writeCount.load(std::memory_order_relaxed) - readCount.load(std::memory_order_acquire));
+}
+
+unsigned int FrameRing::getReadAvailable() const
+{
+    return writeCount.load(std::memory_order_acquire) - readCount.load(std::memory_order_relaxed);
+}
+
+unsigned int FrameRing::write(const float* in, const double* inTimestamps, unsigned int frames)
+{
+    frames = std::min(frames, getWriteAvailable());
+    unsigned int start = writeCount.load(std::memory_order_relaxed);
+    // Copy in at most two contiguous runs
+    unsigned int done = 0;
+    while (done < frames) {
+        unsigned int pos = (start + done) & mask;
+        unsigned int run = std::min(frames - done, getCapacity() - pos);
+        std::memcpy(&data[pos * channels], in + done * channels, run * channels * sizeof(float));
+        std::memcpy(&timestamps[pos], inTimestamps + done, run * sizeof(double));
+        done += run;
+    }
+    writeCount.store(start + frames, std::memory_order_release);
+    return frames;
+}
+
+unsigned int FrameRing::read(float* out, double* outTimestamps, unsigned int frames)
+{
+    frames = std::min(frames, getReadAvailable());
+    unsigned int start = readCount.load(std::memory_order_relaxed);
+    unsigned int done = 0;
+    while (done < frames) {
+        unsigned int pos = (start + done) & mask;
+        unsigned int run = std::min(frames - done, getCapacity() - pos);
+        std::memcpy(out + done * channels, &data[pos * channels], run * channels * sizeof(float));
+        if (outTimestamps)
+            std::memcpy(outTimestamps + done, &timestamps[pos], run * sizeof(double));
+        done += run;
+    }
+    readCount.store(start + frames, std::memory_order_release);
+    return frames;
+}
+
+void FrameRing::discard(unsigned int frames)
+{
+    frames = std::min(frames, getReadAvailable());
+    readCount.store(readCount.load(std::memory_order_relaxed) + frames, std::memory_order_release);
+}
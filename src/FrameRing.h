@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+// Lock-free single-producer / single-consumer ring of interleaved float
+// frames, each with a timestamp.
+//
+// setup() allocates; write() and read() only copy, so the ring can sit
+// between the LSL pull task and a worker or the audio thread. When the ring
+// is full, write() stores what fits and reports how many frames it took.
+class FrameRing {
+public:
+    FrameRing() {}
+
+    // Capacity is rounded up to a power of two
+    bool setup(unsigned int channels, unsigned int capacity);
+
+    unsigned int getNumChannels() const { return channels; }
+    unsigned int getCapacity() const { return mask + 1; }
+
+    // Producer side
+    unsigned int getWriteAvailable() const;
+    unsigned int write(const float* data, const double* timestamps, unsigned int frames);
+
+    // Consumer side; `timestamps` may be nullptr
+    unsigned int getReadAvailable() const;
+    unsigned int read(float* data, double* timestamps, unsigned int frames);
+    void discard(unsigned int frames);
+
+private:
+    unsigned int channels = 0;
+    unsigned int mask = 0;
+    std::vector<float> data;
+    std::vector<double> timestamps;
+    // Free-running frame counters; the difference is the fill level
+    std::atomic<unsigned int> writeCount{0};
+    std::atomic<unsigned int> readCount{0};
+};
@@ -0,0 +1,348 @@
+#include "GraphNodes.h"
+#include <algorithm>
+#include <cstring>
+
+InletSourceNode::InletSourceNode(const std::string& query, unsigned int channels, double sampleRate, unsigned int maxChunkFrames)
+    : GraphNode("inlet " + query, notRealtimeSafe), query(query), channels(channels), sampleRate(sampleRate), maxChunkFrames(maxChunkFrames)
+{
+    addOutput(PortType{channels, sampleRate});
+}
+
+bool InletSourceNode::prepare(unsigned int)
+{
+    if (channels == 0 || maxChunkFrames == 0)
+        return false;
+    data.assign(maxChunkFrames * channels, 0.0f);
+    timestamps.assign(maxChunkFrames, 0.0);
+    resolver.reset(new lsl::continuous_resolver(query));
+    return true;
+}
+
+unsigned int InletSourceNode::process()
+{
+    if (!inlet) {
+        // The resolver's results allocate, so look at them twice a second
+        double now = lsl::local_clock();
+        if (now < nextResolve)
+            return 0;
+        nextResolve = now + 0.5;
+        for (const lsl::stream_info& info : resolver->results()) {
+            if ((unsigned int)info.channel_count() != channels || info.nominal_srate() != sampleRate
+                    || info.channel_format() == lsl::cf_string)
+                continue;
+            try {
+                inlet.reset(new lsl::stream_inlet(info));
+                inlet->open_stream(1.0);
+                connected = true;
+                break;
+            } catch (std::exception& e) {
+                inlet.reset();
+            }
+        }
+        if (!inlet)
+            return 0;
+    }
+
+    // Never pull more than every consumer can take, so nothing is dropped
+    // here; backpressure leaves the samples in the inlet's buffer instead
+    unsigned int space = std::min(maxChunkFrames, getWriteAvailable(0));
+    if (space == 0)
+        return 0;
+
+    try {
+        unsigned int frames = inlet->pull_chunk_multiplexed(data.data(), timestamps.data(), space * channels, space, 0.0) / channels;
+        write(0, data.data(), timestamps.data(), frames);
+        return frames;
+    } catch (lsl::lost_error& e) {
+        inlet.reset();
+        connected = false;
+        return 0;
+    }
+}
+
+OutletSinkNode::OutletSinkNode(const lsl::stream_info& info, unsigned int maxChunkFrames,
+                               unsigned int coalesceFrames, double maxLatency)
+    : GraphNode("outlet " + info.name(), notRealtimeSafe), info(info), maxChunkFrames(maxChunkFrames),
+      coalesceFrames(coalesceFrames), maxLatency(maxLatency)
+{
+    addInput(PortType{(unsigned int)info.channel_count(), info.nominal_srate()});
+}
+
+bool OutletSinkNode::prepare(unsigned int)
+{
+    if (info.channel_format() != lsl::cf_float32 || maxChunkFrames == 0)
+        return false;
+    data.assign(maxChunkFrames * info.channel_count(), 0.0f);
+    timestamps.assign(maxChunkFrames, 0.0);
+    try {
+        outlet.reset(new CoalescingOutlet(info, coalesceFrames, maxLatency));
+    } catch (std::exception& e) {
+        return false;
+    }
+    return true;
+}
+
+unsigned int OutletSinkNode::process()
+{
+    unsigned int frames = input(0)->read(data.data(), timestamps.data(), maxChunkFrames);
+    if (frames)
+        outlet->push_chunk_multiplexed(data.data(), timestamps.data(), frames * info.channel_count());
+    else
+        outlet->poll(lsl::local_clock());
+    return frames;
+}
+
+RecorderNode::RecorderNode(const std::string& path, PortType type, unsigned int maxChunkFrames)
+    : GraphNode("recorder " + path, notRealtimeSafe), path(path), maxChunkFrames(maxChunkFrames)
+{
+    addInput(type);
+}
+
+RecorderNode::~RecorderNode()
+{
+    if (file)
+        std::fclose(file);
+}
+
+bool RecorderNode::prepare(unsigned int)
+{
+    unsigned int channels = getInputType(0).channels;
+    if (maxChunkFrames == 0)
+        return false;
+    data.assign(maxChunkFrames * channels, 0.0f);
+    timestamps.assign(maxChunkFrames, 0.0);
+    record.assign(maxChunkFrames * (sizeof(double) + channels * sizeof(float)), 0);
+    file = std::fopen(path.c_str(), "ab");
+    return file != nullptr;
+}
+
+unsigned int RecorderNode::process()
+{
+    unsigned int channels = getInputType(0).channels;
+    unsigned int frames = input(0)->read(data.data(), timestamps.data(), maxChunkFrames);
+    char* p = record.data();
+    for (unsigned int f = 0; f < frames; f++) {
+        std::memcpy(p, &timestamps[f], sizeof(double));
+        p += sizeof(double);
+        std::memcpy(p, &data[f * channels], channels * sizeof(float));
+        p += channels * sizeof(float);
+    }
+    if (frames)
+        std::fwrite(record.data(), 1, p - record.data(), file);
+    return frames;
+}
+
+BiquadNode::BiquadNode(PortType type, const std::vector<BiquadBank::Stage>& stages)
+    : GraphNode("biquad", realtimeSafe), stages(stages)
+{
+    addInput(type);
+    addOutput(type);
+}
+
+bool BiquadNode::prepare(unsigned int blockFrames)
+{
+    const PortType& type = getInputType(0);
+    data.assign(blockFrames * type.channels, 0.0f);
+    timestamps.assign(blockFrames, 0.0);
+    return bank.setup(type.channels, type.sampleRate, stages, blockFrames);
+}
+
+unsigned int BiquadNode::process()
+{
+    unsigned int frames = 0;
+    while (input(0)->getReadAvailable() >= blockFrames && getWriteAvailable(0) >= blockFrames) {
+        input(0)->read(data.data(), timestamps.data(), blockFrames);
+        bank.process(data.data(), blockFrames);
+        write(0, data.data(), timestamps.data(), blockFrames);
+        frames += blockFrames;
+    }
+    return frames;
+}
+
+ResamplerNode::ResamplerNode(unsigned int channels, double inputRate, double outputRate)
+    : GraphNode("resampler", realtimeSafe), channels(channels), step(outputRate > 0.0 ? inputRate / outputRate : 0.0)
+{
+    addInput(PortType{channels, inputRate});
+    addOutput(PortType{channels, outputRate});
+}
+
+bool ResamplerNode::prepare(unsigned int blockFrames)
+{
+    if (step <= 0.0)
+        return false;
+    pending.assign(blockFrames * channels, 0.0f);
+    pendingTimestamps.assign(blockFrames, 0.0);
+    previous.assign(channels, 0.0f);
+    output.assign(blockFrames * channels, 0.0f);
+    outputTimestamps.assign(blockFrames, 0.0);
+    return true;
+}
+
+unsigned int ResamplerNode::process()
+{
+    unsigned int frames = 0;
+    for (;;) {
+        if (outputCount == blockFrames) {
+            if (getWriteAvailable(0) < blockFrames)
+                break;
+            write(0, output.data(), outputTimestamps.data(), blockFrames);
+            outputCount = 0;
+            frames += blockFrames;
+        }
+        if (pendingIndex == pendingCount) {
+            pendingCount = input(0)->read(pending.data(), pendingTimestamps.data(), blockFrames);
+            pendingIndex = 0;
+            if (pendingCount == 0)
+                break;
+        }
+
+        const float* current = &pending[pendingIndex * channels];
+        double currentTimestamp = pendingTimestamps[pendingIndex];
+        if (!primed) {
+            std::copy(current, current + channels, previous.begin());
+            previousTimestamp = currentTimestamp;
+            primed = true;
+            pendingIndex++;
+        } else if (position < 1.0) {
+            // Emit output frames until the next one falls past `current`
+            float frac = position;
+            float* out = &output[outputCount * channels];
+            for (unsigned int c = 0; c < channels; c++)
+                out[c] = previous[c] + frac * (current[c] - previous[c]);
+            outputTimestamps[outputCount] = previousTimestamp + position * (currentTimestamp - previousTimestamp);
+            outputCount++;
+            position += step;
+        } else {
+            position -= 1.0;
+            std::copy(current, current + channels, previous.begin());
+            previousTimestamp = currentTimestamp;
+            pendingIndex++;
+        }
+    }
+    return frames;
+}
+
+MixerNode::MixerNode(unsigned int inputs, PortType type)
+    : GraphNode("mixer", realtimeSafe), gains(inputs)
+{
+    for (unsigned int i = 0; i < inputs; i++) {
+        addInput(type);
+        gains[i].store(1.0f);
+    }
+    addOutput(type);
+}
+
+bool MixerNode::prepare(unsigned int blockFrames)
+{
+    unsigned int samples = blockFrames * getOutputType(0).channels;
+    block.assign(samples, 0.0f);
+    mix.assign(samples, 0.0f);
+    timestamps.assign(blockFrames, 0.0);
+    return getNumInputs() > 0;
+}
+
+unsigned int MixerNode::process()
+{
+    unsigned int frames = 0;
+    while (getWriteAvailable(0) >= blockFrames) {
+        bool any = false;
+        std::fill(mix.begin(), mix.end(), 0.0f);
+        for (unsigned int i = 0; i < getNumInputs(); i++) {
+            if (input(i)->getReadAvailable() < blockFrames)
+                continue;
+            // The first contributing input provides the timestamps
+            input(i)->read(block.data(), any ? nullptr : timestamps.data(), blockFrames);
+            float gain = gains[i].load(std::memory_order_relaxed);
+            for (unsigned int n = 0; n < mix.size(); n++)
+                mix[n] += gain * block[n];
+            any = true;
+        }
+        if (!any)
+            break;
+        write(0, mix.data(), timestamps.data(), blockFrames);
+        frames += blockFrames;
+        if (isScheduledRealtime())
+            break;
+    }
+    return frames;
+}
+
+RouterNode::RouterNode(PortType input, const std::vector<int>& map)
+    : GraphNode("router", realtimeSafe), map(map)
+{
+    addInput(input);
+    addOutput(PortType{(unsigned int)map.size(), input.sampleRate});
+}
+
+bool RouterNode::prepare(unsigned int blockFrames)
+{
+    for (int source : map)
+        if (source >= (int)getInputType(0).channels)
+            return false;
+    in.assign(blockFrames * getInputType(0).channels, 0.0f);
+    out.assign(blockFrames * map.size(), 0.0f);
+    timestamps.assign(blockFrames, 0.0);
+    return !map.empty();
+}
+
+unsigned int RouterNode::process()
+{
+    unsigned int inChannels = getInputType(0).channels;
+    unsigned int outChannels = map.size();
+    unsigned int frames = 0;
+    while (input(0)->getReadAvailable() >= blockFrames && getWriteAvailable(0) >= blockFrames) {
+        input(0)->read(in.data(), timestamps.data(), blockFrames);
+        for (unsigned int f = 0; f < blockFrames; f++)
+            for (unsigned int c = 0; c < outChannels; c++)
+                out[f * outChannels + c] = map[c] < 0 ? 0.0f : in[f * inChannels + map[c]];
+        write(0, out.data(), timestamps.data(), blockFrames);
+        frames += blockFrames;
+    }
+    return frames;
+}
+
+AudioInputNode::AudioInputNode(PortType type) : GraphNode("audio in", realtimeOnly)
+{
+    addOutput(type);
+}
+
+bool AudioInputNode::prepare(unsigned int blockFrames)
+{
+    block.assign(blockFrames * getOutputType(0).channels, 0.0f);
+    timestamps.assign(blockFrames, 0.0);
+    return getOutputType(0).sampleRate > 0.0;
+}
+
+unsigned int AudioInputNode::process()
+{
+    if (getWriteAvailable(0) < blockFrames) {
+        overruns++;
+        return 0;
+    }
+    for (unsigned int f = 0; f < blockFrames; f++)
+        timestamps[f] = blockTimestamp + f / getOutputType(0).sampleRate;
+    write(0, block.data(), timestamps.data(), blockFrames);
+    return blockFrames;
+}
+
+AudioOutputNode::AudioOutputNode(PortType type) : GraphNode("audio out", realtimeOnly)
+{
+    addInput(type);
+}
+
+bool AudioOutputNode::prepare(unsigned int blockFrames)
+{
+    block.assign(blockFrames * getInputType(0).channels, 0.0f);
+    return true;
+}
+
+unsigned int AudioOutputNode::process()
+{
+    unsigned int channels = getInputType(0).channels;
+    unsigned int frames = input(0)->read(block.data(), nullptr, blockFrames);
+    if (frames < blockFrames) {
+        std::fill(block.begin() + frames * channels, block.end(), 0.0f);
+        underruns++;
+    }
+    return frames;
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <lsl_cpp.h>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BiquadBank.h"
+#include "CoalescingOutlet.h"
+#include "ProcessingGraph.h"
+
+// Stock nodes for ProcessingGraph. Realtime-safe nodes move whole blocks
+// (blockFrames frames) and stop as soon as an input is short or an output
+// queue is full; worker nodes move whatever is available.
+
+// Pulls a float stream matching an LSL predicate, e.g. "name='audio'".
+// Streams with a different channel count or rate are ignored. The inlet is
+// created when a match appears and dropped when the stream is lost; those
+// are the only allocations after build().
+class InletSourceNode : public GraphNode {
+public:
+    InletSourceNode(const std::string& query, unsigned int channels, double sampleRate, unsigned int maxChunkFrames = 1024);
+
+    bool isConnected() const { return connected; }
+
+protected:
+    bool prepare(unsigned int blockFrames) override;
+    unsigned int process() override;
+
+private:
+    std::string query;
+    unsigned int channels;
+    double sampleRate;
+    unsigned int maxChunkFrames;
+    std::unique_ptr<lsl::continuous_resolver> resolver;
+    std::unique_ptr<lsl::stream_inlet> inlet;
+    double nextResolve = 0.0;
+    std::vector<float> data;
+    std::vector<double> timestamps;
+    std::atomic<bool> connected{false};
+};
+
+// Publishes its input on an outlet created from `info` (cf_float32, with the
+// same channel count and rate as the input), keeping the input timestamps.
+// Frames are sent in chunks of up to `coalesceFrames`, each held back at most
+// `maxLatency` seconds (see CoalescingOutlet).
+class OutletSinkNode : public GraphNode {
+public:
+    OutletSinkNode(const lsl::stream_info& info, unsigned int maxChunkFrames = 1024,
+                   unsigned int coalesceFrames = 32, double maxLatency = 0.02);
+
+protected:
+    bool prepare(unsigned int blockFrames) override;
+    unsigned int process() override;
+
+private:
+    lsl::stream_info info;
+    unsigned int maxChunkFrames;
+    unsigned int coalesceFrames;
+    double maxLatency;
+    std::unique_ptr<CoalescingOutlet> outlet;
+    std::vector<float> data;
+    std::vector<double> timestamps;
+};
+
+// Appends its input to a binary file: per frame a double timestamp followed
+// by `channels` floats, in native byte order.
+class RecorderNode : public GraphNode {
+public:
+    RecorderNode(const std::string& path, PortType type, unsigned int maxChunkFrames = 1024);
+    ~RecorderNode();
+
+protected:
+    bool prepare(unsigned int blockFrames) override;
+    unsigned int process() override;
+
+private:
+    std::string path;
+    unsigned int maxChunkFrames;
+    std::FILE* file = nullptr;
+    std::vector<float> data;
+    std::vector<double> timestamps;
+    std::vector<char> record;
+};
+
+// Runs a BiquadBank over its input
+class BiquadNode : public GraphNode {
+public:
+    BiquadNode(PortType type, const std::vector<BiquadBank::Stage>& stages);
+
+protected:
+    bool prepare(unsigned int blockFrames) override;
+    unsigned int process() override;
+
+private:
+    std::vector<BiquadBank::Stage> stages;
+    BiquadBank bank;
+    std::vector<float> data;
+    std::vector<double> timestamps;
+};
+
+// Linear-interpolating sample rate converter; timestamps are interpolated
+// along with the samples
+class ResamplerNode : public GraphNode {
+public:
+    ResamplerNode(unsigned int channels, double inputRate, double outputRate);
+
+protected:
+    bool prepare(unsigned int blockFrames) override;
+    unsigned int process() override;
+
+private:
+    unsigned int channels;
+    double step; // input frames per output frame
+    double position = 0.0; // between previous and current input frame
+    bool primed = false;
+    std::vector<float> pending;
+    std::vector<double> pendingTimestamps;
+    unsigned int pendingCount = 0;
+    unsigned int pendingIndex = 0;
+    std::vector<float> previous;
+    double previousTimestamp = 0.0;
+    std::vector<float> output;
+    std::vector<double> outputTimestamps;
+    unsigned int outputCount = 0;
+};
+
+// Sums `inputs` inputs of the same type, each with its own gain. An input
+// without a full block is silent for that block, so a stalled source does
+// not stall the mix. On the realtime schedule it makes at most one block per
+// call, the block render() plays, so a burst on one input waits in that
+// input's queue rather than piling up ahead of the audio output. Gains may
+// be changed from any thread.
+class MixerNode : public GraphNode {
+public:
+    MixerNode(unsigned int inputs, PortType type);
+
+    void setGain(unsigned int input, float gain) { gains[input].store(gain, std::memory_order_relaxed); }
+
+protected:
+    bool prepare(unsigned int blockFrames) override;
+    unsigned int process() override;
+
+private:
+    std::vector<std::atomic<float>> gains;
+    std::vector<float> block;
+    std::vector<float> mix;
+    std::vector<double> timestamps;
+};
+
+// Selects and reorders channels: output channel k carries input channel
+// map[k], or silence when map[k] is negative
+class RouterNode : public GraphNode {
+public:
+    RouterNode(PortType input, const std::vector<int>& map);
+
+protected:
+    bool prepare(unsigned int blockFrames) override;
+    unsigned int process() override;
+
+private:
+    std::vector<int> map;
+    std::vector<float> in;
+    std::vector<float> out;
+    std::vector<double> timestamps;
+};
+
+// Bridges render() into the graph: fill getBlock() with a block of
+// interleaved input frames, set its timestamp, then call processRealtime().
+class AudioInputNode : public GraphNode {
+public:
+    explicit AudioInputNode(PortType type);
+
+    float* getBlock() { return block.data(); }
+    void setTimestamp(double timestamp) { blockTimestamp = timestamp; }
+    unsigned long getOverruns() const { return overruns; }
+
+protected:
+    bool prepare(unsigned int blockFrames) override;
+    unsigned int process() override;
+
+private:
+    std::vector<float> block;
+    std::vector<double> timestamps;
+    double blockTimestamp = 0.0;
+    unsigned long overruns = 0;
+};
+
+// Bridges the graph into render(): after processRealtime(), getBlock() holds
+// one block of interleaved frames, zero-padded when the input ran short.
+class AudioOutputNode : public GraphNode {
+public:
+    explicit AudioOutputNode(PortType type);
+
+    const float* getBlock() const { return block.data(); }
+    unsigned long getUnderruns() const { return underruns; }
+
+protected:
+    bool prepare(unsigned int blockFrames) override;
+    unsigned int process() override;
+
+private:
+    std::vector<float> block;
+    unsigned long underruns = 0;
+};
@@ -0,0 +1,107 @@
+#include "InletWaiter.h"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+// Weight of the newest gap in the arrival-interval estimate
+static const double kIntervalSmoothing = 0.25;
+static const double kMaxInterval = 1.0;
+// Look again this far into the expected interval, to be there when it ends
+static const double kEarlyCheck = 0.8;
+
+bool InletWaiter::setup(unsigned int maxInlets, const Settings& settings)
+{
+    if (maxInlets == 0 || settings.minSleep <= 0.0 || settings.maxSleep < settings.minSleep)
+        return false;
+    this->settings = settings;
+    this->maxInlets = maxInlets;
+    entries.reset(new Entry[maxInlets]);
+    return true;
+}
+
+void InletWaiter::watch(unsigned int n, lsl::stream_inlet* inlet, double sampleRate)
+{
+    Entry& entry = entries[n];
+    double now = lsl::local_clock();
+    entry.inlet = inlet;
+    entry.interval = sampleRate > 0.0 ? 1.0 / sampleRate : settings.irregularInterval;
+    entry.interval = std::min(std::max(entry.interval, settings.minSleep), kMaxInterval);
+    entry.lastArrival = now;
+    entry.lastReady = now;
+    entry.nextCheck = now;
+    entry.backoff = 0.0;
+    entry.ready = false;
+}
+
+void InletWaiter::unwatch(unsigned int n)
+{
+    entries[n] = Entry();
+}
+
+unsigned int InletWaiter::check(double now)
+{
+    unsigned int ready = 0;
+    for (unsigned int n = 0; n < maxInlets; n++) {
+        Entry& entry = entries[n];
+        entry.ready = false;
+        if (!entry.inlet)
+            continue;
+        if (entry.inlet->samples_available() > 0) {
+            double gap = std::min(now - entry.lastArrival, kMaxInterval);
+            entry.interval += kIntervalSmoothing * (gap - entry.interval);
+            entry.interval = std::max(entry.interval, settings.minSleep);
+            entry.lastArrival = now;
+            entry.nextCheck = now + kEarlyCheck * entry.interval;
+            entry.backoff = 0.0;
+            entry.ready = true;
+        } else {
+            if (now >= entry.nextCheck) {
+                entry.backoff = entry.backoff > 0.0 ? std::min(entry.backoff * 2.0, settings.maxSleep) : settings.minSleep;
+                entry.nextCheck = now + entry.backoff;
+            }
+            entry.ready = now - entry.lastReady >= settings.maxIdle;
+        }
+        if (entry.ready) {
+            entry.lastReady = now;
+            ready++;
+        }
+    }
+    return ready;
+}
+
+double InletWaiter::getNextExpected() const
+{
+    double next = INFINITY;
+    for (unsigned int n = 0; n < maxInlets; n++) {
+        const Entry& entry = entries[n];
+        if (entry.inlet)
+            next = std::min(next, std::min(entry.nextCheck, entry.lastReady + settings.maxIdle));
+    }
+    return next;
+}
+
+void InletWaiter::sleep(double seconds)
+{
+    struct timespec duration;
+    duration.tv_sec = (time_t)seconds;
+    duration.tv_nsec = (long)((seconds - duration.tv_sec) * 1e9);
+    nanosleep(&duration, nullptr);
+}
+
+unsigned int InletWaiter::wait(double timeout)
+{
+    double now = lsl::local_clock();
+    double deadline = now + timeout;
+    unsigned int ready = check(now);
+    while (ready == 0 && now < deadline) {
+        // Sleep until some stream is worth checking again
+        double duration = std::min(std::max(getNextExpected() - now, settings.minSleep), settings.maxSleep);
+        sleep(std::min(duration, deadline - now));
+
+        now = lsl::local_clock();
+        ready = check(now);
+        wakeups++;
+        emptyWakeups += ready == 0;
+    }
+    return ready;
+}
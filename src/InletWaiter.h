@@ -0,0 +1,69 @@
+#pragma once
+
+#include <lsl_cpp.h>
+#include <memory>
+
+// Waits for any of many inlets to have samples, so one worker can serve
+// them all without polling each in turn.
+//
+// wait() checks samples_available() on every watched inlet and returns as
+// soon as one has data. Between checks it sleeps until the earliest time
+// any stream is worth looking at again. That is shortly before the stream
+// is next expected to deliver: its last arrival plus its usual interval
+// between arrivals, learnt as it runs and seeded from the nominal rate.
+// Once that time has passed with nothing there, the stream's checks back
+// off exponentially from minSleep to maxSleep, so a stalled stream does not
+// keep the waiter busy. An inlet that has not been reported for maxIdle
+// seconds is reported anyway, so the caller still pulls it now and then and
+// notices when it is lost.
+//
+// Everything runs on the caller's task; setup() allocates, nothing else does.
+class InletWaiter {
+public:
+    struct Settings {
+        double minSleep = 0.0005;
+        double maxSleep = 0.01;
+        double maxIdle = 0.5;
+        double irregularInterval = 0.1; // first guess for irregular streams
+    };
+
+    InletWaiter() {}
+
+    bool setup(unsigned int maxInlets) { return setup(maxInlets, Settings()); }
+    bool setup(unsigned int maxInlets, const Settings& settings);
+
+    // Watch `inlet` as number n; `sampleRate` is its nominal rate
+    void watch(unsigned int n, lsl::stream_inlet* inlet, double sampleRate);
+    void unwatch(unsigned int n);
+    bool isWatched(unsigned int n) const { return entries[n].inlet != nullptr; }
+
+    // Block until an inlet is ready or `timeout` seconds pass. Returns the
+    // number of ready inlets; isReady() tells which.
+    unsigned int wait(double timeout);
+    bool isReady(unsigned int n) const { return entries[n].ready; }
+
+    // How often wait() woke up, and how often for nothing
+    unsigned long getWakeups() const { return wakeups; }
+    unsigned long getEmptyWakeups() const { return emptyWakeups; }
+
+private:
+    struct Entry {
+        lsl::stream_inlet* inlet = nullptr;
+        double interval = 0.0;    // smoothed time between arrivals
+        double lastArrival = 0.0;
+        double lastReady = 0.0;
+        double nextCheck = 0.0;
+        double backoff = 0.0;     // 0 until the stream is overdue
+        bool ready = false;
+    };
+
+    unsigned int check(double now);
+    double getNextExpected() const;
+    static void sleep(double seconds);
+
+    Settings settings;
+    unsigned int maxInlets = 0;
+    std::unique_ptr<Entry[]> entries;
+    unsigned long wakeups = 0;
+    unsigned long emptyWakeups = 0;
+};
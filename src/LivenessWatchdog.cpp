@@ -0,0 +1,172 @@
+#include "LivenessWatchdog.h"
+#include <algorithm>
+
+bool LivenessWatchdog::setup(unsigned int maxStreams, const Settings& settings)
+{
+    if (maxStreams == 0 || settings.tick <= 0.0 || settings.timeoutPeriods <= 0.0)
+        return false;
+    this->settings = settings;
+    this->maxStreams = maxStreams;
+    entries.reset(new Entry[maxStreams]);
+    std::fill(heads, heads + kLevels * kSlots, kNone);
+    current = 0;
+    started = false;
+    stalls = 0;
+    return true;
+}
+
+void LivenessWatchdog::watch(unsigned int n, double sampleRate, double now)
+{
+    if (!started) {
+        current = toTick(now);
+        started = true;
+    }
+    unwatch(n);
+    Entry& entry = entries[n];
+    entry.watched = true;
+    entry.timeout = sampleRate > 0.0 ? std::max(settings.timeoutPeriods / sampleRate, settings.minTimeout)
+                                     : settings.irregularTimeout;
+    entry.lastData = now;
+    if (entry.timeout > 0.0)
+        schedule(n, now + entry.timeout);
+}
+
+void LivenessWatchdog::unwatch(unsigned int n)
+{
+    unlink(n);
+    entries[n] = Entry();
+}
+
+void LivenessWatchdog::arrived(unsigned int n, double now)
+{
+    Entry& entry = entries[n];
+    if (!entry.watched)
+        return;
+    double silence = now - entry.lastData;
+    entry.lastData = now;
+    // Otherwise the deadline already set moves on when it comes up
+    if (!entry.stalled)
+        return;
+    entry.stalled = false;
+    unlink(n);
+    if (entry.timeout > 0.0)
+        schedule(n, now + entry.timeout);
+    if (listener)
+        listener(n, resumed, silence);
+}
+
+void LivenessWatchdog::advance(double now)
+{
+    if (!started)
+        return;
+    uint64_t target = toTick(now);
+    while (current < target) {
+        current++;
+        // Spread the coarser slots that start here over the finer levels
+        if ((current & (kSlots - 1)) == 0) {
+            if (((current >> kBits) & (kSlots - 1)) == 0)
+                cascade(2);
+            cascade(1);
+        }
+        // fire() may move on or remove any entry, so take them one at a time
+        int& head = heads[current & (kSlots - 1)];
+        while (head != kNone) {
+            unsigned int n = head;
+            unlink(n);
+            fire(n, now);
+        }
+    }
+}
+
+uint64_t LivenessWatchdog::toTick(double time) const
+{
+    return time > 0.0 ? (uint64_t)(time / settings.tick) : 0;
+}
+
+void LivenessWatchdog::schedule(unsigned int n, double time)
+{
+    // Round up, so a deadline never fires early
+    insert(n, std::max(toTick(time) + 1, current + 1));
+}
+
+void LivenessWatchdog::insert(unsigned int n, uint64_t deadline)
+{
+    // The finest level whose current revolution holds the deadline. The top
+    // level takes anything in its next kSlots slots; later deadlines wait
+    // in its furthest slot and are moved on from there when it comes up.
+    unsigned int level;
+    if ((deadline >> kBits) == (current >> kBits)) {
+        level = 0;
+    } else if ((deadline >> (2 * kBits)) == (current >> (2 * kBits))) {
+        level = 1;
+    } else {
+        level = 2;
+        if ((deadline >> (2 * kBits)) - (current >> (2 * kBits)) >= kSlots)
+            deadline = ((current >> (2 * kBits)) + kSlots - 1) << (2 * kBits);
+    }
+    Entry& entry = entries[n];
+    entry.deadline = deadline;
+    entry.slot = level * kSlots + ((deadline >> (level * kBits)) & (kSlots - 1));
+    entry.previous = kNone;
+    entry.next = heads[entry.slot];
+    if (entry.next != kNone)
+        entries[entry.next].previous = n;
+    heads[entry.slot] = n;
+}
+
+void LivenessWatchdog::unlink(unsigned int n)
+{
+    Entry& entry = entries[n];
+    if (entry.slot == kNone)
+        return;
+    if (entry.previous != kNone)
+        entries[entry.previous].next = entry.next;
+    else
+        heads[entry.slot] = entry.next;
+    if (entry.next != kNone)
+        entries[entry.next].previous = entry.previous;
+    entry.slot = kNone;
+    entry.previous = kNone;
+    entry.next = kNone;
+}
+
+void LivenessWatchdog::cascade(unsigned int level)
+{
+    int& head = heads[level * kSlots + ((current >> (level * kBits)) & (kSlots - 1))];
+    int n = head;
+    head = kNone;
+    while (n != kNone) {
+        int next = entries[n].next;
+        entries[n].slot = kNone;
+        insert(n, entries[n].deadline);
+        n = next;
+    }
+}
+
+void LivenessWatchdog::fire(unsigned int n, double now)
+{
+    Entry& entry = entries[n];
+    double silence = now - entry.lastData;
+    Event event;
+    if (!entry.stalled) {
+        // Data came in since this deadline was set
+        if (silence < entry.timeout) {
+            schedule(n, entry.lastData + entry.timeout);
+            return;
+        }
+        entry.stalled = true;
+        stalls++;
+        event = stalled;
+    } else {
+        if (silence < entry.timeout + settings.expireAfter) {
+            schedule(n, entry.lastData + entry.timeout + settings.expireAfter);
+            return;
+        }
+        event = expired;
+    }
+    // Wait for expiry next; reschedule before the listener can unwatch
+    if (event == stalled && settings.expireAfter > 0.0)
+        schedule(n, entry.lastData + entry.timeout + settings.expireAfter);
+    if (listener)
+        listener(n, event, silence);
+}
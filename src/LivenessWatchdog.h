@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+// Notices when a stream stops delivering data without being lost (the
+// sender paused, the network stalled), and when it comes back.
+//
+// Each watched stream has a timeout: timeoutPeriods sample periods at its
+// nominal rate, at least minTimeout, or irregularTimeout for irregular
+// streams (0 to never time them out). A stream that delivers nothing for
+// its timeout is reported stalled, one that delivers again after that
+// resumed, and one that stays stalled for expireAfter seconds expired,
+// which is the caller's cue to reconnect or fail over.
+//
+// Deadlines sit in a hierarchical timer wheel of kLevels levels of kSlots
+// slots, the first level `tick` seconds per slot, each next one kSlots
+// times coarser. advance() walks the ticks that have passed and only looks
+// at the streams whose deadline falls in them; a coarser slot is spread
+// over the finer ones when the wheel reaches it. arrived() just records the
+// time, and a stream whose deadline comes up after fresh data is moved on
+// to its new deadline then, so the cost per stream is constant however
+// many are watched, and nothing scans them all.
+//
+// Everything runs on the caller's task, including the listener; setup()
+// allocates, nothing else does.
+class LivenessWatchdog {
+public:
+    enum Event {
+        stalled,
+        resumed,
+        expired,
+    };
+
+    struct Settings {
+        double tick = 0.01;           // s per slot of the finest level
+        double timeoutPeriods = 20.0; // sample periods of silence before a stall
+        double minTimeout = 0.25;     // s
+        double irregularTimeout = 0.0; // s, 0 to never time out irregular streams
+        double expireAfter = 10.0;    // s stalled before expiry, 0 for never
+    };
+
+    // `silence` is how long the stream had delivered nothing
+    typedef std::function<void(unsigned int stream, Event event, double silence)> Listener;
+
+    LivenessWatchdog() {}
+
+    bool setup(unsigned int maxStreams) { return setup(maxStreams, Settings()); }
+    bool setup(unsigned int maxStreams, const Settings& settings);
+    void setListener(const Listener& listener) { this->listener = listener; }
+
+    // Times are in seconds on any steady clock, the same for every call.
+    // `sampleRate` is the stream's nominal rate, 0 for irregular streams.
+    void watch(unsigned int n, double sampleRate, double now);
+    void unwatch(unsigned int n);
+    bool isWatched(unsigned int n) const { return entries[n].watched; }
+
+    // The stream delivered data at `now`
+    void arrived(unsigned int n, double now);
+    // Fire the deadlines up to `now`
+    void advance(double now);
+
+    bool isStalled(unsigned int n) const { return entries[n].stalled; }
+    unsigned long getStalls() const { return stalls; }
+
+private:
+    static constexpr unsigned int kBits = 6;
+    static constexpr unsigned int kSlots = 1 << kBits;
+    static constexpr unsigned int kLevels = 3;
+    static constexpr int kNone = -1;
+
+    struct Entry {
+        bool watched = false;
+        bool stalled = false;
+        double timeout = 0.0;   // 0: never
+        double lastData = 0.0;
+        uint64_t deadline = 0;  // in ticks
+        int slot = kNone;       // level * kSlots + index, or kNone
+        int previous = kNone;
+        int next = kNone;
+    };
+
+    uint64_t toTick(double time) const;
+    void schedule(unsigned int n, double time);
+    void insert(unsigned int n, uint64_t deadline);
+    void unlink(unsigned int n);
+    void cascade(unsigned int level);
+    void fire(unsigned int n, double now);
+
+    Settings settings;
+    unsigned int maxStreams = 0;
+    std::unique_ptr<Entry[]> entries;
+    int heads[kLevels * kSlots];
+    uint64_t current = 0; // the last tick advanced to
+    bool started = false;
+    Listener listener;
+    unsigned long stalls = 0;
+};
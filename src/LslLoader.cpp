@@ -0,0 +1,292 @@
+#include "LslLoader.h"
+#include <lsl_c.h>
+#include <atomic>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <dlfcn.h>
+#include <unistd.h>
+
+// Every function of the C API, as (return type, name, parameters, arguments)
+#define LSL_FUNCTIONS \
+    /* lsl/common.h */ \
+    LSL_FUNCTION(const char*, lsl_last_error, (void), ()) \
+    LSL_FUNCTION(int32_t, lsl_protocol_version, (), ()) \
+    LSL_FUNCTION(int32_t, lsl_library_version, (), ()) \
+    LSL_FUNCTION(const char*, lsl_library_info, (void), ()) \
+    LSL_FUNCTION(double, lsl_local_clock, (), ()) \
+    LSL_FUNCTION(void, lsl_destroy_string, (char *s), (s)) \
+    /* lsl/streaminfo.h */ \
+    LSL_FUNCTION(lsl_streaminfo, lsl_create_streaminfo, (const char *name, const char *type, int32_t channel_count, double nominal_srate, lsl_channel_format_t channel_format, const char *source_id), (name, type, channel_count, nominal_srate, channel_format, source_id)) \
+    LSL_FUNCTION(void, lsl_destroy_streaminfo, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(lsl_streaminfo, lsl_copy_streaminfo, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(const char*, lsl_get_name, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(const char*, lsl_get_type, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(int32_t, lsl_get_channel_count, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(double, lsl_get_nominal_srate, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(lsl_channel_format_t, lsl_get_channel_format, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(const char*, lsl_get_source_id, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(int32_t, lsl_get_version, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(double, lsl_get_created_at, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(const char*, lsl_get_uid, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(const char*, lsl_get_session_id, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(const char*, lsl_get_hostname, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_get_desc, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(char*, lsl_get_xml, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(int32_t, lsl_get_channel_bytes, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(int32_t, lsl_get_sample_bytes, (lsl_streaminfo info), (info)) \
+    LSL_FUNCTION(int32_t, lsl_stream_info_matches_query, (lsl_streaminfo info, const char *query), (info, query)) \
+    LSL_FUNCTION(lsl_streaminfo, lsl_streaminfo_from_xml, (const char *xml), (xml)) \
+    /* lsl/xml.h */ \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_first_child, (lsl_xml_ptr e), (e)) \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_last_child, (lsl_xml_ptr e), (e)) \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_next_sibling, (lsl_xml_ptr e), (e)) \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_previous_sibling, (lsl_xml_ptr e), (e)) \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_parent, (lsl_xml_ptr e), (e)) \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_child, (lsl_xml_ptr e, const char *name), (e, name)) \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_next_sibling_n, (lsl_xml_ptr e, const char *name), (e, name)) \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_previous_sibling_n, (lsl_xml_ptr e, const char *name), (e, name)) \
+    LSL_FUNCTION(int32_t, lsl_empty, (lsl_xml_ptr e), (e)) \
+    LSL_FUNCTION(int32_t, lsl_is_text, (lsl_xml_ptr e), (e)) \
+    LSL_FUNCTION(const char*, lsl_name, (lsl_xml_ptr e), (e)) \
+    LSL_FUNCTION(const char*, lsl_value, (lsl_xml_ptr e), (e)) \
+    LSL_FUNCTION(const char*, lsl_child_value, (lsl_xml_ptr e), (e)) \
+    LSL_FUNCTION(const char*, lsl_child_value_n, (lsl_xml_ptr e, const char *name), (e, name)) \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_append_child_value, (lsl_xml_ptr e, const char *name, const char *value), (e, name, value)) \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_prepend_child_value, (lsl_xml_ptr e, const char *name, const char *value), (e, name, value)) \
+    LSL_FUNCTION(int32_t, lsl_set_child_value, (lsl_xml_ptr e, const char *name, const char *value), (e, name, value)) \
+    LSL_FUNCTION(int32_t, lsl_set_name, (lsl_xml_ptr e, const char *rhs), (e, rhs)) \
+    LSL_FUNCTION(int32_t, lsl_set_value, (lsl_xml_ptr e, const char *rhs), (e, rhs)) \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_append_child, (lsl_xml_ptr e, const char *name), (e, name)) \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_prepend_child, (lsl_xml_ptr e, const char *name), (e, name)) \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_append_copy, (lsl_xml_ptr e, lsl_xml_ptr e2), (e, e2)) \
+    LSL_FUNCTION(lsl_xml_ptr, lsl_prepend_copy, (lsl_xml_ptr e, lsl_xml_ptr e2), (e, e2)) \
+    LSL_FUNCTION(void, lsl_remove_child_n, (lsl_xml_ptr e, const char *name), (e, name)) \
+    LSL_FUNCTION(void, lsl_remove_child, (lsl_xml_ptr e, lsl_xml_ptr e2), (e, e2)) \
+    /* lsl/outlet.h */ \
+    LSL_FUNCTION(lsl_outlet, lsl_create_outlet, (lsl_streaminfo info, int32_t chunk_size, int32_t max_buffered), (info, chunk_size, max_buffered)) \
+    LSL_FUNCTION(lsl_outlet, lsl_create_outlet_ex, (lsl_streaminfo info, int32_t chunk_size, int32_t max_buffered, lsl_transport_options_t flags), (info, chunk_size, max_buffered, flags)) \
+    LSL_FUNCTION(void, lsl_destroy_outlet, (lsl_outlet out), (out)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_f, (lsl_outlet out, const float *data), (out, data)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_d, (lsl_outlet out, const double *data), (out, data)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_l, (lsl_outlet out, const int64_t *data), (out, data)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_i, (lsl_outlet out, const int32_t *data), (out, data)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_s, (lsl_outlet out, const int16_t *data), (out, data)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_c, (lsl_outlet out, const char *data), (out, data)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_str, (lsl_outlet out, const char **data), (out, data)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_v, (lsl_outlet out, const void *data), (out, data)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_ft, (lsl_outlet out, const float *data, double timestamp), (out, data, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_dt, (lsl_outlet out, const double *data, double timestamp), (out, data, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_lt, (lsl_outlet out, const int64_t *data, double timestamp), (out, data, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_it, (lsl_outlet out, const int32_t *data, double timestamp), (out, data, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_st, (lsl_outlet out, const int16_t *data, double timestamp), (out, data, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_ct, (lsl_outlet out, const char *data, double timestamp), (out, data, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_strt, (lsl_outlet out, const char **data, double timestamp), (out, data, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_vt, (lsl_outlet out, const void *data, double timestamp), (out, data, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_ftp, (lsl_outlet out, const float *data, double timestamp, int32_t pushthrough), (out, data, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_dtp, (lsl_outlet out, const double *data, double timestamp, int32_t pushthrough), (out, data, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_ltp, (lsl_outlet out, const int64_t *data, double timestamp, int32_t pushthrough), (out, data, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_itp, (lsl_outlet out, const int32_t *data, double timestamp, int32_t pushthrough), (out, data, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_stp, (lsl_outlet out, const int16_t *data, double timestamp, int32_t pushthrough), (out, data, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_ctp, (lsl_outlet out, const char *data, double timestamp, int32_t pushthrough), (out, data, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_strtp, (lsl_outlet out, const char **data, double timestamp, int32_t pushthrough), (out, data, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_vtp, (lsl_outlet out, const void *data, double timestamp, int32_t pushthrough), (out, data, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_buf, (lsl_outlet out, const char **data, const uint32_t *lengths), (out, data, lengths)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_buft, (lsl_outlet out, const char **data, const uint32_t *lengths, double timestamp), (out, data, lengths, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_sample_buftp, (lsl_outlet out, const char **data, const uint32_t *lengths, double timestamp, int32_t pushthrough), (out, data, lengths, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_f, (lsl_outlet out, const float *data, unsigned long data_elements), (out, data, data_elements)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_d, (lsl_outlet out, const double *data, unsigned long data_elements), (out, data, data_elements)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_l, (lsl_outlet out, const int64_t *data, unsigned long data_elements), (out, data, data_elements)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_i, (lsl_outlet out, const int32_t *data, unsigned long data_elements), (out, data, data_elements)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_s, (lsl_outlet out, const int16_t *data, unsigned long data_elements), (out, data, data_elements)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_c, (lsl_outlet out, const char *data, unsigned long data_elements), (out, data, data_elements)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_str, (lsl_outlet out, const char **data, unsigned long data_elements), (out, data, data_elements)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_ft, (lsl_outlet out, const float *data, unsigned long data_elements, double timestamp), (out, data, data_elements, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_dt, (lsl_outlet out, const double *data, unsigned long data_elements, double timestamp), (out, data, data_elements, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_lt, (lsl_outlet out, const int64_t *data, unsigned long data_elements, double timestamp), (out, data, data_elements, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_it, (lsl_outlet out, const int32_t *data, unsigned long data_elements, double timestamp), (out, data, data_elements, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_st, (lsl_outlet out, const int16_t *data, unsigned long data_elements, double timestamp), (out, data, data_elements, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_ct, (lsl_outlet out, const char *data, unsigned long data_elements, double timestamp), (out, data, data_elements, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_strt, (lsl_outlet out, const char **data, unsigned long data_elements, double timestamp), (out, data, data_elements, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_ftp, (lsl_outlet out, const float *data, unsigned long data_elements, double timestamp, int32_t pushthrough), (out, data, data_elements, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_dtp, (lsl_outlet out, const double *data, unsigned long data_elements, double timestamp, int32_t pushthrough), (out, data, data_elements, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_ltp, (lsl_outlet out, const int64_t *data, unsigned long data_elements, double timestamp, int32_t pushthrough), (out, data, data_elements, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_itp, (lsl_outlet out, const int32_t *data, unsigned long data_elements, double timestamp, int32_t pushthrough), (out, data, data_elements, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_stp, (lsl_outlet out, const int16_t *data, unsigned long data_elements, double timestamp, int32_t pushthrough), (out, data, data_elements, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_ctp, (lsl_outlet out, const char *data, unsigned long data_elements, double timestamp, int32_t pushthrough), (out, data, data_elements, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_strtp, (lsl_outlet out, const char **data, unsigned long data_elements, double timestamp, int32_t pushthrough), (out, data, data_elements, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_ftn, (lsl_outlet out, const float *data, unsigned long data_elements, const double *timestamps), (out, data, data_elements, timestamps)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_dtn, (lsl_outlet out, const double *data, unsigned long data_elements, const double *timestamps), (out, data, data_elements, timestamps)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_ltn, (lsl_outlet out, const int64_t *data, unsigned long data_elements, const double *timestamps), (out, data, data_elements, timestamps)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_itn, (lsl_outlet out, const int32_t *data, unsigned long data_elements, const double *timestamps), (out, data, data_elements, timestamps)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_stn, (lsl_outlet out, const int16_t *data, unsigned long data_elements, const double *timestamps), (out, data, data_elements, timestamps)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_ctn, (lsl_outlet out, const char *data, unsigned long data_elements, const double *timestamps), (out, data, data_elements, timestamps)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_strtn, (lsl_outlet out, const char **data, unsigned long data_elements, const double *timestamps), (out, data, data_elements, timestamps)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_ftnp, (lsl_outlet out, const float *data, unsigned long data_elements, const double *timestamps, int32_t pushthrough), (out, data, data_elements, timestamps, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_dtnp, (lsl_outlet out, const double *data, unsigned long data_elements, const double *timestamps, int32_t pushthrough), (out, data, data_elements, timestamps, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_ltnp, (lsl_outlet out, const int64_t *data, unsigned long data_elements, const double *timestamps, int32_t pushthrough), (out, data, data_elements, timestamps, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_itnp, (lsl_outlet out, const int32_t *data, unsigned long data_elements, const double *timestamps, int32_t pushthrough), (out, data, data_elements, timestamps, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_stnp, (lsl_outlet out, const int16_t *data, unsigned long data_elements, const double *timestamps, int32_t pushthrough), (out, data, data_elements, timestamps, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_ctnp, (lsl_outlet out, const char *data, unsigned long data_elements, const double *timestamps, int32_t pushthrough), (out, data, data_elements, timestamps, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_strtnp, (lsl_outlet out, const char **data, unsigned long data_elements, const double *timestamps, int32_t pushthrough), (out, data, data_elements, timestamps, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_buf, (lsl_outlet out, const char **data, const uint32_t *lengths, unsigned long data_elements), (out, data, lengths, data_elements)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_buft, (lsl_outlet out, const char **data, const uint32_t *lengths, unsigned long data_elements, double timestamp), (out, data, lengths, data_elements, timestamp)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_buftp, (lsl_outlet out, const char **data, const uint32_t *lengths, unsigned long data_elements, double timestamp, int32_t pushthrough), (out, data, lengths, data_elements, timestamp, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_buftn, (lsl_outlet out, const char **data, const uint32_t *lengths, unsigned long data_elements, const double *timestamps), (out, data, lengths, data_elements, timestamps)) \
+    LSL_FUNCTION(int32_t, lsl_push_chunk_buftnp, (lsl_outlet out, const char **data, const uint32_t *lengths, unsigned long data_elements, const double *timestamps, int32_t pushthrough), (out, data, lengths, data_elements, timestamps, pushthrough)) \
+    LSL_FUNCTION(int32_t, lsl_have_consumers, (lsl_outlet out), (out)) \
+    LSL_FUNCTION(int32_t, lsl_wait_for_consumers, (lsl_outlet out, double timeout), (out, timeout)) \
+    LSL_FUNCTION(lsl_streaminfo, lsl_get_info, (lsl_outlet out), (out)) \
+    /* lsl/inlet.h */ \
+    LSL_FUNCTION(lsl_inlet, lsl_create_inlet, (lsl_streaminfo info, int32_t max_buflen, int32_t max_chunklen, int32_t recover), (info, max_buflen, max_chunklen, recover)) \
+    LSL_FUNCTION(lsl_inlet, lsl_create_inlet_ex, (lsl_streaminfo info, int32_t max_buflen, int32_t max_chunklen, int32_t recover, lsl_transport_options_t flags), (info, max_buflen, max_chunklen, recover, flags)) \
+    LSL_FUNCTION(void, lsl_destroy_inlet, (lsl_inlet in), (in)) \
+    LSL_FUNCTION(lsl_streaminfo, lsl_get_fullinfo, (lsl_inlet in, double timeout, int32_t *ec), (in, timeout, ec)) \
+    LSL_FUNCTION(void, lsl_open_stream, (lsl_inlet in, double timeout, int32_t *ec), (in, timeout, ec)) \
+    LSL_FUNCTION(void, lsl_close_stream, (lsl_inlet in), (in)) \
+    LSL_FUNCTION(double, lsl_time_correction, (lsl_inlet in, double timeout, int32_t *ec), (in, timeout, ec)) \
+    LSL_FUNCTION(double, lsl_time_correction_ex, (lsl_inlet in, double *remote_time, double *uncertainty, double timeout, int32_t *ec), (in, remote_time, uncertainty, timeout, ec)) \
+    LSL_FUNCTION(int32_t, lsl_set_postprocessing, (lsl_inlet in, uint32_t flags), (in, flags)) \
+    LSL_FUNCTION(double, lsl_pull_sample_f, (lsl_inlet in, float *buffer, int32_t buffer_elements, double timeout, int32_t *ec), (in, buffer, buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(double, lsl_pull_sample_d, (lsl_inlet in, double *buffer, int32_t buffer_elements, double timeout, int32_t *ec), (in, buffer, buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(double, lsl_pull_sample_l, (lsl_inlet in, int64_t *buffer, int32_t buffer_elements, double timeout, int32_t *ec), (in, buffer, buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(double, lsl_pull_sample_i, (lsl_inlet in, int32_t *buffer, int32_t buffer_elements, double timeout, int32_t *ec), (in, buffer, buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(double, lsl_pull_sample_s, (lsl_inlet in, int16_t *buffer, int32_t buffer_elements, double timeout, int32_t *ec), (in, buffer, buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(double, lsl_pull_sample_c, (lsl_inlet in, char *buffer, int32_t buffer_elements, double timeout, int32_t *ec), (in, buffer, buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(double, lsl_pull_sample_str, (lsl_inlet in, char **buffer, int32_t buffer_elements, double timeout, int32_t *ec), (in, buffer, buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(double, lsl_pull_sample_buf, (lsl_inlet in, char **buffer, uint32_t *buffer_lengths, int32_t buffer_elements, double timeout, int32_t *ec), (in, buffer, buffer_lengths, buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(double, lsl_pull_sample_v, (lsl_inlet in, void *buffer, int32_t buffer_bytes, double timeout, int32_t *ec), (in, buffer, buffer_bytes, timeout, ec)) \
+    LSL_FUNCTION(unsigned long, lsl_pull_chunk_f, (lsl_inlet in, float *data_buffer, double *timestamp_buffer, unsigned long data_buffer_elements, unsigned long timestamp_buffer_elements, double timeout, int32_t *ec), (in, data_buffer, timestamp_buffer, data_buffer_elements, timestamp_buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(unsigned long, lsl_pull_chunk_d, (lsl_inlet in, double *data_buffer, double *timestamp_buffer, unsigned long data_buffer_elements, unsigned long timestamp_buffer_elements, double timeout, int32_t *ec), (in, data_buffer, timestamp_buffer, data_buffer_elements, timestamp_buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(unsigned long, lsl_pull_chunk_l, (lsl_inlet in, int64_t *data_buffer, double *timestamp_buffer, unsigned long data_buffer_elements, unsigned long timestamp_buffer_elements, double timeout, int32_t *ec), (in, data_buffer, timestamp_buffer, data_buffer_elements, timestamp_buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(unsigned long, lsl_pull_chunk_i, (lsl_inlet in, int32_t *data_buffer, double *timestamp_buffer, unsigned long data_buffer_elements, unsigned long timestamp_buffer_elements, double timeout, int32_t *ec), (in, data_buffer, timestamp_buffer, data_buffer_elements, timestamp_buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(unsigned long, lsl_pull_chunk_s, (lsl_inlet in, int16_t *data_buffer, double *timestamp_buffer, unsigned long data_buffer_elements, unsigned long timestamp_buffer_elements, double timeout, int32_t *ec), (in, data_buffer, timestamp_buffer, data_buffer_elements, timestamp_buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(unsigned long, lsl_pull_chunk_c, (lsl_inlet in, char *data_buffer, double *timestamp_buffer, unsigned long data_buffer_elements, unsigned long timestamp_buffer_elements, double timeout, int32_t *ec), (in, data_buffer, timestamp_buffer, data_buffer_elements, timestamp_buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(unsigned long, lsl_pull_chunk_str, (lsl_inlet in, char **data_buffer, double *timestamp_buffer, unsigned long data_buffer_elements, unsigned long timestamp_buffer_elements, double timeout, int32_t *ec), (in, data_buffer, timestamp_buffer, data_buffer_elements, timestamp_buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(unsigned long, lsl_pull_chunk_buf, (lsl_inlet in, char **data_buffer, uint32_t *lengths_buffer, double *timestamp_buffer, unsigned long data_buffer_elements, unsigned long timestamp_buffer_elements, double timeout, int32_t *ec), (in, data_buffer, lengths_buffer, timestamp_buffer, data_buffer_elements, timestamp_buffer_elements, timeout, ec)) \
+    LSL_FUNCTION(uint32_t, lsl_samples_available, (lsl_inlet in), (in)) \
+    LSL_FUNCTION(uint32_t, lsl_inlet_flush, (lsl_inlet in), (in)) \
+    LSL_FUNCTION(uint32_t, lsl_was_clock_reset, (lsl_inlet in), (in)) \
+    LSL_FUNCTION(int32_t, lsl_smoothing_halftime, (lsl_inlet in, float value), (in, value)) \
+    /* lsl/resolver.h */ \
+    LSL_FUNCTION(lsl_continuous_resolver, lsl_create_continuous_resolver, (double forget_after), (forget_after)) \
+    LSL_FUNCTION(lsl_continuous_resolver, lsl_create_continuous_resolver_byprop, (const char *prop, const char *value, double forget_after), (prop, value, forget_after)) \
+    LSL_FUNCTION(lsl_continuous_resolver, lsl_create_continuous_resolver_bypred, (const char *pred, double forget_after), (pred, forget_after)) \
+    LSL_FUNCTION(int32_t, lsl_resolver_results, (lsl_continuous_resolver res, lsl_streaminfo *buffer, uint32_t buffer_elements), (res, buffer, buffer_elements)) \
+    LSL_FUNCTION(void, lsl_destroy_continuous_resolver, (lsl_continuous_resolver res), (res)) \
+    LSL_FUNCTION(int32_t, lsl_resolve_all, (lsl_streaminfo *buffer, uint32_t buffer_elements, double wait_time), (buffer, buffer_elements, wait_time)) \
+    LSL_FUNCTION(int32_t, lsl_resolve_byprop, (lsl_streaminfo *buffer, uint32_t buffer_elements, const char *prop, const char *value, int32_t minimum, double timeout), (buffer, buffer_elements, prop, value, minimum, timeout)) \
+    LSL_FUNCTION(int32_t, lsl_resolve_bypred, (lsl_streaminfo *buffer, uint32_t buffer_elements, const char *pred, int32_t minimum, double timeout), (buffer, buffer_elements, pred, minimum, timeout)) \
+
+struct LslFunctions {
+#define LSL_FUNCTION(ret, name, params, args) decltype(&::name) name = nullptr;
+    LSL_FUNCTIONS
+#undef LSL_FUNCTION
+};
+
+static LslFunctions gFunctions;
+static void* gLibrary = nullptr; // open for the life of the process
+static std::atomic<bool> gLoaded{false};
+static std::mutex gLoadMutex;
+static char gError[256] = "liblsl not loaded yet";
+
+// lib/liblsl.so in the directory of the running executable
+static std::string getBundledPath()
+{
+    char exe[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (length <= 0)
+        return "";
+    std::string path(exe, length);
+    return path.substr(0, path.rfind('/') + 1) + "lib/liblsl.so";
+}
+
+static void* openLibrary(const char* path)
+{
+    // DEEPBIND keeps liblsl's calls to its own API inside the library rather
+    // than binding them to the shims below
+    void* library = dlopen(path, RTLD_NOW | RTLD_LOCAL | RTLD_DEEPBIND);
+    if (!library)
+        snprintf(gError, sizeof(gError), "%s", dlerror());
+    return library;
+}
+
+static bool checkVersion()
+{
+    // Protocol and library versions are major * 100 + minor
+    const int32_t header = LIBLSL_COMPILE_HEADER_VERSION;
+    if (!gFunctions.lsl_library_version || !gFunctions.lsl_protocol_version) {
+        snprintf(gError, sizeof(gError), "not a liblsl library");
+        return false;
+    }
+    int32_t library = gFunctions.lsl_library_version();
+    int32_t protocol = gFunctions.lsl_protocol_version();
+    if (library / 100 != header / 100 || protocol / 100 != header / 100) {
+        snprintf(gError, sizeof(gError), "liblsl %d (protocol %d) does not match the headers' version %d",
+                 library, protocol, header);
+        return false;
+    }
+    return true;
+}
+
+bool loadLsl(const char* path)
+{
+    std::lock_guard<std::mutex> lock(gLoadMutex);
+    if (gLoaded.load(std::memory_order_relaxed))
+        return true;
+
+    std::string candidates[] = {path ? path : "", getenv("LSL_LIBRARY") ? getenv("LSL_LIBRARY") : "", "liblsl.so", getBundledPath()};
+    void* library = nullptr;
+    for (const auto& candidate : candidates) {
+        if (!candidate.empty() && (library = openLibrary(candidate.c_str())))
+            break;
+    }
+    if (!library)
+        return false;
+
+    // Missing functions stay null and throw when called
+#define LSL_FUNCTION(ret, name, params, args) gFunctions.name = (decltype(gFunctions.name))dlsym(library, #name);
+    LSL_FUNCTIONS
+#undef LSL_FUNCTION
+
+    if (!checkVersion()) {
+        gFunctions = LslFunctions();
+        dlclose(library);
+        return false;
+    }
+    gLibrary = library;
+    gLoaded.store(true, std::memory_order_release);
+    return true;
+}
+
+bool isLslLoaded()
+{
+    return gLoaded.load(std::memory_order_acquire);
+}
+
+const char* getLslLoadError()
+{
+    return gError;
+}
+
+template <typename Function>
+static Function resolve(const Function& function, const char* name)
+{
+    if (!gLoaded.load(std::memory_order_acquire) && !loadLsl())
+        throw std::runtime_error(std::string("Could not load liblsl: ") + getLslLoadError());
+    if (!function)
+        throw std::runtime_error(std::string("liblsl lacks ") + name);
+    return function;
+}
+
+// The shims. Once loaded, each is one well-predicted check and an indirect
+// call. gFunctions is read only after the load, so it needs no locking.
+extern "C" {
+#define LSL_FUNCTION(ret, name, params, args) \
+    ret name params { return resolve(gFunctions.name, #name) args; }
+    LSL_FUNCTIONS
+#undef LSL_FUNCTION
+}
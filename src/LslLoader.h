@@ -0,0 +1,26 @@
+#pragma once
+
+// Loads liblsl at run time instead of linking it.
+//
+// LslLoader.cpp defines every lsl_* function of lsl_c.h as a shim that calls
+// through a table of function pointers, so lsl_cpp.h and direct C calls work
+// unchanged with the sketch linked against -ldl only. The library is opened
+// with dlopen() on the first call - or earlier with loadLsl(), which lets
+// setup() report a missing or incompatible library instead of the process
+// failing before it starts. Every symbol is resolved once, when the library
+// is opened.
+//
+// The library is looked for, in order, at `path`, at $LSL_LIBRARY, as
+// liblsl.so on the loader's search path, and at lib/liblsl.so next to the
+// executable (where a Bela project keeps it). It must speak the protocol and
+// library major version of the bundled headers.
+//
+// A shim called when the library cannot be loaded, or lacks that function,
+// throws std::runtime_error.
+
+// Returns false if no compatible liblsl could be loaded. Safe to call more
+// than once and from any thread; only the first successful call loads.
+bool loadLsl(const char* path = nullptr);
+bool isLslLoaded();
+// Why the last load failed
+const char* getLslLoadError();
@@ -0,0 +1,97 @@
+#include "MemoryBudget.h"
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <sys/sysinfo.h>
+
+// Each queued sample is a separate liblsl object with a header (reference
+// count, timestamp, flags, queue link) ahead of its values
+static const std::size_t kSampleOverhead = 64;
+// Strings are std::string objects plus their text
+static const std::size_t kStringBytes = 48;
+// liblsl buffers irregular streams as if they ran at 100 Hz
+static const double kIrregularRate = 100.0;
+
+constexpr double MemoryBudget::kMinSeconds;
+
+std::size_t MemoryBudget::getAvailableRam()
+{
+    // freeram leaves out the page cache, which on a board that has been up
+    // a while is most of the RAM the kernel would hand over
+    FILE* meminfo = fopen("/proc/meminfo", "r");
+    if (meminfo) {
+        char line[128];
+        unsigned long long kb;
+        bool found = false;
+        while (!found && fgets(line, sizeof(line), meminfo))
+            found = sscanf(line, "MemAvailable: %llu kB", &kb) == 1;
+        fclose(meminfo);
+        if (found)
+            return std::min<unsigned long long>(kb * 1024, std::numeric_limits<std::size_t>::max());
+    }
+    // Kernels before 3.14 have no MemAvailable
+    struct sysinfo info;
+    if (sysinfo(&info) != 0)
+        return 0;
+    return ((std::size_t)info.freeram + info.bufferram) * info.mem_unit;
+}
+
+std::size_t MemoryBudget::getSampleBytes(const lsl::stream_info& info)
+{
+    return getSampleBytes(info.channel_count(), info.channel_format());
+}
+
+std::size_t MemoryBudget::getSampleBytes(unsigned int channels, lsl::channel_format_t format)
+{
+    std::size_t valueBytes;
+    switch (format) {
+    case lsl::cf_string: valueBytes = kStringBytes; break;
+    case lsl::cf_double64:
+    case lsl::cf_int64: valueBytes = 8; break;
+    case lsl::cf_int16: valueBytes = 2; break;
+    case lsl::cf_int8: valueBytes = 1; break;
+    default: valueBytes = 4; break;
+    }
+    return kSampleOverhead + channels * valueBytes;
+}
+
+bool MemoryBudget::setup(double fraction, std::size_t maxBytes)
+{
+    budget = getAvailableRam() * fraction;
+    if (maxBytes > 0)
+        budget = std::min(budget, maxBytes);
+    reserved = 0;
+    return budget > 0;
+}
+
+MemoryBudget::Grant MemoryBudget::reserve(const lsl::stream_info& info, Role role)
+{
+    return reserve(info.channel_count(), info.channel_format(), info.nominal_srate(), role);
+}
+
+MemoryBudget::Grant MemoryBudget::reserve(unsigned int channels, lsl::channel_format_t format, double sampleRate, Role role)
+{
+    Grant grant;
+    double rate = sampleRate > 0.0 ? sampleRate : kIrregularRate;
+    std::size_t sampleBytes = getSampleBytes(channels, format);
+    std::size_t wanted = std::max(1.0, rate * roleSeconds[role]);
+    std::size_t least = std::max(1.0, rate * std::min(kMinSeconds, roleSeconds[role]));
+
+    std::size_t current = reserved.load(std::memory_order_relaxed);
+    std::size_t samples;
+    do {
+        std::size_t left = budget > current ? budget - current : 0;
+        samples = std::min(wanted, left / sampleBytes);
+        if (samples < least)
+            return grant;
+    } while (!reserved.compare_exchange_weak(current, current + samples * sampleBytes));
+
+    grant.samples = samples;
+    grant.bytes = samples * sampleBytes;
+    return grant;
+}
+
+void MemoryBudget::release(const Grant& grant)
+{
+    reserved.fetch_sub(grant.bytes, std::memory_order_relaxed);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <lsl_cpp.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Sizes inlet and outlet buffers from the RAM the board actually has.
+//
+// liblsl's default buffer is 360 s per stream: for 8 channels of float audio
+// at 44.1 kHz that is over 500 MB, the whole RAM of a BeagleBone. setup()
+// takes a fraction of the RAM available at the time (MemAvailable in
+// /proc/meminfo, which counts the page cache the kernel can reclaim) as the
+// budget for all stream buffers together. reserve() then grants each stream
+// the buffer its role needs - a few seconds for streams consumed in real
+// time, more for ones that may be read in bursts - shrunk to what is left of
+// the budget, and refuses the stream rather than overcommit. Grants are in
+// samples, for inlets and outlets created with transp_bufsize_samples.
+// Outlets that build their own stream_info are reserved for by channel
+// count, format and rate before they are opened.
+//
+// reserve() and release() may be called from different threads.
+class MemoryBudget {
+public:
+    enum Role {
+        realtime,    // consumed as it arrives (audio, control)
+        interactive, // pulled in chunks, may lag a little
+        recording,   // may be read in long bursts
+        kNumRoles
+    };
+
+    struct Grant {
+        int32_t samples = 0;
+        std::size_t bytes = 0;
+        explicit operator bool() const { return samples > 0; }
+    };
+
+    MemoryBudget() {}
+
+    // Budget `fraction` of the RAM free now, capped at maxBytes if nonzero
+    bool setup(double fraction = 0.25, std::size_t maxBytes = 0);
+
+    // Seconds of buffer wanted per role (defaults 2, 10 and 60)
+    void setRoleSeconds(Role role, double seconds) { roleSeconds[role] = seconds; }
+
+    // A buffer of up to the role's seconds for `info`. Empty if less than
+    // kMinSeconds of it fits in what is left.
+    Grant reserve(const lsl::stream_info& info, Role role);
+    Grant reserve(unsigned int channels, lsl::channel_format_t format, double sampleRate, Role role);
+    void release(const Grant& grant);
+
+    std::size_t getBudget() const { return budget; }
+    std::size_t getReserved() const { return reserved.load(std::memory_order_relaxed); }
+
+    // RAM held per buffered sample of the stream, including liblsl's
+    // per-sample bookkeeping
+    static std::size_t getSampleBytes(const lsl::stream_info& info);
+    static std::size_t getSampleBytes(unsigned int channels, lsl::channel_format_t format);
+    // RAM available without swapping, in bytes: the kernel's MemAvailable
+    // estimate, or free plus buffer RAM from sysinfo on kernels without it
+    static std::size_t getAvailableRam();
+
+    static constexpr double kMinSeconds = 0.5;
+
+private:
+    std::size_t budget = 0;
+    std::atomic<std::size_t> reserved{0};
+    double roleSeconds[kNumRoles] = {2.0, 10.0, 60.0};
+};
@@ -0,0 +1,86 @@
+#include "OverloadPolicy.h"
+#include <algorithm>
+#include <cstring>
+
+bool OverloadPolicy::setup(double sampleRate, unsigned int channels, const Settings& settings)
+{
+    if (sampleRate <= 0.0 || channels == 0 || settings.recoverLatency > settings.maxLatency
+        || settings.decimation == 0)
+        return false;
+    this->settings = settings;
+    this->sampleRate = sampleRate;
+    this->channels = channels;
+    engaged = false;
+    phase = 0;
+    counters = Counters();
+    return true;
+}
+
+unsigned int OverloadPolicy::admit(lsl::stream_inlet& inlet, float* scratch, double* timestamps, unsigned int scratchFrames)
+{
+    size_t queued = inlet.samples_available();
+    double latency = queued / sampleRate;
+    counters.peakLatency = std::max(counters.peakLatency, latency);
+    if (!engaged && latency > settings.maxLatency) {
+        engaged = true;
+        counters.engagements++;
+    } else if (engaged && latency < settings.recoverLatency) {
+        engaged = false;
+    }
+    if (!engaged || (settings.mode != dropOldest && settings.mode != keepLatest))
+        return 0;
+
+    size_t keep = settings.mode == keepLatest ? 1 : (size_t)(settings.recoverLatency * sampleRate);
+    if (queued <= keep)
+        return 0;
+    unsigned int dropped = 0;
+    if (keep == 0) {
+        dropped = inlet.flush();
+    } else {
+        // Pull the excess through the scratch buffers; more may arrive
+        // meanwhile, which stays queued for the next pull
+        size_t excess = queued - keep;
+        while (excess > 0) {
+            size_t frames = std::min(excess, (size_t)scratchFrames);
+            size_t pulled = inlet.pull_chunk_multiplexed(scratch, timestamps, frames * channels, frames, 0.0) / channels;
+            if (pulled == 0)
+                break;
+            excess -= pulled;
+            dropped += pulled;
+        }
+    }
+    counters.dropped += dropped;
+    if (dropped > 0)
+        engaged = false;
+    return dropped;
+}
+
+unsigned int OverloadPolicy::thin(float* data, double* timestamps, unsigned int frames)
+{
+    if (!engaged || frames == 0)
+        return frames;
+    if (settings.mode == keepLatest && frames > 1) {
+        std::memcpy(data, data + (frames - 1) * channels, channels * sizeof(float));
+        timestamps[0] = timestamps[frames - 1];
+        counters.skipped += frames - 1;
+        return 1;
+    }
+    if (settings.mode != decimate)
+        return frames;
+
+    // Keep every decimation-th frame, continuing the count across chunks
+    unsigned int kept = 0;
+    for (unsigned int f = 0; f < frames; f++) {
+        if (phase == 0) {
+            if (kept != f) {
+                std::memcpy(data + kept * channels, data + f * channels, channels * sizeof(float));
+                timestamps[kept] = timestamps[f];
+            }
+            kept++;
+        }
+        if (++phase == settings.decimation)
+            phase = 0;
+    }
+    counters.skipped += frames - kept;
+    return kept;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <lsl_cpp.h>
+
+// Keeps the latency of a stream bounded when its consumer falls behind.
+//
+// Before each pull, admit() measures what is queued in the inlet, in
+// seconds at the stream's nominal rate. The policy engages once that
+// exceeds maxLatency and lets go once it falls below recoverLatency, so a
+// backlog hovering around the limit does not toggle it every pull. While
+// engaged it applies its mode:
+//   - keepAll:    nothing; the stream is only measured
+//   - dropOldest: discard the oldest samples, leaving recoverLatency queued
+//   - keepLatest: discard all but the newest sample, and pass on only the
+//                 newest frame of each pulled chunk
+//   - decimate:   pull everything but pass on one frame in `decimation`,
+//                 so whatever consumes the frames catches up
+// Audio wants dropOldest (a short gap rather than ever-growing delay),
+// control values keepLatest, and streams that are only displayed decimate.
+//
+// Samples are discarded with lsl_inlet_flush() when nothing is to be kept,
+// and otherwise by pulling them through the caller's scratch buffers, since
+// liblsl cannot skip part of its queue. Irregular streams have no rate to
+// measure against, so they are never dropped. Nothing allocates.
+class OverloadPolicy {
+public:
+    enum Mode {
+        keepAll,
+        dropOldest,
+        keepLatest,
+        decimate,
+    };
+
+    struct Settings {
+        Mode mode = keepAll;
+        double maxLatency = 0.1;      // s queued before the policy engages
+        double recoverLatency = 0.02; // s queued at which it lets go
+        unsigned int decimation = 4;  // decimate: one frame passed on in this many
+    };
+
+    struct Counters {
+        unsigned long engagements = 0; // times the backlog went over maxLatency
+        unsigned long dropped = 0;     // samples discarded from the inlet
+        unsigned long skipped = 0;     // pulled frames not passed on
+        double peakLatency = 0.0;      // longest backlog seen, s
+    };
+
+    OverloadPolicy() {}
+
+    // Returns false for irregular streams
+    bool setup(double sampleRate, unsigned int channels) { return setup(sampleRate, channels, Settings()); }
+    bool setup(double sampleRate, unsigned int channels, const Settings& settings);
+
+    // Measure the inlet's backlog and drop from it if the mode says so,
+    // using `scratchFrames` frames of scratch buffers. Returns the number of
+    // samples dropped. Throws what the inlet's pull throws.
+    unsigned int admit(lsl::stream_inlet& inlet, float* scratch, double* timestamps, unsigned int scratchFrames);
+    // Thin out a pulled chunk in place; returns the frames left to pass on
+    unsigned int thin(float* data, double* timestamps, unsigned int frames);
+
+    bool isEngaged() const { return engaged; }
+    Mode getMode() const { return settings.mode; }
+    const Counters& getCounters() const { return counters; }
+    void clearCounters() { counters = Counters(); }
+
+private:
+    Settings settings;
+    double sampleRate = 0.0;
+    unsigned int channels = 0;
+    bool engaged = false;
+    unsigned int phase = 0; // decimate: frames since the last one passed on
+    Counters counters;
+};
@@ -0,0 +1,123 @@
+#include "ProcessingGraph.h"
+#include <algorithm>
+#include <chrono>
+
+unsigned int GraphNode::getWriteAvailable(unsigned int port) const
+{
+    unsigned int frames = ~0u;
+    for (const FrameRing* queue : outputs[port])
+        frames = std::min(frames, queue->getWriteAvailable());
+    return frames;
+}
+
+void GraphNode::write(unsigned int port, const float* data, const double* timestamps, unsigned int frames)
+{
+    for (FrameRing* queue : outputs[port])
+        queue->write(data, timestamps, frames);
+}
+
+bool ProcessingGraph::fail(const std::string& message)
+{
+    error = message;
+    return false;
+}
+
+bool ProcessingGraph::connect(GraphNode* from, unsigned int output, GraphNode* to, unsigned int input, unsigned int capacity)
+{
+    if (built)
+        return fail("graph is already built");
+    if (output >= from->getNumOutputs() || input >= to->getNumInputs())
+        return fail(from->getName() + " -> " + to->getName() + ": no such port");
+    const PortType& a = from->getOutputType(output);
+    const PortType& b = to->getInputType(input);
+    if (a.channels != b.channels || a.sampleRate != b.sampleRate)
+        return fail(from->getName() + " -> " + to->getName() + ": port types differ");
+    for (const Edge& edge : edges)
+        if (edge.to == to && edge.input == input)
+            return fail(to->getName() + ": input already connected");
+    edges.push_back(Edge{from, output, to, input, capacity});
+    return true;
+}
+
+bool ProcessingGraph::build(unsigned int blockFrames)
+{
+    if (built)
+        return fail("graph is already built");
+    if (blockFrames == 0)
+        return fail("block size must be positive");
+
+    for (auto& node : nodes)
+        for (unsigned int i = 0; i < node->getNumInputs(); i++)
+            if (std::none_of(edges.begin(), edges.end(), [&](const Edge& e) { return e.to == node.get() && e.input == i; }))
+                return fail(node->getName() + ": input " + std::to_string(i) + " is not connected");
+
+    // Kahn's algorithm; producers are always processed before consumers
+    std::vector<GraphNode*> order;
+    std::vector<unsigned int> pending(nodes.size(), 0);
+    auto indexOf = [&](const GraphNode* node) {
+        for (unsigned int n = 0; n < nodes.size(); n++)
+            if (nodes[n].get() == node)
+                return n;
+        return (unsigned int)nodes.size();
+    };
+    for (const Edge& edge : edges) {
+        if (indexOf(edge.from) == nodes.size() || indexOf(edge.to) == nodes.size())
+            return fail("edge refers to a node from another graph");
+        pending[indexOf(edge.to)]++;
+    }
+    for (unsigned int n = 0; n < nodes.size(); n++)
+        if (pending[n] == 0)
+            order.push_back(nodes[n].get());
+    for (unsigned int k = 0; k < order.size(); k++)
+        for (const Edge& edge : edges)
+            if (edge.from == order[k] && --pending[indexOf(edge.to)] == 0)
+                order.push_back(edge.to);
+    if (order.size() != nodes.size())
+        return fail("graph contains a cycle");
+
+    // RT-safe nodes join the realtime schedule when they feed a node that is
+    // on it, so audio paths never wait for the worker
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        GraphNode* node = *it;
+        node->scheduledRealtime = node->getRtSafety() == GraphNode::realtimeOnly;
+        if (node->getRtSafety() == GraphNode::realtimeSafe)
+            for (const Edge& edge : edges)
+                if (edge.from == node && edge.to->scheduledRealtime)
+                    node->scheduledRealtime = true;
+    }
+
+    for (const Edge& edge : edges) {
+        unsigned int capacity = edge.capacity ? edge.capacity : std::max(8 * blockFrames, 2048u);
+        std::unique_ptr<FrameRing> queue(new FrameRing);
+        if (!queue->setup(edge.from->getOutputType(edge.output).channels, capacity))
+            return fail(edge.from->getName() + ": cannot allocate queue");
+        edge.from->outputs[edge.output].push_back(queue.get());
+        edge.to->inputs[edge.input] = queue.get();
+        queues.push_back(std::move(queue));
+    }
+
+    for (GraphNode* node : order) {
+        node->blockFrames = blockFrames;
+        if (!node->prepare(blockFrames))
+            return fail(node->getName() + ": prepare failed");
+        (node->scheduledRealtime ? realtimeSchedule : workerSchedule).push_back(node);
+    }
+    built = true;
+    return true;
+}
+
+void ProcessingGraph::run(const std::vector<GraphNode*>& schedule)
+{
+    typedef std::chrono::steady_clock Clock;
+    for (GraphNode* node : schedule) {
+        Clock::time_point start = Clock::now();
+        unsigned int frames = node->process();
+        double elapsed = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+        GraphNode::Stats& stats = node->stats;
+        stats.calls++;
+        stats.frames += frames;
+        stats.totalMicroseconds += elapsed;
+        stats.maxMicroseconds = std::max(stats.maxMicroseconds, elapsed);
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "FrameRing.h"
+
+// A small dataflow runtime for LSL inlets, outlets and processing stages.
+//
+// Nodes are connected port to port by FrameRings (lock-free SPSC queues of
+// timestamped frames). Every port has a type: a channel count and a sample
+// rate, checked when connecting. build() orders the nodes, allocates every
+// queue and calls each node's prepare(), after which processing is
+// allocation-free.
+//
+// Each node carries an RT-safety annotation. build() splits the nodes into
+// two schedules:
+//   - processRealtime(), called from render(), runs nodes that must be on the
+//     audio thread and RT-safe nodes that feed them
+//   - processWorker(), called from an auxiliary task, runs everything that
+//     may block (network, disk) and RT-safe nodes with no realtime consumer
+// Queues crossing between the two schedules need no extra synchronisation.
+//
+// Per-node timing is collected in both schedules, see getStats().
+class ProcessingGraph;
+
+struct PortType {
+    unsigned int channels;
+    double sampleRate; // 0 for irregular streams
+};
+
+class GraphNode {
+public:
+    enum RtSafety {
+        realtimeOnly,    // must run on the audio thread (audio I/O)
+        realtimeSafe,    // never blocks or allocates in process()
+        notRealtimeSafe, // may block: network or file I/O
+    };
+
+    struct Stats {
+        unsigned long calls = 0;
+        unsigned long frames = 0;
+        double totalMicroseconds = 0.0;
+        double maxMicroseconds = 0.0;
+    };
+
+    GraphNode(const std::string& name, RtSafety safety) : name(name), safety(safety) {}
+    virtual ~GraphNode() {}
+
+    const std::string& getName() const { return name; }
+    RtSafety getRtSafety() const { return safety; }
+    unsigned int getNumInputs() const { return inputTypes.size(); }
+    unsigned int getNumOutputs() const { return outputTypes.size(); }
+    const PortType& getInputType(unsigned int port) const { return inputTypes[port]; }
+    const PortType& getOutputType(unsigned int port) const { return outputTypes[port]; }
+    // Updated by the thread that runs the node; read it for diagnostics only
+    const Stats& getStats() const { return stats; }
+
+protected:
+    friend class ProcessingGraph;
+
+    void addInput(PortType type) { inputTypes.push_back(type); inputs.push_back(nullptr); }
+    void addOutput(PortType type) { outputTypes.push_back(type); outputs.emplace_back(); }
+
+    // Allocate everything the node needs; called once by build()
+    virtual bool prepare(unsigned int /* blockFrames */) { return true; }
+    // Consume and produce whatever is possible now; returns frames produced
+    virtual unsigned int process() = 0;
+
+    FrameRing* input(unsigned int port) { return inputs[port]; }
+    // Frames that fit on every queue attached to an output
+    unsigned int getWriteAvailable(unsigned int port) const;
+    // Write to every queue attached to an output (fan-out)
+    void write(unsigned int port, const float* data, const double* timestamps, unsigned int frames);
+    // Whether build() put the node on the realtime schedule; set before prepare()
+    bool isScheduledRealtime() const { return scheduledRealtime; }
+
+    unsigned int blockFrames = 0;
+
+private:
+    std::string name;
+    RtSafety safety;
+    std::vector<PortType> inputTypes;
+    std::vector<PortType> outputTypes;
+    std::vector<FrameRing*> inputs;
+    std::vector<std::vector<FrameRing*>> outputs;
+    Stats stats;
+    bool scheduledRealtime = false;
+};
+
+class ProcessingGraph {
+public:
+    ProcessingGraph() {}
+
+    // Create a node owned by the graph
+    template <class T, class... Args> T* add(Args&&... args)
+    {
+        T* node = new T(std::forward<Args>(args)...);
+        nodes.emplace_back(node);
+        return node;
+    }
+
+    // Connect an output port to an input port through a queue of at least
+    // `capacity` frames (default: 8 blocks, at least 2048 frames).
+    // Returns false if the port types differ or the input is taken.
+    bool connect(GraphNode* from, unsigned int output, GraphNode* to, unsigned int input, unsigned int capacity = 0);
+
+    // Order the nodes, allocate the queues, prepare the nodes and split them
+    // into the realtime and worker schedules
+    bool build(unsigned int blockFrames);
+
+    void processRealtime() { run(realtimeSchedule); }
+    void processWorker() { run(workerSchedule); }
+
+    bool isRealtime(const GraphNode* node) const { return node->scheduledRealtime; }
+    unsigned int getNumNodes() const { return nodes.size(); }
+    const GraphNode* getNode(unsigned int n) const { return nodes[n].get(); }
+    const std::string& getError() const { return error; }
+
+private:
+    struct Edge {
+        GraphNode* from;
+        unsigned int output;
+        GraphNode* to;
+        unsigned int input;
+        unsigned int capacity;
+    };
+
+    void run(const std::vector<GraphNode*>& schedule);
+    bool fail(const std::string& message);
+
+    std::vector<std::unique_ptr<GraphNode>> nodes;
+    std::vector<Edge> edges;
+    std::vector<std::unique_ptr<FrameRing>> queues;
+    std::vector<GraphNode*> realtimeSchedule;
+    std::vector<GraphNode*> workerSchedule;
+    std::string error;
+    bool built = false;
+};
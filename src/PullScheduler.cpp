@@ -0,0 +1,111 @@
+#include "PullScheduler.h"
+#include <algorithm>
+#include <cmath>
+
+// Rounds of quanta a stream held back by its time budget may bank
+static const double kMaxBankedRounds = 4.0;
+// Frames earned per second of round time, relative to the stream's rate
+static const double kHeadroom = 1.5;
+static const double kMaxRoundTime = 0.1;
+
+bool PullScheduler::setup(unsigned int maxStreams, unsigned int maxChunk, const Settings& settings)
+{
+    if (maxStreams == 0 || maxChunk == 0)
+        return false;
+    this->settings = settings;
+    this->maxChunk = maxChunk;
+    streams.reset(new Stream[maxStreams]);
+    for (auto& list : members) {
+        list.clear();
+        list.reserve(maxStreams);
+    }
+    return true;
+}
+
+void PullScheduler::add(unsigned int n, Priority priority, double sampleRate)
+{
+    Stream& stream = streams[n];
+    if (stream.added)
+        remove(n);
+    stream = Stream();
+    stream.added = true;
+    stream.priority = priority;
+    stream.rate = std::max(sampleRate, 0.0);
+    stream.quantum = sampleRate > 0.0 ? std::max(1.0, std::ceil(sampleRate * settings.latency[priority])) : maxChunk;
+    members[priority].push_back(n);
+}
+
+void PullScheduler::remove(unsigned int n)
+{
+    Stream& stream = streams[n];
+    if (!stream.added)
+        return;
+    auto& list = members[stream.priority];
+    list.erase(std::find(list.begin(), list.end(), n));
+    stream = Stream();
+}
+
+void PullScheduler::beginRound(double now)
+{
+    double elapsed = std::min(std::max(now - lastRound, 0.0), kMaxRoundTime);
+    lastRound = now;
+    for (unsigned int p = 0; p < kNumPriorities; p++) {
+        for (unsigned int n : members[p]) {
+            Stream& stream = streams[n];
+            stream.time = 0.0;
+            if (stream.ready) {
+                double quantum = std::max(stream.quantum, std::ceil(stream.rate * elapsed * kHeadroom));
+                stream.deficit = std::min(stream.deficit + quantum, quantum * kMaxBankedRounds);
+                stream.done = false;
+            } else {
+                stream.deficit = 0.0;
+                stream.done = true;
+            }
+        }
+        classTime[p] = 0.0;
+        if (!members[p].empty())
+            first[p] = (first[p] + 1) % members[p].size();
+    }
+    current = 0;
+    position = 0;
+}
+
+int PullScheduler::next(unsigned int& maxFrames)
+{
+    for (; current < kNumPriorities; current++, position = 0) {
+        const auto& list = members[current];
+        bool outOfTime = classTime[current] >= settings.classTime[current];
+        for (; position < list.size(); position++) {
+            unsigned int n = list[(first[current] + position) % list.size()];
+            Stream& stream = streams[n];
+            if (stream.done)
+                continue;
+            if (outOfTime) {
+                stream.done = true;
+                deferrals[current]++;
+                continue;
+            }
+            maxFrames = std::min((unsigned int)stream.deficit, maxChunk);
+            return n;
+        }
+    }
+    return -1;
+}
+
+void PullScheduler::complete(unsigned int n, unsigned int frames, bool drained, double seconds)
+{
+    Stream& stream = streams[n];
+    stream.deficit = std::max(stream.deficit - frames, 0.0);
+    stream.time += seconds;
+    classTime[stream.priority] += seconds;
+    if (drained) {
+        // An empty stream forfeits the rest of its quantum
+        stream.deficit = 0.0;
+        stream.done = true;
+    } else if (stream.deficit < 1.0) {
+        stream.done = true;
+    } else if (stream.time >= settings.streamTime[stream.priority]) {
+        stream.done = true;
+        deferrals[stream.priority]++;
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+// Decides which stream the pull worker serves next, and how much of it, so
+// a bursty high-rate stream cannot starve latency-critical ones.
+//
+// Streams belong to a priority class: critical (audio, control), events
+// (markers) and bulk (everything else). Each round serves the classes in
+// that order, and the streams within a class by deficit round-robin: every
+// round a ready stream earns a quantum of frames - its rate times its
+// class's latency target, or times the time since the last round with some
+// headroom if that was longer - and is pulled, at most maxChunk frames at a
+// time, until the frames are spent or it runs dry. Irregular streams
+// (markers) earn maxChunk frames a round, enough for any burst. A stream
+// that runs dry forfeits what is left; one that still has data keeps it for
+// the next round. Each stream also has a time budget per round, and the
+// bulk class as a whole a time budget per round, so a backlog of bulk data
+// is worked off over several rounds rather than in one long one. The
+// class's first stream rotates every round.
+//
+// Usage per round: setReady() for each stream, beginRound(now), then
+//   while ((n = next(maxFrames)) >= 0) { pull up to maxFrames; complete(...); }
+//
+// Everything runs on the pull task; setup() allocates, nothing else does.
+class PullScheduler {
+public:
+    enum Priority {
+        critical,
+        events,
+        bulk,
+        kNumPriorities
+    };
+
+    struct Settings {
+        double latency[kNumPriorities] = {0.005, 0.01, 0.05};      // s of samples per quantum
+        double streamTime[kNumPriorities] = {0.002, 0.001, 0.001}; // s per stream per round
+        double classTime[kNumPriorities] = {1.0, 1.0, 0.004};      // s per class per round
+    };
+
+    PullScheduler() {}
+
+    bool setup(unsigned int maxStreams, unsigned int maxChunk) { return setup(maxStreams, maxChunk, Settings()); }
+    bool setup(unsigned int maxStreams, unsigned int maxChunk, const Settings& settings);
+
+    void add(unsigned int n, Priority priority, double sampleRate);
+    void remove(unsigned int n);
+    bool isAdded(unsigned int n) const { return streams[n].added; }
+
+    // Whether the stream has anything to pull this round
+    void setReady(unsigned int n, bool ready) { streams[n].ready = ready; }
+    // `now` in seconds on any steady clock
+    void beginRound(double now);
+    // The stream to pull next and the most frames to take, or -1 when the
+    // round is over
+    int next(unsigned int& maxFrames);
+    // What the last pull from `n` took; `drained` if it emptied the stream
+    void complete(unsigned int n, unsigned int frames, bool drained, double seconds);
+
+    // Times a stream with data left was put off to the next round
+    unsigned long getDeferrals(Priority priority) const { return deferrals[priority]; }
+
+private:
+    struct Stream {
+        bool added = false;
+        bool ready = false;
+        bool done = true;
+        Priority priority = bulk;
+        double rate = 0.0;
+        double quantum = 0.0;
+        double deficit = 0.0;
+        double time = 0.0;
+    };
+
+    Settings settings;
+    unsigned int maxChunk = 0;
+    std::unique_ptr<Stream[]> streams;
+    std::vector<unsigned int> members[kNumPriorities];
+    unsigned int first[kNumPriorities] = {};  // rotates every round
+    double classTime[kNumPriorities] = {};    // spent this round
+    double lastRound = 0.0;
+    unsigned int current = 0;                 // class being served
+    unsigned int position = 0;                // within the class, from first
+    unsigned long deferrals[kNumPriorities] = {};
+};
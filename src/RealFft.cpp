@@ -0,0 +1,138 @@
+#include "RealFft.h"
+#include <cmath>
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+bool RealFft::setup(unsigned int size)
+{
+    if (size < 4 || (size & (size - 1)))
+        return false;
+
+    this->size = size;
+    half = size / 2;
+
+    unsigned int bits = 0;
+    while ((1u << bits) < half)
+        bits++;
+    bitReverse.resize(half);
+    for (unsigned int n = 0; n < half; n++) {
+        unsigned int r = 0;
+        for (unsigned int b = 0; b < bits; b++)
+            r |= ((n >> b) & 1) << (bits - 1 - b);
+        bitReverse[n] = r;
+    }
+
+    // Twiddles for each stage stored contiguously, so a butterfly group reads
+    // them with unit stride
+    stageCos.clear();
+    stageSin.clear();
+    for (unsigned int span = 1; span < half; span *= 2) {
+        for (unsigned int j = 0; j < span; j++) {
+            double angle = -M_PI * j / span;
+            stageCos.push_back(std::cos(angle));
+            stageSin.push_back(std::sin(angle));
+        }
+    }
+
+    untangleCos.resize(half + 1);
+    untangleSin.resize(half + 1);
+    for (unsigned int k = 0; k <= half; k++) {
+        double angle = -2.0 * M_PI * k / size;
+        untangleCos[k] = std::cos(angle);
+        untangleSin[k] = std::sin(angle);
+    }
+
+    workRe.assign(half, 0.0f);
+    workIm.assign(half, 0.0f);
+    binRe.assign(half + 1, 0.0f);
+    binIm.assign(half + 1, 0.0f);
+    return true;
+}
+
+// In-place iterative radix-2 decimation-in-time FFT of workRe/workIm
+void RealFft::complexForward()
+{
+    float* re = workRe.data();
+    float* im = workIm.data();
+    const float* twCos = stageCos.data();
+    const float* twSin = stageSin.data();
+    for (unsigned int span = 1; span < half; span *= 2) {
+        for (unsigned int start = 0; start < half; start += 2 * span) {
+            float* aRe = re + start;
+            float* aIm = im + start;
+            float* bRe = aRe + span;
+            float* bIm = aIm + span;
+            unsigned int j = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+            // Four butterflies per iteration once a group is wide enough
+            for (; j + 4 <= span; j += 4) {
+                float32x4_t wRe = vld1q_f32(twCos + j);
+                float32x4_t wIm = vld1q_f32(twSin + j);
+                float32x4_t xRe = vld1q_f32(bRe + j);
+                float32x4_t xIm = vld1q_f32(bIm + j);
+                float32x4_t tRe = vmlsq_f32(vmulq_f32(xRe, wRe), xIm, wIm);
+                float32x4_t tIm = vmlaq_f32(vmulq_f32(xRe, wIm), xIm, wRe);
+                float32x4_t yRe = vld1q_f32(aRe + j);
+                float32x4_t yIm = vld1q_f32(aIm + j);
+                vst1q_f32(bRe + j, vsubq_f32(yRe, tRe));
+                vst1q_f32(bIm + j, vsubq_f32(yIm, tIm));
+                vst1q_f32(aRe + j, vaddq_f32(yRe, tRe));
+                vst1q_f32(aIm + j, vaddq_f32(yIm, tIm));
+            }
+#endif
+            for (; j < span; j++) {
+                float tRe = bRe[j] * twCos[j] - bIm[j] * twSin[j];
+                float tIm = bRe[j] * twSin[j] + bIm[j] * twCos[j];
+                bRe[j] = aRe[j] - tRe;
+                bIm[j] = aIm[j] - tIm;
+                aRe[j] += tRe;
+                aIm[j] += tIm;
+            }
+        }
+        twCos += span;
+        twSin += span;
+    }
+}
+
+void RealFft::forward(const float* in, float* re, float* im)
+{
+    // Pack even samples into the real part and odd samples into the
+    // imaginary part, in bit-reversed order
+    for (unsigned int n = 0; n < half; n++) {
+        unsigned int r = bitReverse[n];
+        workRe[r] = in[2 * n];
+        workIm[r] = in[2 * n + 1];
+    }
+    complexForward();
+
+    // X[k] = E[k] + W^k O[k], where E and O are the spectra of the even and
+    // odd samples recovered from Z[k] and conj(Z[N/2 - k])
+    for (unsigned int k = 0; k <= half; k++) {
+        unsigned int a = k % half;
+        unsigned int b = (half - k) % half;
+        float zRe = workRe[a], zIm = workIm[a];
+        float cRe = workRe[b], cIm = -workIm[b];
+        float eRe = 0.5f * (zRe + cRe);
+        float eIm = 0.5f * (zIm + cIm);
+        float oRe = 0.5f * (zIm - cIm);
+        float oIm = -0.5f * (zRe - cRe);
+        re[k] = eRe + untangleCos[k] * oRe - untangleSin[k] * oIm;
+        im[k] = eIm + untangleCos[k] * oIm + untangleSin[k] * oRe;
+    }
+}
+
+void RealFft::power(const float* in, float* out)
+{
+    forward(in, binRe.data(), binIm.data());
+    unsigned int k = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    for (; k + 4 <= half + 1; k += 4) {
+        float32x4_t re = vld1q_f32(&binRe[k]);
+        float32x4_t im = vld1q_f32(&binIm[k]);
+        vst1q_f32(out + k, vmlaq_f32(vmulq_f32(re, re), im, im));
+    }
+#endif
+    for (; k <= half; k++)
+        out[k] = binRe[k] * binRe[k] + binIm[k] * binIm[k];
+}
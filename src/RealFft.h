@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+// Forward FFT of a real signal whose length is a power of two.
+//
+// setup() builds the plan once (bit-reversal permutation and per-stage
+// twiddle tables); forward() then performs no allocation, so one plan can be
+// reused for every window of a stream. The transform packs the N real inputs
+// into an N/2-point complex FFT held as split real/imaginary arrays and
+// untangles the result into N/2 + 1 bins. On NEON, butterfly groups of four
+// or more are computed four at a time.
+class RealFft {
+public:
+    RealFft() {}
+
+    // Returns false if `size` is not a power of two >= 4
+    bool setup(unsigned int size);
+
+    // `in` holds getSize() samples; `re` and `im` receive getNumBins() bins
+    void forward(const float* in, float* re, float* im);
+
+    // Convenience: |X[k]|^2 for each of the getNumBins() bins
+    void power(const float* in, float* out);
+
+    unsigned int getSize() const { return size; }
+    unsigned int getNumBins() const { return size / 2 + 1; }
+
+private:
+    void complexForward();
+
+    unsigned int size = 0;
+    unsigned int half = 0;
+    std::vector<unsigned int> bitReverse; // half entries
+    std::vector<float> stageCos;          // half - 1 entries, stage by stage
+    std::vector<float> stageSin;
+    std::vector<float> untangleCos;       // half + 1 entries
+    std::vector<float> untangleSin;
+    std::vector<float> workRe;            // half entries
+    std::vector<float> workIm;
+    std::vector<float> binRe;             // half + 1 entries, for power()
+    std::vector<float> binIm;
+};
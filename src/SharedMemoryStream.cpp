@@ -0,0 +1,252 @@
+#include "SharedMemoryStream.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const uint32_t kMagic = 0x4c534c31; // "LSL1"
+
+// Header of the shared mapping, followed by `capacity` timestamps and
+// `capacity * channels` samples
+struct alignas(8) SharedMemoryRing {
+    uint32_t magic;
+    uint32_t channels;
+    uint32_t capacity;
+    std::atomic<uint32_t> alive;       // cleared when the outlet goes away
+    std::atomic<uint32_t> claimed;     // set while a reader is attached
+    std::atomic<uint32_t> waiting;     // set while the reader sleeps in the futex
+    std::atomic<uint32_t> writeCount;  // free-running frame counters
+    std::atomic<uint32_t> readCount;
+
+    double* timestamps() { return reinterpret_cast<double*>(this + 1); }
+    // The samples follow `frames` timestamps. Each end passes the capacity
+    // it checked, never the header's, which the other process can rewrite.
+    float* data(uint32_t frames) { return reinterpret_cast<float*>(timestamps() + frames); }
+};
+
+// 64-bit, so a bogus header cannot wrap it on a 32-bit board
+static uint64_t ringBytes(unsigned int channels, unsigned int capacity)
+{
+    return sizeof(SharedMemoryRing) + (uint64_t)capacity * (sizeof(double) + channels * sizeof(float));
+}
+
+static std::string ringPath(const std::string& uid)
+{
+    return "/lsl-" + uid;
+}
+
+// The futex word is the write counter; shared (not private) so that it
+// works across processes
+static void futexWake(std::atomic<uint32_t>* word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+static void futexWait(std::atomic<uint32_t>* word, uint32_t expected, double timeout)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)timeout;
+    ts.tv_nsec = (long)((timeout - ts.tv_sec) * 1e9);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+SharedMemoryOutlet::SharedMemoryOutlet(const lsl::stream_info& info, unsigned int capacity, int32_t chunkSize, int32_t maxBuffered,
+                                       lsl_transport_options_t flags)
+    : outlet(info, chunkSize, maxBuffered, flags), channels(info.channel_count()), sampleRate(info.nominal_srate())
+{
+    if (info.channel_format() != lsl::cf_float32 || channels == 0 || capacity == 0)
+        return;
+
+    unsigned int size = 1;
+    while (size < capacity)
+        size *= 2;
+
+    // Named after the uid liblsl gave the outlet, which inlets can see
+    path = ringPath(outlet.info().uid());
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        return;
+    std::size_t bytes = ringBytes(channels, size);
+    void* mapping = MAP_FAILED;
+    if (ftruncate(fd, bytes) == 0)
+        mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(path.c_str());
+        return;
+    }
+
+    // The mapping is zero-filled, so the counters and flags start cleared
+    ring = static_cast<SharedMemoryRing*>(mapping);
+    mappedBytes = bytes;
+    this->capacity = size;
+    mask = size - 1;
+    ring->channels = channels;
+    ring->capacity = size;
+    ring->alive.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    ring->magic = kMagic;
+}
+
+SharedMemoryOutlet::~SharedMemoryOutlet()
+{
+    if (!ring)
+        return;
+    ring->alive.store(0, std::memory_order_seq_cst);
+    futexWake(&ring->writeCount);
+    munmap(ring, mappedBytes);
+    shm_unlink(path.c_str());
+}
+
+bool SharedMemoryOutlet::hasSharedReader() const
+{
+    return ring && ring->claimed.load(std::memory_order_relaxed);
+}
+
+void SharedMemoryOutlet::push_chunk_multiplexed(const float* data, const double* timestamps, std::size_t elements)
+{
+    outlet.push_chunk_multiplexed(data, timestamps, elements);
+    writeRing(data, timestamps, elements / channels, 0.0);
+}
+
+void SharedMemoryOutlet::push_chunk_multiplexed(const float* data, std::size_t elements)
+{
+    double now = lsl::local_clock();
+    outlet.push_chunk_multiplexed(data, elements, now);
+    writeRing(data, nullptr, elements / channels, now);
+}
+
+void SharedMemoryOutlet::writeRing(const float* data, const double* timestamps, unsigned int frames, double lastTimestamp)
+{
+    if (!hasSharedReader() || frames == 0)
+        return;
+
+    // The reader shares the header, so a bad read count must not make the
+    // space look larger than this end's capacity
+    uint32_t start = ring->writeCount.load(std::memory_order_relaxed);
+    uint32_t used = start - ring->readCount.load(std::memory_order_acquire);
+    uint32_t space = used < capacity ? capacity - used : 0;
+    // Only the oldest frames fit; they keep the timestamps of the full chunk
+    unsigned int total = frames;
+    if (frames > space) {
+        dropped += frames - space;
+        frames = space;
+    }
+    double period = sampleRate > 0.0 ? 1.0 / sampleRate : 0.0;
+    for (unsigned int f = 0; f < frames; f++) {
+        uint32_t pos = (start + f) & mask;
+        std::memcpy(ring->data(capacity) + pos * channels, data + f * channels, channels * sizeof(float));
+        ring->timestamps()[pos] = timestamps ? timestamps[f] : lastTimestamp - (total - 1 - f) * period;
+    }
+    // Publish, then wake the reader if it went to sleep before seeing this
+    ring->writeCount.store(start + frames, std::memory_order_seq_cst);
+    if (ring->waiting.load(std::memory_order_seq_cst))
+        futexWake(&ring->writeCount);
+}
+
+SharedMemoryInlet::SharedMemoryInlet(const lsl::stream_info& info, int32_t maxBuflen, int32_t maxChunklen, bool recover)
+    : channels(info.channel_count())
+{
+    char hostname[256] = {};
+    gethostname(hostname, sizeof(hostname) - 1);
+    if (info.channel_format() == lsl::cf_float32 && info.hostname() == hostname) {
+        int fd = shm_open(ringPath(info.uid()).c_str(), O_RDWR, 0);
+        struct stat st;
+        if (fd >= 0) {
+            if (fstat(fd, &st) == 0 && (std::size_t)st.st_size >= sizeof(SharedMemoryRing)) {
+                void* mapping = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (mapping != MAP_FAILED) {
+                    ring = static_cast<SharedMemoryRing*>(mapping);
+                    mappedBytes = st.st_size;
+                }
+            }
+            close(fd);
+        }
+        // Read the geometry once, after the magic the outlet writes last;
+        // from here on only this end's copy is used
+        if (ring && ring->magic == kMagic) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            capacity = ring->capacity;
+            mask = capacity - 1;
+        }
+        uint32_t unclaimed = 0;
+        if (ring && (ring->magic != kMagic || ring->channels != channels || capacity == 0 || (capacity & mask) != 0 ||
+                     (uint64_t)mappedBytes < ringBytes(channels, capacity) || !ring->alive.load() ||
+                     !ring->claimed.compare_exchange_strong(unclaimed, 1))) {
+            munmap(ring, mappedBytes);
+            ring = nullptr;
+        }
+        if (ring) {
+            // Start from what the outlet writes next
+            ring->readCount.store(ring->writeCount.load(std::memory_order_acquire), std::memory_order_release);
+            return;
+        }
+    }
+    inlet.reset(new lsl::stream_inlet(info, maxBuflen, maxChunklen, recover));
+}
+
+SharedMemoryInlet::~SharedMemoryInlet()
+{
+    if (ring) {
+        ring->claimed.store(0, std::memory_order_release);
+        munmap(ring, mappedBytes);
+    }
+}
+
+void SharedMemoryInlet::open_stream(double timeout)
+{
+    if (inlet)
+        inlet->open_stream(timeout);
+}
+
+double SharedMemoryInlet::time_correction(double timeout)
+{
+    // Same host, same clock
+    return inlet ? inlet->time_correction(timeout) : 0.0;
+}
+
+std::size_t SharedMemoryInlet::pull_chunk_multiplexed(float* data, double* timestamps, std::size_t dataElements,
+                                                      std::size_t timestampElements, double timeout)
+{
+    if (inlet)
+        return inlet->pull_chunk_multiplexed(data, timestamps, dataElements, timestampElements, timeout);
+
+    uint32_t start = ring->readCount.load(std::memory_order_relaxed);
+    uint32_t available = ring->writeCount.load(std::memory_order_acquire) - start;
+    if (available == 0 && timeout > 0.0) {
+        double deadline = lsl::local_clock() + timeout;
+        double remaining = timeout;
+        while (available == 0 && remaining > 0.0 && ring->alive.load(std::memory_order_relaxed)) {
+            ring->waiting.store(1, std::memory_order_seq_cst);
+            uint32_t written = ring->writeCount.load(std::memory_order_seq_cst);
+            if (written == start)
+                futexWait(&ring->writeCount, written, remaining);
+            ring->waiting.store(0, std::memory_order_relaxed);
+            available = ring->writeCount.load(std::memory_order_acquire) - start;
+            remaining = deadline - lsl::local_clock();
+        }
+    }
+    if (available == 0) {
+        if (!ring->alive.load(std::memory_order_acquire))
+            throw lsl::lost_error("The stream's outlet has been destroyed.");
+        return 0;
+    }
+
+    // Never read more than this end's capacity, whatever the counters say
+    std::size_t frames = std::min<std::size_t>(std::min(available, capacity), std::min(dataElements / channels, timestampElements));
+    for (std::size_t f = 0; f < frames; f++) {
+        uint32_t pos = (start + f) & mask;
+        std::memcpy(data + f * channels, ring->data(capacity) + pos * channels, channels * sizeof(float));
+        if (timestamps)
+            timestamps[f] = ring->timestamps()[pos];
+    }
+    ring->readCount.store(start + frames, std::memory_order_release);
+    return frames * channels;
+}
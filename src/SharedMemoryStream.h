@@ -0,0 +1,89 @@
+#pragma once
+
+#include <lsl_cpp.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Opt-in shared-memory fast path for float32 streams whose outlet and inlet
+// run on the same host, e.g. this sketch and a helper process on the board.
+//
+// SharedMemoryOutlet creates an ordinary lsl::stream_outlet, so the stream is
+// discovered, described and served to other hosts exactly as before, and
+// also a POSIX shared-memory ring named after the stream's uid. Each push
+// writes the samples and their timestamps to both.
+//
+// SharedMemoryInlet looks at a resolved stream_info: if its hostname() is
+// this host and the ring exists, it reads chunks straight out of the ring
+// (a single-producer / single-consumer queue of frames and timestamps) and
+// never opens a TCP connection. Otherwise it falls back to an
+// lsl::stream_inlet. Either way it offers the pull calls the sketches use,
+// with LSL timestamps (the host's local clock, so no correction is needed).
+//
+// A ring serves one reader; a second same-host inlet falls back to TCP.
+// Blocking pulls sleep on a futex on the ring's write counter, and the
+// outlet only makes the wake-up system call when a reader is asleep. When
+// the reader falls behind, pushes that do not fit in the ring are dropped
+// and counted. The outlet removes the ring when it is destroyed; a crashed
+// outlet leaves it in /dev/shm until the host restarts.
+//
+// The ring is created readable and writable by its owner only, so the
+// reader must run as the same user. Neither end trusts the other with the
+// ring's geometry: each keeps its own capacity and index mask, and the
+// reader refuses a ring whose header does not describe a power-of-two
+// capacity that fits the mapping.
+struct SharedMemoryRing;
+
+class SharedMemoryOutlet {
+public:
+    // `capacity` frames are buffered for the reader (rounded up to a power of
+    // two); chunkSize, maxBuffered and flags are passed to the LSL outlet
+    SharedMemoryOutlet(const lsl::stream_info& info, unsigned int capacity = 8192, int32_t chunkSize = 0, int32_t maxBuffered = 360,
+                       lsl_transport_options_t flags = transp_default);
+    ~SharedMemoryOutlet();
+
+    // `elements` is frames * channels. Without timestamps, the last frame is
+    // stamped with lsl::local_clock() and earlier ones spaced by the nominal rate.
+    void push_chunk_multiplexed(const float* data, const double* timestamps, std::size_t elements);
+    void push_chunk_multiplexed(const float* data, std::size_t elements);
+
+    // Whether a same-host reader is attached to the ring
+    bool hasSharedReader() const;
+    unsigned long getDropped() const { return dropped; }
+    lsl::stream_info info() const { return outlet.info(); }
+
+private:
+    void writeRing(const float* data, const double* timestamps, unsigned int frames, double lastTimestamp);
+
+    lsl::stream_outlet outlet;
+    unsigned int channels;
+    double sampleRate;
+    std::string path;
+    SharedMemoryRing* ring = nullptr;
+    uint32_t capacity = 0; // frames, a power of two
+    uint32_t mask = 0;
+    std::size_t mappedBytes = 0;
+    unsigned long dropped = 0;
+};
+
+class SharedMemoryInlet {
+public:
+    explicit SharedMemoryInlet(const lsl::stream_info& info, int32_t maxBuflen = 360, int32_t maxChunklen = 0, bool recover = true);
+    ~SharedMemoryInlet();
+
+    bool isSharedMemory() const { return ring != nullptr; }
+
+    // As lsl::stream_inlet; throws lsl::lost_error once the outlet is gone
+    void open_stream(double timeout = lsl::FOREVER);
+    std::size_t pull_chunk_multiplexed(float* data, double* timestamps, std::size_t dataElements,
+                                       std::size_t timestampElements, double timeout = 0.0);
+    double time_correction(double timeout = 2.0);
+
+private:
+    std::unique_ptr<lsl::stream_inlet> inlet; // TCP fallback
+    unsigned int channels;
+    SharedMemoryRing* ring = nullptr;
+    uint32_t capacity = 0; // frames, checked when the ring is opened
+    uint32_t mask = 0;
+    std::size_t mappedBytes = 0;
+};
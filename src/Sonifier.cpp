@@ -0,0 +1,284 @@
+#include "Sonifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+const float kDefaultFrequency = 220.0f;
+const float kDefaultCutoff = 20000.0f;
+const unsigned int kTableHarmonics = 16;
+
+// Parse "n" or "first-last" into a first index and a count
+bool parseRange(const std::string& text, unsigned int& first, unsigned int& count)
+{
+    unsigned int last;
+    char dash;
+    std::istringstream range(text);
+    if (!(range >> first))
+        return false;
+    if (range >> dash) {
+        if (dash != '-' || !(range >> last) || last < first)
+            return false;
+    } else {
+        last = first;
+    }
+    count = last - first + 1;
+    return true;
+}
+} // namespace
+
+bool Sonifier::compile(const std::string& config)
+{
+    std::vector<Mapping> compiled;
+    unsigned int voices = 0;
+    float smoothingTime = smoothingMs;
+
+    std::istringstream lines(config);
+    std::string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(lines, line)) {
+        lineNumber++;
+        std::istringstream tokens(line);
+        std::string keyword;
+        if (!(tokens >> keyword) || keyword[0] == '#')
+            continue;
+
+        bool ok = false;
+        if (keyword == "voices") {
+            ok = (tokens >> voices) && voices > 0;
+        } else if (keyword == "smoothing") {
+            ok = (tokens >> smoothingTime) && smoothingTime > 0.0f;
+        } else if (keyword == "map") {
+            std::string voiceRange, channelRange, parameter, curve;
+            float inMax, outMax;
+            Mapping m;
+            unsigned int numChannels;
+            ok = (tokens >> voiceRange >> m.stream >> channelRange >> parameter >> curve
+                    >> m.inMin >> inMax >> m.outMin >> outMax)
+                && parseRange(voiceRange, m.firstVoice, m.numVoices)
+                && parseRange(channelRange, m.firstChannel, numChannels)
+                && numChannels == m.numVoices
+                && inMax != m.inMin;
+            if (ok) {
+                if (parameter == "frequency")
+                    m.parameter = frequency;
+                else if (parameter == "amplitude")
+                    m.parameter = amplitude;
+                else if (parameter == "cutoff")
+                    m.parameter = cutoff;
+                else
+                    ok = false;
+
+                m.inScale = 1.0f / (inMax - m.inMin);
+                m.outRange = outMax - m.outMin;
+                if (curve == "linear") {
+                    m.curve = linear;
+                } else if (curve == "log") {
+                    m.curve = logarithmic;
+                } else if (curve == "exp" && m.outMin > 0.0f && outMax > 0.0f) {
+                    m.curve = exponential;
+                    m.outRange = std::log(outMax / m.outMin);
+                } else {
+                    ok = false;
+                }
+            }
+            if (ok) {
+                compiled.push_back(m);
+                voices = std::max(voices, m.firstVoice + m.numVoices);
+            }
+        }
+
+        if (!ok) {
+            char message[64];
+            snprintf(message, sizeof(message), "invalid line %u: ", lineNumber);
+            error = message + line;
+            return false;
+        }
+    }
+
+    mappings = compiled;
+    numVoices = voices;
+    smoothingMs = smoothingTime;
+    error.clear();
+    return true;
+}
+
+bool Sonifier::setup(float sampleRate)
+{
+    if (sampleRate <= 0.0f)
+        return false;
+
+    this->sampleRate = sampleRate;
+    numGroups = (numVoices + kLanes - 1) / kLanes;
+    unsigned int stride = numGroups * kLanes;
+    smoothing = 1.0f - std::exp(-1000.0f / (smoothingMs * sampleRate));
+    incrementScale = kTableSize / sampleRate;
+    cutoffScale = 2.0f * (float)M_PI / sampleRate;
+
+    targets.assign(kNumParameters * stride, 0.0f);
+    std::fill_n(&targets[frequency * stride], stride, kDefaultFrequency * incrementScale);
+    std::fill_n(&targets[cutoff * stride], stride, std::min(1.0f, kDefaultCutoff * cutoffScale));
+    current = targets;
+    phase.assign(stride, 0.0f);
+    lowpass.assign(stride, 0.0f);
+
+    mailbox.setup(targets.size());
+    publish();
+    mailbox.update();
+
+    // Band-limited sawtooth with a guard point for interpolation
+    table.resize(kTableSize + 1);
+    for (unsigned int n = 0; n <= kTableSize; n++) {
+        float sample = 0.0f;
+        for (unsigned int k = 1; k <= kTableHarmonics; k++)
+            sample += std::sin(2.0f * (float)M_PI * k * n / kTableSize) / k;
+        table[n] = sample * 0.5f;
+    }
+    return true;
+}
+
+float Sonifier::map(const Mapping& mapping, float value) const
+{
+    float t = std::min(1.0f, std::max(0.0f, (value - mapping.inMin) * mapping.inScale));
+    switch (mapping.curve) {
+    case exponential:
+        return mapping.outMin * std::exp(t * mapping.outRange);
+    case logarithmic:
+        return mapping.outMin + mapping.outRange * std::log10(1.0f + 9.0f * t);
+    case linear:
+    default:
+        return mapping.outMin + mapping.outRange * t;
+    }
+}
+
+void Sonifier::update(const char* stream, const float* frame, unsigned int channels)
+{
+    unsigned int stride = numGroups * kLanes;
+    for (const auto& m : mappings) {
+        if (m.stream != "*" && m.stream != stream)
+            continue;
+        float* target = &targets[m.parameter * stride + m.firstVoice];
+        for (unsigned int i = 0; i < m.numVoices && m.firstChannel + i < channels; i++) {
+            float value = map(m, frame[m.firstChannel + i]);
+            // Convert to the units the audio thread smooths in
+            if (m.parameter == frequency)
+                value = std::min(std::max(value, 0.0f), sampleRate * 0.5f) * incrementScale;
+            else if (m.parameter == cutoff)
+                value = std::min(1.0f, std::max(value, 0.0f) * cutoffScale);
+            target[i] = value;
+        }
+    }
+}
+
+void Sonifier::publish()
+{
+    std::copy(targets.begin(), targets.end(), mailbox.getWriteBuffer());
+    mailbox.publish();
+}
+
+void Sonifier::process(float* out, unsigned int frames, unsigned int channels)
+{
+    std::fill_n(out, frames * channels, 0.0f);
+    if (channels == 0 || numGroups == 0)
+        return;
+    mailbox.update();
+    for (unsigned int g = 0; g < numGroups; g++)
+        processGroup(g, out, frames, channels);
+}
+
+// Per sample, for four voices at once:
+//   smooth increment, amplitude and cutoff towards their targets
+//   advance and wrap the phase, read the table with linear interpolation
+//   one-pole lowpass, scale by amplitude and mix into the voice's channel
+void Sonifier::processGroup(unsigned int group, float* out, unsigned int frames, unsigned int channels)
+{
+    const unsigned int stride = numGroups * kLanes;
+    const unsigned int v = group * kLanes;
+    const float* target = mailbox.getReadBuffer();
+    float* inc = &current[frequency * stride + v];
+    float* amp = &current[amplitude * stride + v];
+    float* coeff = &current[cutoff * stride + v];
+    const float* tableData = table.data();
+
+    unsigned int lanes = std::min(kLanes, numVoices - v);
+    unsigned int channel[kLanes];
+    for (unsigned int l = 0; l < kLanes; l++)
+        channel[l] = (v + l) % channels;
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float32x4_t k = vdupq_n_f32(smoothing);
+    const float32x4_t size = vdupq_n_f32((float)kTableSize);
+    const float32x4_t tInc = vld1q_f32(target + frequency * stride + v);
+    const float32x4_t tAmp = vld1q_f32(target + amplitude * stride + v);
+    const float32x4_t tCoeff = vld1q_f32(target + cutoff * stride + v);
+    float32x4_t vInc = vld1q_f32(inc);
+    float32x4_t vAmp = vld1q_f32(amp);
+    float32x4_t vCoeff = vld1q_f32(coeff);
+    float32x4_t vPhase = vld1q_f32(&phase[v]);
+    float32x4_t vLowpass = vld1q_f32(&lowpass[v]);
+    int32_t index[kLanes];
+    float a[kLanes], b[kLanes], y[kLanes];
+
+    for (unsigned int f = 0; f < frames; f++) {
+        vInc = vmlaq_f32(vInc, k, vsubq_f32(tInc, vInc));
+        vAmp = vmlaq_f32(vAmp, k, vsubq_f32(tAmp, vAmp));
+        vCoeff = vmlaq_f32(vCoeff, k, vsubq_f32(tCoeff, vCoeff));
+
+        vPhase = vaddq_f32(vPhase, vInc);
+        uint32x4_t wrap = vcgeq_f32(vPhase, size);
+        vPhase = vsubq_f32(vPhase, vreinterpretq_f32_u32(vandq_u32(wrap, vreinterpretq_u32_f32(size))));
+
+        int32x4_t vIndex = vcvtq_s32_f32(vPhase);
+        float32x4_t frac = vsubq_f32(vPhase, vcvtq_f32_s32(vIndex));
+        vst1q_s32(index, vIndex);
+        for (unsigned int l = 0; l < kLanes; l++) {
+            a[l] = tableData[index[l]];
+            b[l] = tableData[index[l] + 1];
+        }
+        float32x4_t va = vld1q_f32(a);
+        float32x4_t sample = vmlaq_f32(va, frac, vsubq_f32(vld1q_f32(b), va));
+
+        vLowpass = vmlaq_f32(vLowpass, vCoeff, vsubq_f32(sample, vLowpass));
+        vst1q_f32(y, vmulq_f32(vLowpass, vAmp));
+
+        float* frame = out + f * channels;
+        for (unsigned int l = 0; l < lanes; l++)
+            frame[channel[l]] += y[l];
+    }
+
+    vst1q_f32(inc, vInc);
+    vst1q_f32(amp, vAmp);
+    vst1q_f32(coeff, vCoeff);
+    vst1q_f32(&phase[v], vPhase);
+    vst1q_f32(&lowpass[v], vLowpass);
+#else
+    const float k = smoothing;
+    const float size = (float)kTableSize;
+    float* vPhase = &phase[v];
+    float* vLowpass = &lowpass[v];
+    for (unsigned int f = 0; f < frames; f++) {
+        float* frame = out + f * channels;
+        for (unsigned int l = 0; l < lanes; l++) {
+            inc[l] += k * (target[frequency * stride + v + l] - inc[l]);
+            amp[l] += k * (target[amplitude * stride + v + l] - amp[l]);
+            coeff[l] += k * (target[cutoff * stride + v + l] - coeff[l]);
+
+            float p = vPhase[l] + inc[l];
+            if (p >= size)
+                p -= size;
+            vPhase[l] = p;
+
+            int index = (int)p;
+            float frac = p - index;
+            float sample = tableData[index] + frac * (tableData[index + 1] - tableData[index]);
+
+            vLowpass[l] += coeff[l] * (sample - vLowpass[l]);
+            frame[channel[l]] += vLowpass[l] * amp[l];
+        }
+    }
+#endif
+}
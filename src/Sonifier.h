@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "TripleBuffer.h"
+
+// A bank of wavetable voices whose frequency, amplitude and filter cutoff are
+// driven by channels of LSL streams.
+//
+// The pull side (an auxiliary task) calls update() with the newest frame of
+// each stream and then publish(); the mapped parameter targets travel to the
+// audio thread through a TripleBuffer, and process() smooths every parameter
+// per sample towards its target. Voices are rendered four at a time in NEON
+// lanes, so the bank scales to hundreds of voices.
+//
+// Mappings are compiled from a small text format, one per line:
+//
+//   voices <count>
+//   smoothing <milliseconds>
+//   map <voices> <stream> <channels> <parameter> <curve> <inMin> <inMax> <outMin> <outMax>
+//
+// where <voices> and <channels> are an index or an inclusive range such as
+// 0-63 (voice i is driven by channel i of the range), <stream> is a stream
+// name or * for any stream, <parameter> is frequency, amplitude or cutoff,
+// and <curve> is linear, exp or log. Lines starting with # are ignored.
+class Sonifier {
+public:
+    enum Parameter {
+        frequency,
+        amplitude,
+        cutoff,
+        kNumParameters
+    };
+
+    enum Curve {
+        linear,
+        exponential,
+        logarithmic,
+    };
+
+    struct Mapping {
+        unsigned int firstVoice;
+        unsigned int numVoices;
+        std::string stream;
+        unsigned int firstChannel;
+        Parameter parameter;
+        Curve curve;
+        float inMin;
+        float inScale;  // 1 / (inMax - inMin)
+        float outMin;
+        float outRange; // outMax - outMin, or log(outMax / outMin) for exp
+    };
+
+    static constexpr unsigned int kLanes = 4;
+    static constexpr unsigned int kTableSize = 2048;
+
+    Sonifier() {}
+
+    // Parse and compile the mappings. Returns false (and leaves the engine
+    // untouched) on a syntax error, with a description in getError().
+    bool compile(const std::string& config);
+
+    // Allocate the voice bank. Call after compile() and before process().
+    bool setup(float sampleRate);
+
+    // Pull side: apply the mappings that match `stream` to its newest frame,
+    // then publish() once all streams have been updated.
+    void update(const char* stream, const float* frame, unsigned int channels);
+    void publish();
+
+    // Audio thread: render `frames` interleaved frames of `channels` channels.
+    // Voice v is mixed into channel v % channels.
+    void process(float* out, unsigned int frames, unsigned int channels);
+
+    unsigned int getNumVoices() const { return numVoices; }
+    unsigned int getNumMappings() const { return mappings.size(); }
+    const std::string& getError() const { return error; }
+
+private:
+    float map(const Mapping& mapping, float value) const;
+    void processGroup(unsigned int group, float* out, unsigned int frames, unsigned int channels);
+
+    std::vector<Mapping> mappings;
+    std::string error;
+    unsigned int numVoices = 0;
+    unsigned int numGroups = 0;
+    float smoothingMs = 20.0f;
+    float sampleRate = 0.0f;
+    float smoothing = 1.0f;     // one-pole coefficient per sample
+    float incrementScale = 0.0f; // Hz to table positions per sample
+    float cutoffScale = 0.0f;    // Hz to one-pole lowpass coefficient
+
+    // Pull side: targets in engine units, [parameter][voice]
+    std::vector<float> targets;
+    TripleBuffer mailbox;
+
+    // Audio thread: structure-of-arrays voice state, padded to kLanes
+    std::vector<float> phase;
+    std::vector<float> current; // [parameter][voice]
+    std::vector<float> lowpass;
+    std::vector<float> table;   // kTableSize + 1 guard point
+};
@@ -0,0 +1,82 @@
+#include "SpectrumAnalyser.h"
+#include <cmath>
+
+bool SpectrumAnalyser::setup(unsigned int size, float sampleRate, float frameRate, const std::string& outletName,
+                             int32_t maxBuffered)
+{
+    if (sampleRate <= 0.0f || frameRate <= 0.0f || !fft.setup(size))
+        return false;
+
+    this->sampleRate = sampleRate;
+    hann.resize(size);
+    float windowSum = 0.0f;
+    for (unsigned int n = 0; n < size; n++) {
+        hann[n] = 0.5f - 0.5f * std::cos(2.0 * M_PI * n / size);
+        windowSum += hann[n];
+    }
+    // A sine of amplitude A has |X[k]| = A * sum(w) / 2
+    magnitudeScale = 2.0f / windowSum;
+
+    mono.assign(size, 0.0f);
+    power.assign(fft.getNumBins(), 0.0f);
+    spectra.setup(fft.getNumBins());
+
+    outlet.reset();
+    if (!outletName.empty()) {
+        lsl::stream_info info(outletName, "Spectrum", fft.getNumBins(), frameRate, lsl::cf_float32,
+            outletName + "-" + std::to_string(size));
+        lsl::xml_element bins = info.desc().append_child("channels");
+        for (unsigned int k = 0; k < fft.getNumBins(); k++)
+            bins.append_child("channel")
+                .append_child_value("label", std::to_string(getBinFrequency(k)))
+                .append_child_value("unit", "Hz");
+        if (maxBuffered > 0)
+            outlet.reset(new lsl::stream_outlet(info, 0, maxBuffered, transp_bufsize_samples));
+        else
+            outlet.reset(new lsl::stream_outlet(info));
+    }
+    return true;
+}
+
+void SpectrumAnalyser::analyse(const float* ring, int ringFrames, int channels, int writePos, double timestamp)
+{
+    int size = fft.getSize();
+    if (channels <= 0 || size > ringFrames)
+        return;
+
+    // Mix the newest frames to mono; the producer only writes ahead of
+    // writePos, so these frames are stable while we copy them
+    float gain = 1.0f / channels;
+    int pos = writePos - size;
+    if (pos < 0)
+        pos += ringFrames;
+    for (int n = 0; n < size; n++) {
+        const float* frame = ring + pos * channels;
+        float sum = 0.0f;
+        for (int ch = 0; ch < channels; ch++)
+            sum += frame[ch];
+        mono[n] = sum * gain * hann[n];
+        if (++pos == ringFrames)
+            pos = 0;
+    }
+
+    fft.power(mono.data(), power.data());
+    float* magnitudes = spectra.getWriteBuffer();
+    for (unsigned int k = 0; k < fft.getNumBins(); k++)
+        magnitudes[k] = std::sqrt(power[k]) * magnitudeScale;
+
+    if (outlet)
+        outlet->push_sample(magnitudes, timestamp);
+    spectra.publish();
+}
+
+float SpectrumAnalyser::getPeakFrequency() const
+{
+    const float* magnitudes = spectra.getReadBuffer();
+    unsigned int peak = 0;
+    for (unsigned int k = 1; k < fft.getNumBins(); k++) {
+        if (magnitudes[k] > magnitudes[peak])
+            peak = k;
+    }
+    return getBinFrequency(peak);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <lsl_cpp.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "RealFft.h"
+#include "TripleBuffer.h"
+
+// Magnitude spectrum of the most recent audio in a playback ring.
+//
+// analyse() is meant for a low-priority auxiliary task: it copies the last
+// `size` frames behind the ring's write position without touching the read
+// or write indices, so the audio thread and the producer never wait on it.
+// The channels are mixed to mono, Hann-windowed and transformed with a
+// reused FFT plan. Each spectrum is published to a TripleBuffer for local
+// consumers and, optionally, pushed to an LSL outlet.
+//
+// Magnitudes are normalised so that a full-scale sine reads 1.0 in its bin.
+class SpectrumAnalyser {
+public:
+    SpectrumAnalyser() {}
+
+    // Allocate the plan and buffers. If `outletName` is not empty, also
+    // create an outlet with one channel per bin at `frameRate` spectra per
+    // second, buffering `maxBuffered` spectra (a MemoryBudget grant) or, if
+    // 0, liblsl's 360 s. Throws if the outlet cannot be created.
+    bool setup(unsigned int size, float sampleRate, float frameRate, const std::string& outletName = "",
+               int32_t maxBuffered = 0);
+
+    // Analyse the `size` frames that end just before `writePos` in an
+    // interleaved ring of `ringFrames` frames of `channels` channels.
+    void analyse(const float* ring, int ringFrames, int channels, int writePos, double timestamp);
+
+    // Consumer side (one thread): acquire the newest spectrum, if any
+    bool update() { return spectra.update(); }
+    const float* getSpectrum() const { return spectra.getReadBuffer(); }
+
+    // Frequency of the strongest bin in the newest spectrum
+    float getPeakFrequency() const;
+
+    unsigned int getNumBins() const { return fft.getNumBins(); }
+    float getBinFrequency(unsigned int bin) const { return bin * sampleRate / fft.getSize(); }
+
+private:
+    float sampleRate = 0.0f;
+    float magnitudeScale = 0.0f;
+    RealFft fft;
+    std::vector<float> hann;
+    std::vector<float> mono;
+    std::vector<float> power;
+    TripleBuffer spectra;
+    std::unique_ptr<lsl::stream_outlet> outlet;
+};
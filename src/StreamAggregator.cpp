@@ -0,0 +1,105 @@
+#include "StreamAggregator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// A non-negative decimal count; anything else (empty, signed, trailing
+// text, too large) is rejected rather than read as 0 or wrapped around
+static bool parseCount(const char* text, unsigned int& value)
+{
+    if (*text < '0' || *text > '9')
+        return false;
+    char* end;
+    unsigned long parsed = strtoul(text, &end, 10);
+    if (*end != '\0' || parsed > 0xffffffffUL)
+        return false;
+    value = parsed;
+    return true;
+}
+
+unsigned int StreamAggregator::addSource(const std::string& name, const std::string& type, unsigned int channels)
+{
+    sources.push_back({name, type, numChannels, channels});
+    numChannels += channels;
+    return sources.size() - 1;
+}
+
+bool StreamAggregator::open(const std::string& name, const std::string& type, double sampleRate, const std::string& sourceId,
+                            unsigned int chunkFrames, unsigned int capacity, int32_t maxBuffered)
+{
+    if (numChannels == 0 || chunkFrames == 0 || !ring.setup(numChannels, std::max(capacity, chunkFrames)))
+        return false;
+
+    lsl::stream_info info(name, type, numChannels, sampleRate, lsl::cf_float32, sourceId);
+    lsl::xml_element streams = info.desc().append_child("streams");
+    for (const auto& source : sources) {
+        streams.append_child("stream")
+            .append_child_value("name", source.name)
+            .append_child_value("type", source.type)
+            .append_child_value("first_channel", std::to_string(source.firstChannel))
+            .append_child_value("channel_count", std::to_string(source.channels));
+    }
+
+    this->chunkFrames = chunkFrames;
+    frame.assign(numChannels, NAN);
+    chunk.resize(chunkFrames * numChannels);
+    chunkTimestamps.resize(chunkFrames);
+    if (maxBuffered > 0)
+        outlet.reset(new lsl::stream_outlet(info, chunkFrames, maxBuffered, transp_bufsize_samples));
+    else
+        outlet.reset(new lsl::stream_outlet(info, chunkFrames));
+    return true;
+}
+
+void StreamAggregator::update(unsigned int source, const float* values)
+{
+    const Source& s = sources[source];
+    std::copy(values, values + s.channels, frame.begin() + s.firstChannel);
+}
+
+bool StreamAggregator::commit(double timestamp)
+{
+    return ring.write(frame.data(), &timestamp, 1) == 1;
+}
+
+unsigned int StreamAggregator::publish()
+{
+    if (!outlet)
+        return 0;
+    unsigned int total = 0;
+    unsigned int frames;
+    while ((frames = ring.read(chunk.data(), chunkTimestamps.data(), chunkFrames)) > 0) {
+        outlet->push_chunk_multiplexed(chunk.data(), chunkTimestamps.data(), frames * numChannels);
+        total += frames;
+    }
+    return total;
+}
+
+bool StreamDemultiplexer::setup(lsl::stream_info info)
+{
+    views.clear();
+    numChannels = info.channel_count();
+    lsl::xml_element streams = info.desc().child("streams");
+    for (lsl::xml_element e = streams.child("stream"); !e.empty(); e = e.next_sibling("stream")) {
+        View view;
+        view.name = e.child_value("name");
+        view.type = e.child_value("type");
+        // Written so that no sum can wrap around
+        if (!parseCount(e.child_value("first_channel"), view.firstChannel) ||
+            !parseCount(e.child_value("channel_count"), view.channels) || view.channels == 0 ||
+            view.firstChannel >= numChannels || view.channels > numChannels - view.firstChannel) {
+            views.clear();
+            return false;
+        }
+        views.push_back(view);
+    }
+    return !views.empty();
+}
+
+int StreamDemultiplexer::find(const std::string& name) const
+{
+    for (unsigned int n = 0; n < views.size(); n++)
+        if (views[n].name == name)
+            return n;
+    return -1;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <lsl_cpp.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "FrameRing.h"
+
+// Publishes many small local sources (one per sensor, say) as a single wide
+// outlet, so consumers make one connection and resolve one stream, and
+// samples cross the C API once per chunk instead of once per source sample.
+//
+// Each source owns a range of the outlet's channels, listed under
+// desc()/streams as <stream> entries with name, type, first_channel and
+// channel_count - the same layout as the synchronised outlet in render.cpp.
+// Sources update() their newest values whenever they have them; commit()
+// then appends one wide frame holding every source's latest values (NaN
+// until a source first updates). Frames queue in a FrameRing, so update()
+// and commit() are safe on the audio thread, and publish() pushes them to
+// the outlet in chunks from an auxiliary task.
+class StreamAggregator {
+public:
+    struct Source {
+        std::string name;
+        std::string type;
+        unsigned int firstChannel;
+        unsigned int channels;
+    };
+
+    StreamAggregator() {}
+
+    // Before open(): returns the source's index
+    unsigned int addSource(const std::string& name, const std::string& type, unsigned int channels);
+
+    // Create the outlet; allocates. `maxBuffered` is the outlet's buffer in
+    // samples (a MemoryBudget grant), or 0 for liblsl's 360 s.
+    bool open(const std::string& name, const std::string& type, double sampleRate, const std::string& sourceId,
+              unsigned int chunkFrames = 32, unsigned int capacity = 1024, int32_t maxBuffered = 0);
+    void close() { outlet.reset(); }
+    bool isOpen() const { return outlet != nullptr; }
+
+    // Producer side (one thread)
+    void update(unsigned int source, const float* values);
+    bool commit(double timestamp);
+
+    // Publisher task: push the queued frames. Returns the number pushed.
+    unsigned int publish();
+
+    unsigned int getNumSources() const { return sources.size(); }
+    const Source& getSource(unsigned int n) const { return sources[n]; }
+    unsigned int getNumChannels() const { return numChannels; }
+
+private:
+    std::vector<Source> sources;
+    unsigned int numChannels = 0;
+    std::vector<float> frame;
+    FrameRing ring;
+    unsigned int chunkFrames = 0;
+    std::vector<float> chunk;
+    std::vector<double> chunkTimestamps;
+    std::unique_ptr<lsl::stream_outlet> outlet;
+};
+
+// Splits a wide stream described as above back into per-source views. It
+// reads the desc()/streams entries of a full stream_info (from
+// stream_inlet::info()) and hands out pointers into pulled chunks, so a
+// consumer works on one source without copying.
+class StreamDemultiplexer {
+public:
+    struct View {
+        std::string name;
+        std::string type;
+        unsigned int firstChannel;
+        unsigned int channels;
+    };
+
+    StreamDemultiplexer() {}
+
+    // Returns false if the stream has no (valid) channel ranges
+    bool setup(lsl::stream_info info);
+
+    unsigned int getNumViews() const { return views.size(); }
+    const View& getView(unsigned int n) const { return views[n]; }
+    // The view with this name, or -1
+    int find(const std::string& name) const;
+
+    // A view's channels in frame `frame` of an interleaved chunk of the wide
+    // stream; the view's channels are contiguous from there
+    const float* getFrame(unsigned int view, const float* chunk, unsigned int frame) const
+    {
+        return chunk + frame * numChannels + views[view].firstChannel;
+    }
+
+private:
+    std::vector<View> views;
+    unsigned int numChannels = 0;
+};
@@ -0,0 +1,130 @@
+#include "StreamIntegrityMonitor.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+double StreamIntegrityMonitor::Report::getJitterRms() const
+{
+    return inRange ? std::sqrt(jitterSquares / inRange) : 0.0;
+}
+
+bool StreamIntegrityMonitor::setup(double sampleRate, const Settings& settings)
+{
+    if (sampleRate <= 0.0 || settings.gapFactor <= 1.0f || settings.jitterFactor <= 0.0f)
+        return false;
+    this->sampleRate = sampleRate;
+    period = 1.0 / sampleRate;
+    gapThreshold = settings.gapFactor * period;
+    jitterThreshold = settings.jitterFactor * period;
+    hasPrevious = false;
+    report = Report();
+    return true;
+}
+
+void StreamIntegrityMonitor::check(const double* timestamps, unsigned int frames)
+{
+    if (frames == 0 || period == 0.0f)
+        return;
+
+    unsigned int f = 0;
+    if (!hasPrevious) {
+        previous = timestamps[0];
+        hasPrevious = true;
+        f = 1;
+    }
+
+    // offsets[0] is the previous sample, offsets[1..n] the next n samples
+    float offsets[kBlock + 1];
+    offsets[0] = 0.0f;
+    while (f < frames) {
+        unsigned int n = frames - f < kBlock ? frames - f : kBlock;
+        for (unsigned int i = 0; i < n; i++)
+            offsets[i + 1] = timestamps[f + i] - previous;
+        scan(offsets, n);
+        previous = timestamps[f + n - 1];
+        f += n;
+    }
+}
+
+void StreamIntegrityMonitor::scan(const float* offsets, unsigned int intervals)
+{
+    unsigned int gaps = 0, duplicates = 0, reordered = 0, outliers = 0, inRange = 0;
+    float missing = 0.0f, maxGap = 0.0f, squares = 0.0f;
+    unsigned int i = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float32x4_t vPeriod = vdupq_n_f32(period);
+    const float32x4_t vGap = vdupq_n_f32(gapThreshold);
+    const float32x4_t vJitter = vdupq_n_f32(jitterThreshold);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    // Comparison masks are all ones (-1) when true, so subtracting counts
+    uint32x4_t cGaps = vdupq_n_u32(0), cDuplicates = cGaps, cReordered = cGaps, cOutliers = cGaps, cInRange = cGaps;
+    float32x4_t sMissing = zero, sMaxGap = zero, sSquares = zero;
+    for (; i + 4 <= intervals; i += 4) {
+        float32x4_t d = vsubq_f32(vld1q_f32(offsets + i + 1), vld1q_f32(offsets + i));
+        float32x4_t deviation = vsubq_f32(d, vPeriod);
+        uint32x4_t gap = vcgtq_f32(d, vGap);
+        uint32x4_t duplicate = vceqq_f32(d, zero);
+        uint32x4_t reverse = vcltq_f32(d, zero);
+        uint32x4_t normal = vmvnq_u32(vorrq_u32(gap, vorrq_u32(duplicate, reverse)));
+        uint32x4_t outlier = vandq_u32(vcgtq_f32(vabsq_f32(deviation), vJitter), normal);
+
+        cGaps = vsubq_u32(cGaps, gap);
+        cDuplicates = vsubq_u32(cDuplicates, duplicate);
+        cReordered = vsubq_u32(cReordered, reverse);
+        cOutliers = vsubq_u32(cOutliers, outlier);
+        cInRange = vsubq_u32(cInRange, normal);
+        sMissing = vaddq_f32(sMissing, vbslq_f32(gap, deviation, zero));
+        sMaxGap = vmaxq_f32(sMaxGap, vbslq_f32(gap, d, zero));
+        float32x4_t inRangeDeviation = vbslq_f32(normal, deviation, zero);
+        sSquares = vmlaq_f32(sSquares, inRangeDeviation, inRangeDeviation);
+    }
+    uint32_t lanes[4];
+    float sums[4];
+    vst1q_u32(lanes, cGaps);
+    gaps = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    vst1q_u32(lanes, cDuplicates);
+    duplicates = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    vst1q_u32(lanes, cReordered);
+    reordered = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    vst1q_u32(lanes, cOutliers);
+    outliers = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    vst1q_u32(lanes, cInRange);
+    inRange = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    vst1q_f32(sums, sMissing);
+    missing = sums[0] + sums[1] + sums[2] + sums[3];
+    vst1q_f32(sums, sMaxGap);
+    maxGap = std::max(std::max(sums[0], sums[1]), std::max(sums[2], sums[3]));
+    vst1q_f32(sums, sSquares);
+    squares = sums[0] + sums[1] + sums[2] + sums[3];
+#endif
+    for (; i < intervals; i++) {
+        float d = offsets[i + 1] - offsets[i];
+        float deviation = d - period;
+        if (d > gapThreshold) {
+            gaps++;
+            missing += deviation;
+            maxGap = std::max(maxGap, d);
+        } else if (d == 0.0f) {
+            duplicates++;
+        } else if (d < 0.0f) {
+            reordered++;
+        } else {
+            inRange++;
+            squares += deviation * deviation;
+            if (std::fabs(deviation) > jitterThreshold)
+                outliers++;
+        }
+    }
+
+    report.intervals += intervals;
+    report.gaps += gaps;
+    report.duplicates += duplicates;
+    report.reordered += reordered;
+    report.jitterOutliers += outliers;
+    report.inRange += inRange;
+    report.missingSeconds += missing;
+    report.maxGapSeconds = std::max(report.maxGapSeconds, (double)maxGap);
+    report.jitterSquares += squares;
+}
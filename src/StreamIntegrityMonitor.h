@@ -0,0 +1,72 @@
+#pragma once
+
+// Detects lost, duplicated and reordered samples of a regular-rate stream
+// from the timestamps of its pulled chunks.
+//
+// Every interval between consecutive timestamps (including the one across
+// chunk boundaries) is compared with 1 / nominal_srate():
+//   - gap:       longer than gapFactor periods; the excess counts as missing
+//   - duplicate: zero
+//   - reordered: negative
+//   - jitter outlier: otherwise more than jitterFactor periods off
+// Intervals in range also feed an RMS jitter estimate. A sample that arrives
+// out of order is counted as reordered, and the jump back to the stream's
+// time after it as a gap.
+//
+// ARMv7 NEON has no double-precision lanes, so check() first converts the
+// timestamps to float offsets from the previous sample (exact to well under
+// a microsecond over a chunk) and then classifies four intervals per vector
+// with no branches. The cost per chunk is fixed and linear in its length,
+// and nothing is allocated, so the monitor can stay on in production.
+class StreamIntegrityMonitor {
+public:
+    struct Settings {
+        float gapFactor = 1.5f;
+        float jitterFactor = 0.25f;
+    };
+
+    struct Report {
+        unsigned long intervals = 0;
+        unsigned long gaps = 0;
+        unsigned long duplicates = 0;
+        unsigned long reordered = 0;
+        unsigned long jitterOutliers = 0;
+        double missingSeconds = 0.0; // sum over gaps of the time beyond one period
+        double maxGapSeconds = 0.0;
+        double jitterSquares = 0.0;  // sum of squared deviations of in-range intervals
+        unsigned long inRange = 0;
+
+        unsigned long getEstimatedLost(double sampleRate) const { return missingSeconds * sampleRate + 0.5; }
+        double getJitterRms() const;
+        unsigned long getAnomalies() const { return gaps + duplicates + reordered; }
+    };
+
+    StreamIntegrityMonitor() {}
+
+    // Returns false for irregular streams
+    bool setup(double sampleRate) { return setup(sampleRate, Settings()); }
+    bool setup(double sampleRate, const Settings& settings);
+
+    // Forget the previous chunk, e.g. after a reconnection
+    void restart() { hasPrevious = false; }
+
+    // Inspect the timestamps of one pulled chunk
+    void check(const double* timestamps, unsigned int frames);
+
+    const Report& getReport() const { return report; }
+    void clearReport() { report = Report(); }
+    double getSampleRate() const { return sampleRate; }
+
+private:
+    static constexpr unsigned int kBlock = 64;
+
+    void scan(const float* offsets, unsigned int intervals);
+
+    double sampleRate = 0.0;
+    float period = 0.0f;
+    float gapThreshold = 0.0f;
+    float jitterThreshold = 0.0f;
+    double previous = 0.0;
+    bool hasPrevious = false;
+    Report report;
+};
@@ -0,0 +1,142 @@
+#include "StreamMetadataCache.h"
+#include <algorithm>
+#include <iterator>
+
+int StreamMetadataCache::Metadata::findChannel(const std::string& label) const
+{
+    auto it = std::find(labels.begin(), labels.end(), label);
+    return it == labels.end() ? -1 : it - labels.begin();
+}
+
+void StreamMetadataCache::setup(unsigned int maxEntries, double timeout, unsigned int maxAttempts,
+                                double retryAfter, double maxRetryAfter)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->maxEntries = std::max(maxEntries, 1u);
+    this->timeout = timeout;
+    this->maxAttempts = std::max(maxAttempts, 1u);
+    this->retryAfter = retryAfter;
+    this->maxRetryAfter = std::max(maxRetryAfter, retryAfter);
+    entries.clear();
+    order.clear();
+    pending.clear();
+    failed.clear();
+    numPending = 0;
+}
+
+bool StreamMetadataCache::request(const lsl::stream_info& info)
+{
+    std::string uid = info.uid();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.count(uid))
+        return false;
+    auto failure = failed.find(uid);
+    if (failure != failed.end() && lsl::local_clock() < failure->second.retryAt)
+        return false;
+    for (const auto& queued : pending)
+        if (queued.uid == uid)
+            return false;
+    pending.push_back({info, uid, 0});
+    numPending = pending.size();
+    return true;
+}
+
+void StreamMetadataCache::process()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    // Each request is tried once per call, so a stream that does not
+    // answer waits for the next call instead of holding up the others
+    for (std::size_t n = pending.size(); n > 0 && !pending.empty(); n--) {
+        Request request = pending.front();
+        pending.pop_front();
+        lock.unlock();
+
+        Handle metadata;
+        bool retry = false;
+        try {
+            metadata = fetch(request.info);
+        } catch (lsl::timeout_error&) {
+            retry = ++request.attempts < maxAttempts;
+        } catch (std::exception&) {
+            // Lost, or never there
+        }
+        if (metadata) {
+            store(request.uid, metadata);
+            if (listener)
+                listener(request.uid, metadata);
+        } else if (!retry) {
+            failures.fetch_add(1, std::memory_order_relaxed);
+            fail(request.uid);
+        }
+
+        lock.lock();
+        if (retry)
+            pending.push_back(request);
+        numPending = pending.size();
+    }
+}
+
+StreamMetadataCache::Handle StreamMetadataCache::fetch(const lsl::stream_info& info)
+{
+    // Only the info is requested; no samples are streamed to this inlet
+    lsl::stream_inlet inlet(info, 1);
+    std::shared_ptr<Metadata> metadata = std::make_shared<Metadata>();
+    metadata->info = inlet.info(timeout);
+
+    unsigned int channels = std::max(metadata->info.channel_count(), 0);
+    metadata->labels.resize(channels);
+    metadata->units.resize(channels);
+    metadata->types.resize(channels);
+    lsl::xml_element channel = metadata->info.desc().child("channels").child("channel");
+    for (unsigned int n = 0; n < channels && !channel.empty(); n++, channel = channel.next_sibling("channel")) {
+        metadata->labels[n] = channel.child_value("label");
+        metadata->units[n] = channel.child_value("unit");
+        metadata->types[n] = channel.child_value("type");
+    }
+    return metadata;
+}
+
+void StreamMetadataCache::store(const std::string& uid, const Handle& metadata)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    failed.erase(uid);
+    if (!entries.count(uid))
+        order.push_back(uid);
+    entries[uid] = metadata;
+    while (entries.size() > maxEntries) {
+        entries.erase(order.front());
+        order.pop_front();
+    }
+    version.fetch_add(1, std::memory_order_release);
+}
+
+void StreamMetadataCache::fail(const std::string& uid)
+{
+    double now = lsl::local_clock();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = failed.find(uid);
+    if (it == failed.end()) {
+        // Make room by forgetting whatever may be retried already, or else
+        // the uid due soonest
+        if (failed.size() >= maxEntries) {
+            for (auto f = failed.begin(); f != failed.end();)
+                f = f->second.retryAt <= now ? failed.erase(f) : std::next(f);
+        }
+        if (failed.size() >= maxEntries)
+            failed.erase(std::min_element(failed.begin(), failed.end(), [](const std::pair<const std::string, Failure>& a,
+                                                                           const std::pair<const std::string, Failure>& b) {
+                return a.second.retryAt < b.second.retryAt;
+            }));
+        it = failed.insert({uid, {0.0, retryAfter}}).first;
+    } else {
+        it->second.backoff = std::min(it->second.backoff * 2.0, maxRetryAfter);
+    }
+    it->second.retryAt = now + it->second.backoff;
+}
+
+StreamMetadataCache::Handle StreamMetadataCache::find(const std::string& uid) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(uid);
+    return it == entries.end() ? nullptr : it->second;
+}
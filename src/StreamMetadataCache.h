@@ -0,0 +1,99 @@
+#pragma once
+
+#include <lsl_cpp.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Fetches the full stream_info (with desc()) of streams off the tasks that
+// need it, and keeps it.
+//
+// The info a resolver returns has no desc(); getting it takes
+// stream_inlet::info(), a network round-trip that blocks for up to its
+// timeout and is repeated on every call. request() only queues the stream;
+// process(), run on a low-priority worker task, connects a throwaway inlet,
+// fetches the full info, picks out the per-channel label, unit and type from
+// desc()/channels once, and caches the result by uid(). Consumers look it up
+// with find(), or watch getVersion() to know when to look, or get a listener
+// call on the worker.
+//
+// A stream that does not answer is tried again on later process() calls,
+// up to maxAttempts times. After that its uid is remembered and request()
+// turns it away for `retryAfter` seconds, twice as long after each further
+// failure up to maxRetryAfter, so a resolve loop that keeps seeing a dead
+// stream does not keep queueing it. Once maxEntries are cached, the oldest
+// goes; as many failed uids are remembered.
+//
+// Threading: request(), find() and getVersion() may be called from any task
+// and never wait on the network; process() must run on one task only.
+class StreamMetadataCache {
+public:
+    struct Metadata {
+        lsl::stream_info info;           // full info; copy it to call desc()
+        std::vector<std::string> labels; // per channel, empty where not given
+        std::vector<std::string> units;
+        std::vector<std::string> types;
+
+        // The first channel with this label, or -1
+        int findChannel(const std::string& label) const;
+    };
+    typedef std::shared_ptr<const Metadata> Handle;
+    typedef std::function<void(const std::string& uid, const Handle& metadata)> Listener;
+
+    StreamMetadataCache() {}
+
+    void setup(unsigned int maxEntries = 64, double timeout = 2.0, unsigned int maxAttempts = 3,
+               double retryAfter = 10.0, double maxRetryAfter = 300.0);
+    // Called on the worker task after each stream is cached
+    void setListener(const Listener& listener) { this->listener = listener; }
+
+    // Queue a fetch. Returns false if the stream is already cached or
+    // queued, or failed and is still backing off.
+    bool request(const lsl::stream_info& info);
+    bool hasPending() const { return numPending.load(std::memory_order_acquire) > 0; }
+
+    // Fetch everything queued; blocks for up to `timeout` per stream
+    void process();
+
+    // The cached metadata, or nullptr if it is not (yet) there
+    Handle find(const std::string& uid) const;
+    // Increases whenever an entry is added
+    unsigned int getVersion() const { return version.load(std::memory_order_acquire); }
+    unsigned long getFailures() const { return failures.load(std::memory_order_relaxed); }
+
+private:
+    struct Request {
+        lsl::stream_info info;
+        std::string uid;
+        unsigned int attempts;
+    };
+    struct Failure {
+        double retryAt;  // lsl::local_clock() time it may be requested again
+        double backoff;  // s, doubled on each failure
+    };
+
+    Handle fetch(const lsl::stream_info& info);
+    void store(const std::string& uid, const Handle& metadata);
+    void fail(const std::string& uid);
+
+    unsigned int maxEntries = 64;
+    double timeout = 2.0;
+    unsigned int maxAttempts = 3;
+    double retryAfter = 10.0;
+    double maxRetryAfter = 300.0;
+    Listener listener;
+
+    mutable std::mutex mutex; // guards everything below
+    std::map<std::string, Handle> entries;
+    std::deque<std::string> order; // cached uids, oldest first
+    std::deque<Request> pending;
+    std::map<std::string, Failure> failed;
+    std::atomic<unsigned int> numPending{0};
+    std::atomic<unsigned int> version{0};
+    std::atomic<unsigned long> failures{0};
+};
@@ -0,0 +1,139 @@
+#include "StreamRelay.h"
+#include <cstdint>
+
+static unsigned int valueBytes(lsl::channel_format_t format)
+{
+    switch (format) {
+    case lsl::cf_float32:
+    case lsl::cf_int32:
+        return 4;
+    case lsl::cf_double64:
+    case lsl::cf_int64:
+        return 8;
+    case lsl::cf_int16:
+        return 2;
+    case lsl::cf_int8:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+bool StreamRelay::open(const lsl::stream_info& info, const std::string& suffix, MemoryBudget& budget,
+                       unsigned int maxChunkFrames, double timeout)
+{
+    close();
+    format = info.channel_format();
+    channels = info.channel_count();
+    if (channels == 0 || maxChunkFrames == 0 || (format != lsl::cf_string && valueBytes(format) == 0))
+        return false;
+
+    this->budget = &budget;
+    inletBuffer = budget.reserve(info, MemoryBudget::realtime);
+    outletBuffer = budget.reserve(info, MemoryBudget::interactive);
+    if (!inletBuffer || !outletBuffer) {
+        close();
+        return false;
+    }
+    try {
+        inlet.reset(new lsl::stream_inlet(info, inletBuffer.samples, 0, true, transp_bufsize_samples));
+        inlet->set_postprocessing(lsl::post_clocksync);
+        lsl::stream_info full = inlet->info(timeout);
+        name = full.name();
+        sourceId = full.source_id();
+        relayId = sourceId + suffix;
+
+        lsl::stream_info relayed(full.name(), full.type(), full.channel_count(), full.nominal_srate(),
+                                 full.channel_format(), relayId);
+        for (lsl::xml_element e = full.desc().first_child(); !e.empty(); e = e.next_sibling())
+            relayed.desc().append_copy(e);
+        relayed.desc().append_child("relay")
+            .append_child_value("source_id", sourceId)
+            .append_child_value("uid", full.uid())
+            .append_child_value("hostname", full.hostname());
+        outlet.reset(new lsl::stream_outlet(relayed, 0, outletBuffer.samples, transp_bufsize_samples));
+        inlet->open_stream(timeout);
+    } catch (lsl::timeout_error&) {
+        close();
+        return false;
+    } catch (...) {
+        close();
+        throw;
+    }
+
+    this->maxChunkFrames = maxChunkFrames;
+    if (format == lsl::cf_string)
+        strings.resize(maxChunkFrames * channels);
+    else
+        data.resize(maxChunkFrames * channels * valueBytes(format));
+    timestamps.resize(maxChunkFrames);
+    framesRelayed = 0;
+    opened.store(true, std::memory_order_release);
+    return true;
+}
+
+void StreamRelay::close()
+{
+    if (inlet)
+        inlet->close_stream();
+    outlet.reset();
+    inlet.reset();
+    if (budget) {
+        budget->release(inletBuffer);
+        budget->release(outletBuffer);
+    }
+    inletBuffer = MemoryBudget::Grant();
+    outletBuffer = MemoryBudget::Grant();
+    opened.store(false, std::memory_order_release);
+}
+
+template <typename T>
+unsigned int StreamRelay::relayAs(T* buffer)
+{
+    unsigned int frames = 0;
+    size_t elements;
+    // Drain the inlet, one buffer-full at a time
+    while ((elements = inlet->pull_chunk_multiplexed(buffer, timestamps.data(), maxChunkFrames * channels,
+                                                     maxChunkFrames, 0.0)) > 0) {
+        outlet->push_chunk_multiplexed(buffer, timestamps.data(), elements);
+        frames += elements / channels;
+        if (elements < maxChunkFrames * channels)
+            break;
+    }
+    return frames;
+}
+
+unsigned int StreamRelay::relay()
+{
+    if (!isOpen())
+        return 0;
+
+    unsigned int frames = 0;
+    switch (format) {
+    case lsl::cf_float32:
+        frames = relayAs(reinterpret_cast<float*>(data.data()));
+        break;
+    case lsl::cf_double64:
+        frames = relayAs(reinterpret_cast<double*>(data.data()));
+        break;
+    case lsl::cf_int64:
+        frames = relayAs(reinterpret_cast<int64_t*>(data.data()));
+        break;
+    case lsl::cf_int32:
+        frames = relayAs(reinterpret_cast<int32_t*>(data.data()));
+        break;
+    case lsl::cf_int16:
+        frames = relayAs(reinterpret_cast<int16_t*>(data.data()));
+        break;
+    case lsl::cf_int8:
+        frames = relayAs(data.data());
+        break;
+    case lsl::cf_string:
+        frames = relayAs(strings.data());
+        break;
+    default:
+        break;
+    }
+    framesRelayed += frames;
+    return frames;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <lsl_cpp.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "MemoryBudget.h"
+
+// Republishes a received stream under a new source_id, so that many
+// consumers connect to the relay and the original sender serves only one.
+//
+// open() connects an inlet, fetches the full stream_info (including desc())
+// and creates an outlet with the same name, type, channels, rate, format and
+// metadata, and a source_id of "<original>" + suffix. desc()/relay records
+// where the stream came from. relay() pulls whatever has arrived and pushes
+// it on as one chunk with per-sample timestamps. Samples are pulled and
+// pushed in the stream's own channel format, so liblsl converts nothing.
+//
+// Both buffers come out of a MemoryBudget: open() reserves the inlet's as
+// realtime, since relay() drains it every block, and the outlet's as
+// interactive, for consumers that pull in chunks. close() returns them.
+//
+// Timestamps keep the sample times the sender gave them. The inlet applies
+// clock synchronisation so they are expressed in the relay's clock, which is
+// the clock the relay's own consumers correct against.
+//
+// Threading: open() and relay() may run on different tasks, but close()
+// must run on the task that calls relay(). isOpen() becomes true at the end
+// of open() and false at the end of close().
+class StreamRelay {
+public:
+    StreamRelay() {}
+    ~StreamRelay() { close(); }
+
+    // Returns false for unsupported formats, if `budget` cannot cover the
+    // buffers or if the stream does not answer within `timeout`; throws what
+    // the inlet and outlet constructors throw
+    bool open(const lsl::stream_info& info, const std::string& suffix, MemoryBudget& budget,
+              unsigned int maxChunkFrames = 512, double timeout = 2.0);
+    void close();
+    bool isOpen() const { return opened.load(std::memory_order_acquire); }
+
+    // Move what has arrived to the outlet. Returns the number of frames
+    // relayed; throws lsl::lost_error once the source has gone.
+    unsigned int relay();
+
+    // The source_id of the original stream and of the relayed one
+    const std::string& getSourceId() const { return sourceId; }
+    const std::string& getRelayId() const { return relayId; }
+    const std::string& getName() const { return name; }
+    unsigned long getFramesRelayed() const { return framesRelayed; }
+
+private:
+    template <typename T>
+    unsigned int relayAs(T* buffer);
+
+    std::unique_ptr<lsl::stream_inlet> inlet;
+    std::unique_ptr<lsl::stream_outlet> outlet;
+    MemoryBudget* budget = nullptr;
+    MemoryBudget::Grant inletBuffer;
+    MemoryBudget::Grant outletBuffer;
+    lsl::channel_format_t format = lsl::cf_undefined;
+    unsigned int channels = 0;
+    unsigned int maxChunkFrames = 0;
+    std::vector<char> data;             // maxChunkFrames * channels values of `format`
+    std::vector<std::string> strings;   // the same, for string streams
+    std::vector<double> timestamps;
+    std::string name;
+    std::string sourceId;
+    std::string relayId;
+    unsigned long framesRelayed = 0;
+    std::atomic<bool> opened{false};
+};
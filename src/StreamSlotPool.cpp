@@ -0,0 +1,86 @@
+#include "StreamSlotPool.h"
+#include <cstring>
+#include <new>
+
+namespace {
+void copyText(char* dest, const char* src)
+{
+    std::strncpy(dest, src, StreamSlotPool::kMaxText - 1);
+    dest[StreamSlotPool::kMaxText - 1] = '\0';
+}
+} // namespace
+
+StreamSlotPool::~StreamSlotPool()
+{
+    for (unsigned int n = 0; n < numSlots; n++)
+        if (slots[n].bound.load(std::memory_order_acquire))
+            unbind(&slots[n]);
+}
+
+bool StreamSlotPool::setup(unsigned int maxStreams, unsigned int maxChannels, unsigned int maxFrames)
+{
+    if (maxStreams == 0 || maxChannels == 0 || maxFrames == 0 || slots)
+        return false;
+
+    numSlots = maxStreams;
+    this->maxChannels = maxChannels;
+    slots.reset(new Slot[maxStreams]);
+    data.assign(maxStreams * maxFrames * maxChannels, 0.0f);
+    timestamps.assign(maxStreams * maxFrames, 0.0);
+    for (unsigned int n = 0; n < maxStreams; n++) {
+        slots[n].index = n;
+        slots[n].data = &data[n * maxFrames * maxChannels];
+        slots[n].timestamps = &timestamps[n * maxFrames];
+        slots[n].maxFrames = maxFrames;
+    }
+    return true;
+}
+
+StreamSlotPool::Slot* StreamSlotPool::bind(const lsl::stream_info& info, int32_t maxBuflen, int32_t maxChunklen, bool recover, lsl_transport_options_t flags)
+{
+    if (info.channel_count() <= 0 || (unsigned int)info.channel_count() > maxChannels)
+        return nullptr;
+
+    for (unsigned int n = 0; n < numSlots; n++) {
+        Slot& slot = slots[n];
+        if (slot.bound.load(std::memory_order_acquire))
+            continue;
+
+        slot.inlet = new (&slot.storage) lsl::stream_inlet(info, maxBuflen, maxChunklen, recover, flags);
+        copyText(slot.name, lsl_get_name(info.handle().get()));
+        copyText(slot.type, lsl_get_type(info.handle().get()));
+        copyText(slot.uid, lsl_get_uid(info.handle().get()));
+        copyText(slot.sourceId, lsl_get_source_id(info.handle().get()));
+        slot.channels = info.channel_count();
+        slot.sampleRate = info.nominal_srate();
+        slot.format = info.channel_format();
+        slot.bound.store(true, std::memory_order_release);
+        return &slot;
+    }
+    return nullptr;
+}
+
+void StreamSlotPool::unbind(Slot* slot)
+{
+    slot->active.store(false, std::memory_order_release);
+    slot->inlet->close_stream();
+    slot->inlet->~stream_inlet();
+    slot->inlet = nullptr;
+    slot->bound.store(false, std::memory_order_release);
+}
+
+StreamSlotPool::Slot* StreamSlotPool::find(const char* uid)
+{
+    for (unsigned int n = 0; n < numSlots; n++)
+        if (slots[n].isActive() && std::strncmp(slots[n].uid, uid, kMaxText - 1) == 0)
+            return &slots[n];
+    return nullptr;
+}
+
+unsigned int StreamSlotPool::getNumActive() const
+{
+    unsigned int active = 0;
+    for (unsigned int n = 0; n < numSlots; n++)
+        active += slots[n].isActive();
+    return active;
+}
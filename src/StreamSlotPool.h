@@ -0,0 +1,91 @@
+#pragma once
+
+#include <lsl_cpp.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// A fixed number of stream slots, each with preallocated sample buffers,
+// metadata fields and storage for one lsl::stream_inlet.
+//
+// setup() does all the allocation. Binding a stream constructs its inlet in
+// the slot's own storage and copies the metadata into fixed-size fields;
+// unbinding destroys the inlet in place. No buffers, names or inlet objects
+// are allocated or freed as streams come and go, so a sketch can run for
+// days without fragmenting the heap. (liblsl still allocates its own
+// connection state, and lsl::stream_inlet its shared handle, per bind.)
+//
+// Threading: one task binds (the resolver), one task unbinds (the puller),
+// and consumers only look at slots for which isActive() returns true. A slot
+// becomes active once activate() is called after bind() and stops being
+// active at the start of unbind().
+class StreamSlotPool {
+public:
+    static constexpr unsigned int kMaxText = 64;
+
+    struct Slot {
+        unsigned int index = 0;
+
+        // Copied from the stream_info when bound; truncated if longer
+        char name[kMaxText] = {};
+        char type[kMaxText] = {};
+        char uid[kMaxText] = {};
+        char sourceId[kMaxText] = {};
+
+        // Describes the samples in `data`. bind() fills these in from the
+        // stream_info; change them before activate() if the samples are
+        // decoded into another shape (at most getMaxChannels() channels).
+        unsigned int channels = 0;
+        double sampleRate = 0.0;
+        lsl::channel_format_t format = lsl::cf_undefined;
+
+        // maxFrames * maxChannels interleaved samples and maxFrames timestamps
+        float* data = nullptr;
+        double* timestamps = nullptr;
+        unsigned int maxFrames = 0;
+
+        // Valid from bind() to unbind()
+        lsl::stream_inlet* inlet = nullptr;
+
+        bool isActive() const { return active.load(std::memory_order_acquire); }
+
+    private:
+        friend class StreamSlotPool;
+        std::atomic<bool> bound{false};
+        std::atomic<bool> active{false};
+        std::aligned_storage<sizeof(lsl::stream_inlet), alignof(lsl::stream_inlet)>::type storage;
+    };
+
+    StreamSlotPool() {}
+    ~StreamSlotPool();
+
+    bool setup(unsigned int maxStreams, unsigned int maxChannels, unsigned int maxFrames);
+
+    // Open an inlet in a free slot. Returns nullptr if every slot is in use
+    // or the stream has too many channels. Throws what the inlet constructor
+    // throws, leaving the slot free. Pass transp_bufsize_samples in
+    // `flags` to give maxBuflen in samples rather than seconds.
+    Slot* bind(const lsl::stream_info& info, int32_t maxBuflen = 360, int32_t maxChunklen = 0, bool recover = true,
+               lsl_transport_options_t flags = transp_default);
+    // Publish a bound slot to the consumers
+    void activate(Slot* slot) { slot->active.store(true, std::memory_order_release); }
+    // Close and destroy the inlet and free the slot
+    void unbind(Slot* slot);
+
+    // The active slot bound to the stream with this uid, or nullptr
+    Slot* find(const char* uid);
+
+    unsigned int getNumSlots() const { return numSlots; }
+    unsigned int getNumActive() const;
+    unsigned int getMaxChannels() const { return maxChannels; }
+    Slot& operator[](unsigned int n) { return slots[n]; }
+
+private:
+    unsigned int numSlots = 0;
+    unsigned int maxChannels = 0;
+    std::unique_ptr<Slot[]> slots;
+    std::vector<float> data;
+    std::vector<double> timestamps;
+};
@@ -0,0 +1,210 @@
+#include "StreamSynchroniser.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+// Jump ahead instead of emitting frames for a gap longer than this
+const double kMaxBacklogSeconds = 1.0;
+} // namespace
+
+bool StreamSynchroniser::setup(unsigned int maxStreams, unsigned int maxChannels, double outputRate, double latency, unsigned int capacity)
+{
+    if (maxStreams == 0 || maxChannels == 0 || outputRate <= 0.0 || latency < 0.0 || capacity == 0)
+        return false;
+
+    this->maxStreams = maxStreams;
+    this->maxChannels = maxChannels;
+    this->capacity = capacity;
+    this->outputRate = outputRate;
+    this->latency = latency;
+    streams.reset(new Stream[maxStreams]);
+    for (unsigned int s = 0; s < maxStreams; s++) {
+        // Size every ring for the widest stream so attach() never allocates
+        streams[s].ring.setup(maxChannels, capacity);
+        streams[s].previous.assign(maxChannels, 0.0f);
+        streams[s].next.assign(maxChannels, 0.0f);
+    }
+    heap.assign(maxStreams, 0);
+    heapSize = 0;
+    numChannels = 0;
+    started = false;
+    return true;
+}
+
+bool StreamSynchroniser::attach(unsigned int stream, unsigned int channels, double sampleRate, Mode mode, unsigned int frames)
+{
+    if (stream >= maxStreams || channels == 0 || channels > maxChannels || frames > capacity
+        || streams[stream].attached)
+        return false;
+
+    Stream& s = streams[stream];
+    // No larger than the ring setup() sized, so this does not allocate
+    s.ring.setup(channels, frames ? frames : capacity);
+    s.channels = channels;
+    s.sampleRate = sampleRate;
+    s.mode = mode;
+    s.newest.store(0.0, std::memory_order_relaxed);
+    s.dropped.store(0, std::memory_order_relaxed);
+    s.hasPrevious = false;
+    s.hasNext = false;
+    s.attached = true;
+    layout();
+    return true;
+}
+
+void StreamSynchroniser::detach(unsigned int stream)
+{
+    if (stream >= maxStreams || !streams[stream].attached)
+        return;
+
+    streams[stream].attached = false;
+    // Drop it from the heap and restore the heap order
+    unsigned int* end = std::remove(heap.data(), heap.data() + heapSize, stream);
+    heapSize = end - heap.data();
+    std::make_heap(heap.data(), end, [this](unsigned int a, unsigned int b) { return streams[a].nextTime > streams[b].nextTime; });
+    layout();
+}
+
+void StreamSynchroniser::layout()
+{
+    numChannels = 0;
+    for (unsigned int s = 0; s < maxStreams; s++) {
+        streams[s].channelOffset = numChannels;
+        if (streams[s].attached)
+            numChannels += streams[s].channels;
+    }
+    if (numChannels == 0)
+        started = false;
+}
+
+unsigned int StreamSynchroniser::push(unsigned int stream, const float* data, const double* timestamps, unsigned int frames, double offset)
+{
+    Stream& s = streams[stream];
+    unsigned int written = 0;
+    // Write in small runs so the offset can be applied without a scratch
+    // buffer the size of the chunk
+    double corrected[16];
+    while (written < frames) {
+        unsigned int run = std::min(frames - written, 16u);
+        for (unsigned int f = 0; f < run; f++)
+            corrected[f] = timestamps[written + f] + offset;
+        unsigned int accepted = s.ring.write(data + written * s.channels, corrected, run);
+        written += accepted;
+        if (accepted)
+            s.newest.store(std::max(s.newest.load(std::memory_order_relaxed), corrected[accepted - 1]), std::memory_order_release);
+        if (accepted < run)
+            break;
+    }
+    if (written < frames)
+        s.dropped.fetch_add(frames - written, std::memory_order_relaxed);
+    return written;
+}
+
+bool StreamSynchroniser::load(unsigned int stream)
+{
+    Stream& s = streams[stream];
+    if (s.ring.read(s.next.data(), &s.nextTime, 1) == 0)
+        return false;
+    s.hasNext = true;
+    heapPush(stream);
+    return true;
+}
+
+void StreamSynchroniser::heapPush(unsigned int stream)
+{
+    heap[heapSize++] = stream;
+    std::push_heap(heap.data(), heap.data() + heapSize, [this](unsigned int a, unsigned int b) { return streams[a].nextTime > streams[b].nextTime; });
+}
+
+unsigned int StreamSynchroniser::heapPop()
+{
+    std::pop_heap(heap.data(), heap.data() + heapSize, [this](unsigned int a, unsigned int b) { return streams[a].nextTime > streams[b].nextTime; });
+    return heap[--heapSize];
+}
+
+void StreamSynchroniser::sample(Stream& s, double time, float* out) const
+{
+    const float missing = std::numeric_limits<float>::quiet_NaN();
+    const float* source = nullptr;
+    switch (s.mode) {
+    case interpolate:
+        if (s.hasPrevious && s.hasNext && s.nextTime > s.previousTime) {
+            float frac = (time - s.previousTime) / (s.nextTime - s.previousTime);
+            for (unsigned int c = 0; c < s.channels; c++)
+                out[c] = s.previous[c] + frac * (s.next[c] - s.previous[c]);
+            return;
+        }
+        source = s.hasPrevious ? s.previous.data() : nullptr;
+        break;
+    case nearest:
+        if (s.hasPrevious && s.hasNext)
+            source = time - s.previousTime <= s.nextTime - time ? s.previous.data() : s.next.data();
+        else
+            source = s.hasPrevious ? s.previous.data() : s.hasNext ? s.next.data() : nullptr;
+        break;
+    case hold:
+        source = s.hasPrevious ? s.previous.data() : nullptr;
+        break;
+    }
+    for (unsigned int c = 0; c < s.channels; c++)
+        out[c] = source ? source[c] : missing;
+}
+
+unsigned int StreamSynchroniser::assemble(float* out, double* timestamps, unsigned int maxFrames)
+{
+    if (numChannels == 0)
+        return 0;
+
+    double newest = 0.0;
+    for (unsigned int s = 0; s < maxStreams; s++) {
+        if (!streams[s].attached)
+            continue;
+        if (!streams[s].hasNext)
+            load(s);
+        newest = std::max(newest, streams[s].newest.load(std::memory_order_acquire));
+    }
+
+    if (!started) {
+        if (heapSize == 0)
+            return 0;
+        nextIndex = (long long)std::ceil(streams[heap[0]].nextTime * outputRate);
+        started = true;
+    }
+    if (newest - nextIndex / outputRate > latency + kMaxBacklogSeconds)
+        nextIndex = (long long)std::ceil((newest - latency) * outputRate);
+
+    unsigned int frames = 0;
+    while (frames < maxFrames) {
+        double time = nextIndex / outputRate;
+        if (time > newest)
+            break;
+
+        // Merge every sample up to the output time, earliest first
+        while (heapSize && streams[heap[0]].nextTime <= time) {
+            Stream& s = streams[heapPop()];
+            s.previous.swap(s.next);
+            s.previousTime = s.nextTime;
+            s.hasPrevious = true;
+            s.hasNext = false;
+            load(&s - streams.get());
+        }
+
+        // Regular streams must have a sample past the output time, unless
+        // they have fallen more than `latency` behind
+        bool ready = true;
+        for (unsigned int s = 0; s < maxStreams && ready; s++)
+            if (streams[s].attached && streams[s].sampleRate > 0.0 && !streams[s].hasNext)
+                ready = newest - time > latency;
+        if (!ready)
+            break;
+
+        float* frame = out + frames * numChannels;
+        for (unsigned int s = 0; s < maxStreams; s++)
+            if (streams[s].attached)
+                sample(streams[s], time, frame + streams[s].channelOffset);
+        timestamps[frames++] = time;
+        nextIndex++;
+    }
+    return frames;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "FrameRing.h"
+
+// Assembles frames of several streams sampled at common times.
+//
+// Each stream's chunks are queued in its own FrameRing with timestamps in
+// the local clock (pull with lsl::post_clocksync, or pass the inlet's
+// time_correction() as the offset). assemble() merges the queued samples of
+// all streams in timestamp order through a min-heap keyed by each stream's
+// next sample, and emits one output frame every 1 / outputRate seconds on a
+// grid aligned to the local clock. Each output frame holds every attached
+// stream's channels in stream order, either interpolated between the
+// samples around the output time, taken from the nearest sample, or held
+// from the last sample before it. Channels of a stream with no usable
+// sample yet are NaN.
+//
+// An output time is emitted once every regular-rate stream has a sample
+// after it, or once it lies more than `latency` seconds behind the newest
+// sample of any stream, so a stalled stream delays the output by at most
+// that much. Irregular streams (markers) never hold the output back.
+//
+// push() may run on a different thread than assemble(); attach(), detach()
+// and assemble() must share one. setup() allocates; nothing else does.
+class StreamSynchroniser {
+public:
+    enum Mode {
+        interpolate, // linear between the samples either side
+        nearest,     // the closer of the samples either side
+        hold,        // the last sample at or before the output time
+    };
+
+    StreamSynchroniser() {}
+
+    // Room for streams 0 .. maxStreams - 1 of up to maxChannels channels,
+    // each buffering up to `capacity` frames
+    bool setup(unsigned int maxStreams, unsigned int maxChannels, double outputRate, double latency, unsigned int capacity);
+
+    // `sampleRate` is the stream's nominal rate, 0 for irregular streams.
+    // The stream buffers `frames` frames, at most the capacity given to
+    // setup(); 0 for all of it.
+    bool attach(unsigned int stream, unsigned int channels, double sampleRate, Mode mode, unsigned int frames = 0);
+    void detach(unsigned int stream);
+    bool isAttached(unsigned int stream) const { return streams[stream].attached; }
+
+    // Queue samples; `offset` is added to each timestamp. Returns the number
+    // of frames accepted; the rest are counted as dropped.
+    unsigned int push(unsigned int stream, const float* data, const double* timestamps, unsigned int frames, double offset = 0.0);
+    // Frames push() turned away for a full ring since the last call
+    unsigned long takeDropped(unsigned int stream) { return streams[stream].dropped.exchange(0, std::memory_order_relaxed); }
+
+    // Write up to maxFrames aligned frames of getNumChannels() channels.
+    // Returns the number of frames written.
+    unsigned int assemble(float* out, double* timestamps, unsigned int maxFrames);
+
+    // Channels per output frame, and where a stream's channels start in it
+    unsigned int getNumChannels() const { return numChannels; }
+    unsigned int getChannelOffset(unsigned int stream) const { return streams[stream].channelOffset; }
+    double getOutputRate() const { return outputRate; }
+
+private:
+    struct Stream {
+        bool attached = false;
+        unsigned int channels = 0;
+        unsigned int channelOffset = 0;
+        double sampleRate = 0.0;
+        Mode mode = interpolate;
+        FrameRing ring;
+        std::atomic<double> newest{0.0};
+        std::atomic<unsigned long> dropped{0};
+        // The samples either side of the output time
+        std::vector<float> previous;
+        std::vector<float> next;
+        double previousTime = 0.0;
+        double nextTime = 0.0;
+        bool hasPrevious = false;
+        bool hasNext = false;
+    };
+
+    bool load(unsigned int stream);
+    void heapPush(unsigned int stream);
+    unsigned int heapPop();
+    void layout();
+    void sample(Stream& stream, double time, float* out) const;
+
+    unsigned int maxStreams = 0;
+    unsigned int maxChannels = 0;
+    unsigned int capacity = 0;
+    double outputRate = 0.0;
+    double latency = 0.0;
+    unsigned int numChannels = 0;
+    std::unique_ptr<Stream[]> streams;
+    std::vector<unsigned int> heap; // stream indices, earliest next sample first
+    unsigned int heapSize = 0;
+    long long nextIndex = 0;        // output time = nextIndex / outputRate
+    bool started = false;
+};
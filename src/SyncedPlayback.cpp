@@ -0,0 +1,136 @@
+#include "SyncedPlayback.h"
+#include <algorithm>
+#include <cmath>
+
+bool SyncedPlayback::setup(unsigned int channels, double sampleRate, unsigned int capacity, const Settings& settings)
+{
+    if (channels == 0 || sampleRate <= 0.0 || settings.startGrid <= 0.0 || !ring.setup(channels, capacity))
+        return false;
+
+    this->settings = settings;
+    this->channels = channels;
+    this->sampleRate = sampleRate;
+    period = 1.0 / sampleRate;
+    previous.assign(channels, 0.0f);
+    next.assign(channels, 0.0f);
+    hasNext = false;
+    state = waiting;
+    startTime = 0.0;
+    error = 0.0;
+    errorIntegral = 0.0;
+    rate = 1.0;
+    relocks = 0;
+    underruns = 0;
+    return true;
+}
+
+unsigned int SyncedPlayback::write(const float* data, const double* timestamps, unsigned int frames)
+{
+    return ring.write(data, timestamps, frames);
+}
+
+bool SyncedPlayback::load()
+{
+    hasNext = ring.read(next.data(), &nextTime, 1) == 1;
+    return hasNext;
+}
+
+void SyncedPlayback::silence(float* out, unsigned int frames)
+{
+    std::fill(out, out + frames * channels, 0.0f);
+}
+
+// Find the start sample and return the output frame it plays on, or `frames`
+// if it does not fall in this block
+unsigned int SyncedPlayback::start(unsigned int frames, double sourceTime)
+{
+    if (!hasNext && !load())
+        return frames;
+
+    // The first grid point that is both buffered and still in the future
+    if (startTime == 0.0)
+        startTime = std::ceil(std::max(sourceTime, nextTime) / settings.startGrid) * settings.startGrid;
+    while (nextTime < startTime - 0.5 * period) {
+        if (!load())
+            return frames;
+    }
+    double offset = (nextTime - sourceTime) * sampleRate;
+    if (offset < 0.0) {
+        // Arrived too late to start on; pick the next grid point
+        startTime = 0.0;
+        return frames;
+    }
+    if (offset >= frames)
+        return frames;
+
+    // Play the start sample on the first output frame at or after its time
+    unsigned int frame = std::ceil(offset);
+    previous.swap(next);
+    previousTime = nextTime;
+    position = frame - offset;
+    hasNext = false;
+    state = playing;
+    error = 0.0;
+    errorIntegral = 0.0;
+    rate = 1.0;
+    return frame;
+}
+
+void SyncedPlayback::process(float* out, unsigned int frames, double blockTime)
+{
+    // The source time due on this block's first frame
+    double sourceTime = blockTime - correction.load(std::memory_order_relaxed) - settings.delay;
+
+    unsigned int n = 0;
+    if (state == waiting) {
+        n = start(frames, sourceTime);
+        silence(out, n);
+        if (state == waiting)
+            return;
+        sourceTime += n * period;
+    }
+
+    if (n == 0) {
+        // Adjust the rate towards the source time that is due
+        error = previousTime + position * period - sourceTime;
+        if (std::fabs(error) > settings.relockError) {
+            state = waiting;
+            startTime = 0.0;
+            relocks++;
+            silence(out, frames);
+            return;
+        }
+        double blockSeconds = frames * period;
+        errorIntegral += error * blockSeconds;
+        if (settings.integral > 0.0) {
+            double limit = settings.maxSkew / settings.integral;
+            errorIntegral = std::min(std::max(errorIntegral, -limit), limit);
+        }
+        double skew = settings.proportional * error + settings.integral * errorIntegral;
+        skew = std::min(std::max(skew, -settings.maxSkew), settings.maxSkew);
+        rate = 1.0 - skew;
+    }
+
+    for (; n < frames; n++) {
+        while (position >= 1.0 || !hasNext) {
+            if (hasNext) {
+                previous.swap(next);
+                previousTime = nextTime;
+                position -= 1.0;
+            }
+            if (!load()) {
+                // Out of data: stay silent until the next grid point
+                state = waiting;
+                startTime = 0.0;
+                underruns++;
+                silence(out + n * channels, frames - n);
+                return;
+            }
+        }
+        float* frame = out + n * channels;
+        float fraction = position;
+        for (unsigned int ch = 0; ch < channels; ch++)
+            frame[ch] = previous[ch] + fraction * (next[ch] - previous[ch]);
+        position += rate;
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "FrameRing.h"
+
+// Plays an audio stream so that several boards receiving it start on the
+// same sample and stay aligned.
+//
+// Every board maps the source's timestamps to its own local clock with the
+// inlet's time_correction() (local = source + correction) and plays the
+// sample stamped T when the source clock reads T + delay, with the same
+// delay on every board. The boards agree on where to start without talking
+// to each other: each one starts on the first sample whose timestamp is a
+// multiple of `startGrid` and that it can still play in time, so boards
+// started within the same grid interval begin on the same frame.
+//
+// Once playing, the difference between the source time being played and the
+// source time due is measured every block and fed to a PI loop that adjusts
+// the playback rate by up to `maxSkew` (linear interpolation between
+// frames), absorbing the drift between the source's and each board's audio
+// clock. If the error grows past `relockError`, e.g. after a dropout or a
+// reconnection, playback stops and starts again on the next grid point.
+//
+// Nothing here depends on Bela or liblsl: the audio thread passes in the
+// local time of each block's first frame (see FrameClock), so several
+// instances fed simulated clocks can stand in for several boards on one
+// host. write() and setCorrection() are called from one thread (the pull
+// task), process() from another (the audio thread). setup() allocates; a
+// later setup() with no more channels or capacity reuses the buffers.
+class SyncedPlayback {
+public:
+    enum State {
+        waiting, // for enough data to start on a grid point
+        playing,
+    };
+
+    struct Settings {
+        double delay = 0.2;        // from source timestamp to playout (s)
+        double startGrid = 0.5;    // start on source times that are multiples of this (s)
+        double relockError = 0.01; // restart when further off than this (s)
+        double maxSkew = 0.001;    // largest rate correction (1000 ppm)
+        double proportional = 1.0; // rate correction per second of error
+        double integral = 0.05;    // rate correction per second of error per second
+    };
+
+    SyncedPlayback() {}
+
+    bool setup(unsigned int channels, double sampleRate, unsigned int capacity, const Settings& settings);
+
+    // Producer side: frames of the source with their source timestamps
+    unsigned int getWriteAvailable() const { return ring.getWriteAvailable(); }
+    unsigned int write(const float* data, const double* timestamps, unsigned int frames);
+    // The inlet's latest time_correction()
+    void setCorrection(double correction) { this->correction.store(correction, std::memory_order_relaxed); }
+
+    // Audio thread: render `frames` interleaved frames of getNumChannels()
+    // channels, the first of which plays at local time `blockTime`
+    void process(float* out, unsigned int frames, double blockTime);
+
+    unsigned int getNumChannels() const { return channels; }
+    State getState() const { return state; }
+    double getError() const { return error; }          // played minus due source time (s)
+    double getRate() const { return rate; }            // source frames per output frame
+    unsigned long getRelocks() const { return relocks; }
+    unsigned long getUnderruns() const { return underruns; }
+
+private:
+    bool load();
+    unsigned int start(unsigned int frames, double sourceTime);
+    void silence(float* out, unsigned int frames);
+
+    Settings settings;
+    unsigned int channels = 0;
+    double sampleRate = 0.0;
+    double period = 0.0;
+    FrameRing ring;
+    std::atomic<double> correction{0.0};
+
+    // The frames either side of the playback position
+    std::vector<float> previous;
+    std::vector<float> next;
+    double previousTime = 0.0;
+    double nextTime = 0.0;
+    bool hasNext = false;
+    double position = 0.0;   // between previous (0) and next (1)
+
+    State state = waiting;
+    double startTime = 0.0;  // source time to start on, 0 until chosen
+    double error = 0.0;
+    double errorIntegral = 0.0;
+    double rate = 1.0;
+    unsigned long relocks = 0;
+    unsigned long underruns = 0;
+};
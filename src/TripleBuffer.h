@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+// Wait-free single-producer / single-consumer mailbox that always hands the
+// consumer the most recently published frame of `size` floats.
+//
+// The producer fills getWriteBuffer() and calls publish(); the consumer calls
+// update() and, if it returns true, reads getReadBuffer(). Neither side ever
+// blocks or copies: publishing and acquiring are a single atomic exchange of
+// buffer indices. Frames published while the consumer is not looking are
+// overwritten, which is exactly what control-rate data wants. Each frame can
+// carry a timestamp, published and acquired along with it.
+class TripleBuffer {
+public:
+    TripleBuffer() {}
+
+    // Allocates; call before the producer and consumer start.
+    void setup(unsigned int size)
+    {
+        this->size = size;
+        buffers.assign(3 * size, 0.0f);
+        timestamps[0] = timestamps[1] = timestamps[2] = 0.0;
+        back = 0;
+        middle = 1;
+        front = 2;
+    }
+
+    unsigned int getSize() const { return size; }
+
+    // Producer side
+    float* getWriteBuffer() { return &buffers[back * size]; }
+    void publish(double timestamp)
+    {
+        timestamps[back] = timestamp;
+        publish();
+    }
+    void publish()
+    {
+        back = middle.exchange(back | kFresh, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // Consumer side: returns true if a newer frame has been acquired
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & kFresh))
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+    const float* getReadBuffer() const { return &buffers[front * size]; }
+    double getReadTimestamp() const { return timestamps[front]; }
+
+private:
+    static constexpr unsigned int kFresh = 4;
+    static constexpr unsigned int kIndexMask = 3;
+
+    unsigned int size = 0;
+    std::vector<float> buffers;
+    double timestamps[3] = {};
+    unsigned int back = 0;            // owned by the producer
+    std::atomic<unsigned int> middle{1};
+    unsigned int front = 2;           // owned by the consumer
+};
@@ -1,33 +1,684 @@
 #include <Bela.h>
 #include <lsl_cpp.h>
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <atomic>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cmath>
+#include <mutex>
+#include <set>
+#include <unistd.h>
+#include "BandPowerExtractor.h"
+#include "BiquadBank.h"
+#include "DeadlinePuller.h"
+#include "DeltaPackCodec.h"
+#include "DeltaPackOutlet.h"
+#include "EventScheduler.h"
+#include "FrameRing.h"
+#include "InletWaiter.h"
+#include "LivenessWatchdog.h"
+#include "PullScheduler.h"
+#include "LslLoader.h"
+#include "MemoryBudget.h"
+#include "OverloadPolicy.h"
+#include "SharedMemoryStream.h"
+#include "Sonifier.h"
+#include "StreamAggregator.h"
+#include "StreamIntegrityMonitor.h"
+#include "StreamMetadataCache.h"
+#include "StreamRelay.h"
+#include "StreamSlotPool.h"
+#include "StreamSynchroniser.h"
+#include "TripleBuffer.h"
 
 // LSL stream handling
 std::vector<lsl::stream_info> availableStreams;
-std::vector<lsl::stream_inlet*> streamInlets;
-bool streamsResolved = false;
+std::atomic<bool> streamsResolved{false}; // set by the resolve and pull tasks, read in render()
 std::atomic<bool> shouldResolveStreams{true};
 float sampleTimeout = 0.0; // 0.0 for non-blocking
 
 // Continuous stream resolver for background discovery
 lsl::continuous_resolver* resolver = nullptr;
 
-// Buffer for storing stream data
-std::vector<std::vector<float>> streamData;
-std::vector<std::string> streamNames;
+// Maximum number of frames pulled from a stream per call
+const unsigned int CHUNK_FRAMES = 64;
+
+// The pull task runs as a loop while streams are bound, sleeping in an
+// InletWaiter until a stream has samples instead of polling every stream
+// every block. It wakes at least every PULL_WAIT seconds for the work that
+// is due regardless (synchronised output, reports).
+const double PULL_WAIT = 0.01; // s
+// cleanup() waits this long for the loop to notice the stop request
+const double PULL_STOP_TIMEOUT = 1.0; // s
+InletWaiter gInletWaiter;
+std::atomic<bool> gPulling{false};  // the pull loop is scheduled or running
+// Each wake-up serves audio and control streams first, then markers, then
+// bulk data, each within a budget of frames and time (see PullScheduler.h)
+PullScheduler gPullScheduler;
+
+// Streams are bound to a fixed set of slots whose buffers are allocated in
+// setup(), so nothing is allocated or freed here as streams come and go
+const unsigned int MAX_STREAMS = 8;
+const unsigned int MAX_STREAM_CHANNELS = 64;
+const unsigned int MAX_PACKET_FRAMES = 256; // largest delta-packed packet accepted
+StreamSlotPool gStreams;
+
+// Streams of type "<type>/delta" carry DeltaPackCodec packets of an integer
+// stream, one packet per byte-buffer sample; desc()/encoding describes the
+// original stream
+const std::string DELTA_TYPE_SUFFIX = "/delta";
+struct DeltaStream {
+    DeltaPackCodec codec;
+    double sampleRate;
+    unsigned int packetFrames;
+    std::vector<char> decoded; // packetFrames * channels samples of the original format
+};
+
+// Filtering applied to biosignal streams before they are used
+const float MAINS_FREQUENCY = 50.0f;     // 60.0f in the Americas
+const float HIGHPASS_FREQUENCY = 0.5f;   // remove electrode drift
+const float LOWPASS_FREQUENCY = 100.0f;  // skipped if above Nyquist
+const std::vector<std::string> FILTERED_STREAM_TYPES = {"EEG", "EMG", "ExG"};
+
+// Band power features, published as a new outlet per analysed stream
+const std::vector<std::string> BAND_POWER_STREAM_TYPES = {"EEG"};
+const BandPowerExtractor::Settings BAND_POWER_SETTINGS = {
+    256, // window (frames)
+    64,  // hop (frames), 75% overlap
+    4,   // windows per outlet push
+    {
+        { "delta", 1.0f, 4.0f },
+        { "theta", 4.0f, 8.0f },
+        { "alpha", 8.0f, 13.0f },
+        { "beta", 13.0f, 30.0f },
+        { "gamma", 30.0f, 45.0f },
+    },
+};
+
+// How a stream's samples are consumed. Queued streams go through every
+// sample (printing, features, synchronisation); latest-value streams only
+// hand their newest frame to render() through a wait-free mailbox, which is
+// all that control-style streams need.
+enum ConsumerMode {
+    queued,
+    latestValue,
+};
+const std::vector<std::string> LATEST_VALUE_STREAM_TYPES = {"IMU", "Control", "Mocap"};
+// Channels of the newest latest-value frame written to the analog outputs,
+// clamped to 0..1 (first latest-value stream only)
+const bool LATEST_VALUE_ANALOG_OUT = false;
+// Latest-value streams publish the newest sample taken at least this long
+// ago, so network jitter does not change which sample a block gets. Samples
+// not yet due wait in a lookahead of LATEST_VALUE_LOOKAHEAD frames.
+const double LATEST_VALUE_DELAY = 0.02; // s, 0 for the newest that has arrived
+const unsigned int LATEST_VALUE_LOOKAHEAD = 256;
+
+// When the pull task falls behind a stream, its latency is bounded by an
+// OverloadPolicy once more than maxLatency of samples is queued in the inlet
+// (see OverloadPolicy.h). Audio drops its oldest samples, latest-value
+// streams keep only the newest, and streams that are only printed and
+// sonified pass on one frame in `decimation` until they catch up. Markers
+// and streams with band power features keep every sample.
+const double LIVE_MAX_LATENCY = 0.1;       // s queued before audio drops samples
+const double LIVE_RECOVER_LATENCY = 0.02;  // s of audio kept when it does
+const double CONTROL_MAX_LATENCY = 0.05;   // s queued before latest-value streams skip ahead
+const double BULK_MAX_LATENCY = 0.5;       // s queued before other streams are decimated
+const double BULK_RECOVER_LATENCY = 0.1;   // s queued at which decimation stops
+const unsigned int BULK_DECIMATION = 4;
+
+// A stream that delivers nothing for STALL_PERIODS sample periods (at least
+// STALL_MIN_TIMEOUT) without being lost is reported stalled, and one that
+// stays stalled for STALL_RECONNECT_AFTER seconds is released and bound
+// again, in case its connection rather than its sender is stuck. Markers
+// may be silent for any length of time, so they are never stalled.
+const double STALL_PERIODS = 20.0;
+const double STALL_MIN_TIMEOUT = 0.25;      // s
+const double STALL_RECONNECT_AFTER = 10.0;  // s, 0 to never reconnect
+LivenessWatchdog gLiveness;
+std::atomic<bool> gRebindStreams{false};    // a stream was released to be bound again
+
+// A stream's band power extractor is opened on the resolve task and used by
+// the pull and analysis tasks. Releasing the stream only marks it closing;
+// the analysis task closes it when it is done with it, so the pull task
+// never waits on the lowest-priority task.
+enum FeaturesState {
+    featuresClosed,
+    featuresOpen,
+    featuresClosing,
+};
+
+// Processing state of each stream slot, indexed by Slot::index
+struct StreamState {
+    ConsumerMode mode = queued;
+    TripleBuffer latest;         // latestValue streams: newest frame for render()
+    DeadlinePuller lookahead;    // latestValue streams: samples pulled but not yet due
+    BiquadBank filter;
+    bool filtered = false;
+    DeltaStream decoder;
+    bool decoded = false;
+    BandPowerExtractor features; // open only for analysed streams
+    std::atomic<int> featuresState{featuresClosed};
+    MemoryBudget::Grant featuresBuffer; // the feature outlet's share of gMemoryBudget
+    StreamIntegrityMonitor integrity;
+    bool monitored = false;      // regular-rate streams only
+    OverloadPolicy overload;
+    bool guarded = false;        // regular-rate, not delta-packed
+    bool expired = false;        // stalled too long, to be released and bound again
+    StreamDemultiplexer demux;   // per-source views of aggregated streams
+    bool demultiplexed = false;
+    MemoryBudget::Grant buffer;  // the inlet's share of gMemoryBudget
+    unsigned int metadataVersion = 0; // gMetadata version last looked at
+    bool described = false;      // the stream's metadata has been applied
+};
+StreamState streamStates[MAX_STREAMS];
+
+// Inlet and outlet buffers are sized from the RAM free at startup rather
+// than liblsl's 360 s default, so opening many fast streams cannot push the
+// board into swap. Latest-value streams only need a couple of seconds;
+// queued streams and outlets get more to ride out a slow analysis or sync
+// pass, or a consumer that pulls in chunks.
+const double MEMORY_BUDGET_FRACTION = 0.25; // of the RAM free at startup
+MemoryBudget gMemoryBudget;
+
+// Aligned frames of all numeric streams at a common rate, published as one
+// outlet. Streams are pulled with clock synchronisation so their timestamps
+// share the local clock. The outlet is recreated when streams come or go,
+// and its desc()/streams lists which channels belong to which stream. A
+// helper process on the board can read it through shared memory with
+// SharedMemoryInlet instead of loopback TCP.
+//
+// Each stream's ring holds what arrives while the output waits for a late
+// stream, plus one pull: rate * (SYNC_LATENCY + PULL_WAIT) and a chunk.
+// Streams faster than SYNC_MAX_RATE (audio) are left out, since the
+// synchroniser would interpolate them down to SYNC_RATE with no
+// anti-aliasing filter. Frames a full ring turns away are reported with
+// the integrity counts.
+const bool SYNC_ENABLED = false;
+const double SYNC_RATE = 250.0;      // output frames per second
+const double SYNC_LATENCY = 0.1;     // how long to wait for a late stream (s)
+const double SYNC_MAX_RATE = 1000.0; // fastest stream synchronised (Hz)
+const unsigned int SYNC_CHUNK_FRAMES = 64;
+const std::string SYNC_OUTLET_NAME = "bela-sync";
+StreamSynchroniser gSynchroniser;
+SharedMemoryOutlet* gSyncOutlet = nullptr;
+MemoryBudget::Grant gSyncBuffer;    // the outlet's share of gMemoryBudget
+std::vector<float> gSyncFrames;     // SYNC_CHUNK_FRAMES * MAX_STREAMS * MAX_STREAM_CHANNELS
+std::vector<double> gSyncTimestamps;
+
+// Lost, duplicated and reordered samples found in the pulled timestamps are
+// reported per stream at this interval, when there are any
+const double INTEGRITY_REPORT_INTERVAL = 10.0; // s
+double gNextIntegrityReport = 0.0;
+
+// Samples of irregular-rate streams (markers, triggers) are played out in
+// render() at the frame their timestamps call for, EVENT_LATENCY after they
+// were sent, as a pulse on a digital output
+const double EVENT_LATENCY = 0.05;       // must cover network and pull-task delays (s)
+const unsigned int EVENT_CAPACITY = 256; // events in flight
+const int TRIGGER_PIN = -1;              // digital channel, -1 to disable
+const float TRIGGER_PULSE_MS = 5.0f;
+EventScheduler gEvents;
+unsigned int gTriggerPulseFrames = 0;
+unsigned int gTriggerRemaining = 0;
+
+// Streams republished by this board, so that their senders serve a single
+// connection however many consumers there are. The relayed copy is what this
+// sketch binds to as well. Empty to disable.
+const std::vector<std::string> RELAY_STREAM_NAMES = {};
+const std::string RELAY_SOURCE_ID_SUFFIX = "-bela-relay";
+const unsigned int MAX_RELAYS = 4;
+StreamRelay gRelays[MAX_RELAYS];
+
+// The analog inputs published as one outlet of named low-rate sensors
+// (a StreamAggregator) rather than one stream per sensor
+const bool SENSOR_OUTLET_ENABLED = false;
+const std::string SENSOR_OUTLET_NAME = "bela-sensors";
+const double SENSOR_RATE = 100.0;
+struct SensorGroup {
+    const char* name;
+    const char* type;
+    unsigned int firstChannel; // analog input
+    unsigned int channels;
+};
+const std::vector<SensorGroup> SENSOR_GROUPS = {
+    { "pots", "Control", 0, 4 },
+    { "fsr", "Force", 4, 4 },
+};
+StreamAggregator gSensors;
+MemoryBudget::Grant gSensorBuffer;  // the outlet's share of gMemoryBudget
+unsigned int gSensorInterval = 0;   // analog frames per sensor frame
+unsigned int gSensorCountdown = 0;
+
+// All analog inputs at the full analog rate, as 16-bit samples (the ADC's
+// resolution) in delta-packed packets of ANALOG_PACKET_FRAMES frames: the
+// "<type>/delta" format this sketch decodes. Slow-moving inputs pack into
+// a fraction of their raw size.
+const bool ANALOG_OUTLET_ENABLED = false;
+const std::string ANALOG_OUTLET_NAME = "bela-analog";
+const unsigned int ANALOG_PACKET_FRAMES = 64;
+DeltaPackOutlet gAnalogOutlet;
+MemoryBudget::Grant gAnalogBuffer;  // the outlet's share of gMemoryBudget
+FrameRing gAnalogRing;               // render() to the publish task
+std::vector<float> gAnalogFrames;    // one block of analog input frames, for render()
+std::vector<double> gAnalogTimestamps;
+std::vector<float> gAnalogPacket;    // one packet of them, for the publish task
+std::vector<double> gAnalogPacketTimestamps;
+std::vector<int16_t> gAnalogSamples; // the packet, quantised
+
+// Full stream metadata (desc()) is fetched on a worker task as streams are
+// found, so neither resolving nor pulling waits on the network for it.
+// Delta-packed streams are bound once theirs has arrived; aggregated streams
+// are split per source from when it arrives.
+const unsigned int METADATA_CACHE_SIZE = 64;
+const double METADATA_TIMEOUT = 2.0; // s per attempt
+StreamMetadataCache gMetadata;
+bool gAwaitingMetadata = false;      // a stream was left unbound until its metadata arrives
+
+// The resolver finds this sketch's own outlets like any other stream.
+// Binding one would feed the sketch its own output (bela-sync into the
+// synchroniser that makes it) or just take a slot and a buffer, so the
+// source_id of each outlet is recorded where it is created and streams
+// with one of these are left alone. Relayed copies are not recorded; they
+// are meant to be bound. Written by setup() and the resolve and pull
+// tasks, read by the resolve and pull tasks.
+std::mutex gOwnSourceIdsMutex;
+std::set<std::string> gOwnSourceIds;
+
+// Sonification of incoming streams, see Sonifier.h for the mapping format
+const std::string SONIFICATION_CONFIG = "sonification.txt";
+Sonifier gSonifier;
+std::vector<float> gSonificationBuffer; // audioFrames * audioOutChannels
 
 // Auxiliary tasks
 AuxiliaryTask gResolveStreamsTask;
 AuxiliaryTask gPullSamplesTask;
+AuxiliaryTask gAnalyseStreamsTask;
+AuxiliaryTask gRelayStreamsTask;
+AuxiliaryTask gPublishSensorsTask;
+AuxiliaryTask gPublishAnalogTask;
+AuxiliaryTask gFetchMetadataTask;
 
 // Function declarations
 void resolveStreams(void*);
 void pullSamples(void*);
+void serviceStreams();
+void analyseStreams(void*);
+void relayStreams(void*);
+void publishSensors(void*);
+void publishAnalog(void*);
+void fetchMetadata(void*);
+
+bool isDeltaPacked(const lsl::stream_info& info)
+{
+    const std::string type = info.type();
+    return info.channel_format() == lsl::cf_string && type.size() > DELTA_TYPE_SUFFIX.size() &&
+        type.compare(type.size() - DELTA_TYPE_SUFFIX.size(), DELTA_TYPE_SUFFIX.size(), DELTA_TYPE_SUFFIX) == 0;
+}
+
+// Set up a decoder from the stream's metadata. On success, `decoded`
+// describes the data as it comes out of the decoder.
+bool setupStreamDecoder(DeltaStream& stream, lsl::stream_info full, const lsl::stream_info& info, lsl::stream_info& decoded)
+{
+    lsl::xml_element encoding = full.desc().child("encoding");
+    if (std::string(encoding.child_value("codec")) != "delta-for")
+        return false;
+    
+    const std::string formatName = encoding.child_value("channel_format");
+    lsl::channel_format_t format = formatName == "int8" ? lsl::cf_int8 :
+        formatName == "int16" ? lsl::cf_int16 :
+        formatName == "int32" ? lsl::cf_int32 :
+        formatName == "int64" ? lsl::cf_int64 : lsl::cf_undefined;
+    int channels = atoi(encoding.child_value("channel_count"));
+    unsigned int packetFrames = atoi(encoding.child_value("frames_per_packet"));
+    
+    if (channels <= 0 || channels > (int)MAX_STREAM_CHANNELS || packetFrames > MAX_PACKET_FRAMES ||
+        !stream.codec.setup(channels, format, packetFrames))
+        return false;
+    stream.sampleRate = atof(encoding.child_value("nominal_srate"));
+    stream.packetFrames = packetFrames;
+    
+    std::string type = info.type();
+    decoded = lsl::stream_info(info.name(), type.substr(0, type.size() - DELTA_TYPE_SUFFIX.size()),
+        channels, stream.sampleRate, format, info.source_id());
+    return true;
+}
+
+// Decode the samples of the original format to float
+template <class T>
+unsigned int decodeToFloat(DeltaStream& stream, const char* packet, uint32_t bytes, float* out)
+{
+    T* decoded = (T*)stream.decoded.data();
+    unsigned int frames = stream.codec.template decode<T>(packet, bytes, decoded, stream.packetFrames);
+    for (unsigned int n = 0; n < frames * stream.codec.getNumChannels(); n++)
+        out[n] = decoded[n];
+    return frames;
+}
+
+// Pull one packet from a delta-packed stream; returns the number of frames
+size_t pullDeltaPacked(lsl::stream_inlet& inlet, DeltaStream& stream, float* data, double* timestamps)
+{
+    char* packet = nullptr;
+    uint32_t bytes = 0;
+    int32_t ec = 0;
+    double timestamp = lsl_pull_sample_buf(inlet.handle().get(), &packet, &bytes, 1, sampleTimeout, &ec);
+    lsl::check_error(ec);
+    if(timestamp == 0.0)
+        return 0;
+    
+    unsigned int frames = 0;
+    switch(stream.codec.getFormat()) {
+    case lsl::cf_int8: frames = decodeToFloat<int8_t>(stream, packet, bytes, data); break;
+    case lsl::cf_int16: frames = decodeToFloat<int16_t>(stream, packet, bytes, data); break;
+    case lsl::cf_int32: frames = decodeToFloat<int32_t>(stream, packet, bytes, data); break;
+    case lsl::cf_int64: frames = decodeToFloat<int64_t>(stream, packet, bytes, data); break;
+    default: break;
+    }
+    lsl_destroy_string(packet);
+    
+    // The packet timestamp belongs to its first frame
+    for(unsigned int f = 0; f < frames; f++)
+        timestamps[f] = timestamp + (stream.sampleRate > 0.0 ? f / stream.sampleRate : 0.0);
+    return frames;
+}
+
+// Design the filter cascade for a stream from its nominal rate. Returns
+// false for streams that should not be filtered.
+bool setupStreamFilter(BiquadBank& filter, const lsl::stream_info& info, unsigned int maxFrames)
+{
+    if (info.nominal_srate() == lsl::IRREGULAR_RATE || info.channel_format() == lsl::cf_string)
+        return false;
+    bool filtered = false;
+    for (const auto& type : FILTERED_STREAM_TYPES)
+        filtered |= (info.type() == type);
+    if (!filtered)
+        return false;
+
+    std::vector<BiquadBank::Stage> stages = {
+        { BiquadBank::notch, MAINS_FREQUENCY, 30.0f },
+        { BiquadBank::highpass, HIGHPASS_FREQUENCY, 0.7071f },
+        { BiquadBank::lowpass, LOWPASS_FREQUENCY, 0.7071f },
+    };
+    if (!filter.setup(info.channel_count(), info.nominal_srate(), stages, maxFrames))
+        return false;
+    rt_printf("  Filtering %u stages at %.1f Hz\n", filter.getNumStages(), info.nominal_srate());
+    return true;
+}
+
+// Record the source_id of an outlet this sketch publishes
+void addOwnSourceId(const std::string& sourceId)
+{
+    std::lock_guard<std::mutex> lock(gOwnSourceIdsMutex);
+    gOwnSourceIds.insert(sourceId);
+}
+
+// Whether a stream is one of this sketch's own outlets
+bool isOwnSourceId(const std::string& sourceId)
+{
+    std::lock_guard<std::mutex> lock(gOwnSourceIdsMutex);
+    return gOwnSourceIds.count(sourceId) > 0;
+}
+
+// Close a stream's band power outlet and return its buffer to the budget
+void closeStreamFeatures(StreamState& state)
+{
+    state.features.close();
+    gMemoryBudget.release(state.featuresBuffer);
+    state.featuresBuffer = MemoryBudget::Grant();
+}
+
+// Open band power features for streams of the analysed types
+void openStreamFeatures(StreamState& state, const lsl::stream_info& info)
+{
+    bool analysed = false;
+    for (const auto& type : BAND_POWER_STREAM_TYPES)
+        analysed |= (info.type() == type);
+    if (!analysed || info.channel_format() == lsl::cf_string)
+        return;
+
+    // The slot's previous stream may not have been closed yet
+    if (state.featuresState != featuresClosed) {
+        rt_printf("  Band power features of the slot's previous stream still closing, skipped\n");
+        return;
+    }
+    // One feature row per hop, each a value per band and the RMS per channel
+    unsigned int features = info.channel_count() * (BAND_POWER_SETTINGS.bands.size() + 1);
+    state.featuresBuffer = gMemoryBudget.reserve(features, lsl::cf_float32,
+        info.nominal_srate() / BAND_POWER_SETTINGS.hop, MemoryBudget::interactive);
+    if (!state.featuresBuffer) {
+        rt_printf("  Not enough memory left to buffer band power features, skipped\n");
+        return;
+    }
+    try {
+        if (state.features.setup(info, BAND_POWER_SETTINGS, state.featuresBuffer.samples)) {
+            addOwnSourceId(state.features.getSourceId());
+            state.featuresState = featuresOpen;
+            rt_printf("  Publishing %u band power features\n", state.features.getNumFeatures());
+        } else {
+            closeStreamFeatures(state);
+        }
+    } catch(std::exception& e) {
+        closeStreamFeatures(state);
+        rt_printf("  Error creating band power outlet: %s\n", e.what());
+    }
+}
+
+ConsumerMode chooseConsumerMode(const lsl::stream_info& info)
+{
+    if (info.channel_format() == lsl::cf_string)
+        return queued;
+    for (const auto& type : LATEST_VALUE_STREAM_TYPES)
+        if (info.type() == type)
+            return latestValue;
+    return queued;
+}
+
+// Whether a stream is one this sketch should relay rather than bind directly
+bool isRelaySource(const lsl::stream_info& info)
+{
+    const std::string sourceId = info.source_id();
+    if (sourceId.size() >= RELAY_SOURCE_ID_SUFFIX.size() &&
+        sourceId.compare(sourceId.size() - RELAY_SOURCE_ID_SUFFIX.size(), RELAY_SOURCE_ID_SUFFIX.size(), RELAY_SOURCE_ID_SUFFIX) == 0)
+        return false;
+    return std::find(RELAY_STREAM_NAMES.begin(), RELAY_STREAM_NAMES.end(), info.name()) != RELAY_STREAM_NAMES.end();
+}
+
+// Start relaying the sources that are not relayed yet
+void openRelays()
+{
+    for (const auto& info : availableStreams) {
+        if (!isRelaySource(info))
+            continue;
+        StreamRelay* free = nullptr;
+        bool relayed = false;
+        for (auto& relay : gRelays) {
+            if (!relay.isOpen())
+                free = free ? free : &relay;
+            else if (relay.getSourceId() == info.source_id())
+                relayed = true;
+        }
+        if (relayed || !free)
+            continue;
+        try {
+            if (free->open(info, RELAY_SOURCE_ID_SUFFIX, gMemoryBudget))
+                rt_printf("Relaying %s as %s\n", free->getName().c_str(), free->getRelayId().c_str());
+        } catch (std::exception& e) {
+            rt_printf("Error relaying %s: %s\n", info.name().c_str(), e.what());
+        }
+    }
+}
+
+// Return a stream's slot, and everything that hangs off it, to the pool
+void releaseStream(StreamSlotPool::Slot& slot)
+{
+    StreamState& state = streamStates[slot.index];
+    int open = featuresOpen;
+    state.featuresState.compare_exchange_strong(open, featuresClosing);
+    state.filtered = false;
+    state.decoded = false;
+    state.monitored = false;
+    state.guarded = false;
+    state.expired = false;
+    state.demultiplexed = false;
+    state.described = false;
+    state.metadataVersion = 0;
+    state.mode = queued;
+    gSynchroniser.detach(slot.index);
+    gStreams.unbind(&slot);
+    gMemoryBudget.release(state.buffer);
+    state.buffer = MemoryBudget::Grant();
+}
+
+// Print what the integrity monitors found since the last report
+void reportIntegrity()
+{
+    for(unsigned int n = 0; n < gStreams.getNumSlots(); n++) {
+        StreamState& state = streamStates[n];
+        if(!gStreams[n].isActive() || !state.monitored)
+            continue;
+        const StreamIntegrityMonitor::Report& report = state.integrity.getReport();
+        if(report.getAnomalies() > 0 || report.jitterOutliers > 0)
+            rt_printf("%s: %lu gaps (%.1f ms, ~%lu samples lost, longest %.1f ms), %lu duplicates, %lu reordered, "
+                      "%lu jitter outliers, RMS jitter %.3f ms\n", gStreams[n].name,
+                      report.gaps, report.missingSeconds * 1000.0, report.getEstimatedLost(state.integrity.getSampleRate()),
+                      report.maxGapSeconds * 1000.0, report.duplicates, report.reordered,
+                      report.jitterOutliers, report.getJitterRms() * 1000.0);
+        state.integrity.clearReport();
+    }
+}
+
+// Print how often the overload policies had to step in since the last report
+void reportOverload()
+{
+    for(unsigned int n = 0; n < gStreams.getNumSlots(); n++) {
+        StreamState& state = streamStates[n];
+        if(!gStreams[n].isActive() || !state.guarded)
+            continue;
+        const OverloadPolicy::Counters& counters = state.overload.getCounters();
+        if(counters.engagements > 0)
+            rt_printf("%s: fell behind %lu times (up to %.0f ms queued), %lu samples dropped, %lu skipped\n",
+                      gStreams[n].name, counters.engagements, counters.peakLatency * 1000.0,
+                      counters.dropped, counters.skipped);
+        state.overload.clearCounters();
+    }
+}
+
+// Print how many frames the synchroniser turned away since the last report
+void reportSyncDrops()
+{
+    for(unsigned int n = 0; n < gStreams.getNumSlots(); n++) {
+        if(!gStreams[n].isActive() || !gSynchroniser.isAttached(n))
+            continue;
+        unsigned long dropped = gSynchroniser.takeDropped(n);
+        if(dropped > 0)
+            rt_printf("%s: %lu frames dropped from %s, its ring was full\n", gStreams[n].name, dropped,
+                      SYNC_OUTLET_NAME.c_str());
+    }
+}
+
+// Report streams that stall and resume, and mark those stalled too long
+void onLivenessEvent(unsigned int n, LivenessWatchdog::Event event, double silence)
+{
+    switch(event) {
+        case LivenessWatchdog::stalled:
+            rt_printf("%s: stalled, no data for %.0f ms\n", gStreams[n].name, silence * 1000.0);
+            break;
+        case LivenessWatchdog::resumed:
+            rt_printf("%s: resumed after %.1f s\n", gStreams[n].name, silence);
+            break;
+        case LivenessWatchdog::expired:
+            rt_printf("%s: no data for %.1f s, reconnecting\n", gStreams[n].name, silence);
+            streamStates[n].expired = true;
+            break;
+    }
+}
+
+// How a stream sheds load when the pull task falls behind it
+OverloadPolicy::Settings chooseOverloadSettings(const lsl::stream_info& info, const StreamState& state)
+{
+    OverloadPolicy::Settings settings;
+    if(state.mode == latestValue) {
+        settings.mode = OverloadPolicy::keepLatest;
+        settings.maxLatency = CONTROL_MAX_LATENCY;
+        settings.recoverLatency = 0.0;
+    } else if(info.type() == "Audio") {
+        settings.mode = OverloadPolicy::dropOldest;
+        settings.maxLatency = LIVE_MAX_LATENCY;
+        settings.recoverLatency = LIVE_RECOVER_LATENCY;
+    } else {
+        settings.mode = state.featuresState == featuresOpen ? OverloadPolicy::keepAll : OverloadPolicy::decimate;
+        settings.maxLatency = BULK_MAX_LATENCY;
+        settings.recoverLatency = BULK_RECOVER_LATENCY;
+        settings.decimation = BULK_DECIMATION;
+    }
+    return settings;
+}
+
+// Frames of synchroniser ring for a stream of this rate, 0 for irregular
+unsigned int syncRingFrames(double sampleRate)
+{
+    return (unsigned int)std::ceil(sampleRate * (SYNC_LATENCY + PULL_WAIT)) + CHUNK_FRAMES;
+}
+
+// Attach an active stream to the synchroniser; returns true if it was added
+bool attachToSynchroniser(const StreamSlotPool::Slot& slot)
+{
+    if(!SYNC_ENABLED || gSynchroniser.isAttached(slot.index) || slot.format == lsl::cf_string
+       || streamStates[slot.index].mode != queued || slot.sampleRate > SYNC_MAX_RATE
+       || isOwnSourceId(slot.sourceId))
+        return false;
+    StreamSynchroniser::Mode mode = slot.sampleRate > 0.0 ? StreamSynchroniser::interpolate : StreamSynchroniser::hold;
+    return gSynchroniser.attach(slot.index, slot.channels, slot.sampleRate, mode, syncRingFrames(slot.sampleRate));
+}
+
+// Recreate the synchronised outlet for the current channel layout
+void createSyncOutlet()
+{
+    delete gSyncOutlet;
+    gSyncOutlet = nullptr;
+    gMemoryBudget.release(gSyncBuffer);
+    gSyncBuffer = MemoryBudget::Grant();
+    if(gSynchroniser.getNumChannels() == 0)
+        return;
+    
+    lsl::stream_info info(SYNC_OUTLET_NAME, "Synchronised", gSynchroniser.getNumChannels(), SYNC_RATE,
+        lsl::cf_float32, SYNC_OUTLET_NAME);
+    lsl::xml_element streams = info.desc().append_child("streams");
+    for(unsigned int n = 0; n < gStreams.getNumSlots(); n++) {
+        if(!gSynchroniser.isAttached(n))
+            continue;
+        streams.append_child("stream")
+            .append_child_value("name", gStreams[n].name)
+            .append_child_value("uid", gStreams[n].uid)
+            .append_child_value("first_channel", std::to_string(gSynchroniser.getChannelOffset(n)))
+            .append_child_value("channel_count", std::to_string(gStreams[n].channels))
+            .append_child_value("alignment", gStreams[n].sampleRate > 0.0 ? "interpolated" : "held");
+    }
+    gSyncBuffer = gMemoryBudget.reserve(info, MemoryBudget::interactive);
+    if(!gSyncBuffer) {
+        rt_printf("Not enough memory left to buffer the synchronised outlet\n");
+        return;
+    }
+    // Before it can be resolved, so it is never bound and synchronised again
+    addOwnSourceId(SYNC_OUTLET_NAME);
+    try {
+        gSyncOutlet = new SharedMemoryOutlet(info, 2048, SYNC_CHUNK_FRAMES, gSyncBuffer.samples, transp_bufsize_samples);
+        rt_printf("Publishing %u synchronised channels as %s\n", gSynchroniser.getNumChannels(), SYNC_OUTLET_NAME.c_str());
+    } catch(std::exception& e) {
+        rt_printf("Error creating synchronised outlet: %s\n", e.what());
+    }
+}
 
 bool setup(BelaContext *context, void *userData)
 {
+    // liblsl is loaded at run time; say why if it can't be
+    if (!loadLsl()) {
+        rt_printf("Error loading liblsl: %s\n", getLslLoadError());
+        return false;
+    }
+    
     // Print LSL library version
     rt_printf("Using LSL library version: %d.%d\n", 
               lsl::library_version() / 100, 
@@ -40,6 +691,135 @@ bool setup(BelaContext *context, void *userData)
     if ((gPullSamplesTask = Bela_createAuxiliaryTask(&pullSamples, 80, "pull-samples")) == 0)
         return false;
     
+    if ((gAnalyseStreamsTask = Bela_createAuxiliaryTask(&analyseStreams, 20, "analyse-streams")) == 0)
+        return false;
+    
+    if ((gFetchMetadataTask = Bela_createAuxiliaryTask(&fetchMetadata, 30, "fetch-metadata")) == 0)
+        return false;
+    gMetadata.setup(METADATA_CACHE_SIZE, METADATA_TIMEOUT);
+    
+    if (!RELAY_STREAM_NAMES.empty() &&
+        (gRelayStreamsTask = Bela_createAuxiliaryTask(&relayStreams, 70, "relay-streams")) == 0)
+        return false;
+    
+    if (!gMemoryBudget.setup(MEMORY_BUDGET_FRACTION))
+        return false;
+    rt_printf("Stream buffer budget: %zu kB\n", gMemoryBudget.getBudget() / 1024);
+    
+    // Allocate the stream slots and their processing state up front
+    unsigned int slotFrames = std::max(CHUNK_FRAMES, MAX_PACKET_FRAMES);
+    unsigned int filterFrames = std::max(slotFrames, LATEST_VALUE_LOOKAHEAD);
+    if (!gStreams.setup(MAX_STREAMS, MAX_STREAM_CHANNELS, slotFrames) || !gInletWaiter.setup(MAX_STREAMS) ||
+        !gPullScheduler.setup(MAX_STREAMS, CHUNK_FRAMES))
+        return false;
+    LivenessWatchdog::Settings liveness;
+    liveness.timeoutPeriods = STALL_PERIODS;
+    liveness.minTimeout = STALL_MIN_TIMEOUT;
+    liveness.expireAfter = STALL_RECONNECT_AFTER;
+    if (!gLiveness.setup(MAX_STREAMS, liveness))
+        return false;
+    gLiveness.setListener(onLivenessEvent);
+    for (auto& state : streamStates) {
+        state.filter.reserve(MAX_STREAM_CHANNELS, filterFrames);
+        // int8 needs the codec's widening buffer too, so this covers every format
+        state.decoder.codec.setup(MAX_STREAM_CHANNELS, lsl::cf_int8, MAX_PACKET_FRAMES);
+        state.decoder.decoded.resize(MAX_PACKET_FRAMES * MAX_STREAM_CHANNELS * sizeof(int64_t));
+        state.latest.setup(MAX_STREAM_CHANNELS);
+        state.lookahead.setup(MAX_STREAM_CHANNELS, LATEST_VALUE_LOOKAHEAD);
+    }
+    if (SYNC_ENABLED) {
+        if (!gSynchroniser.setup(MAX_STREAMS, MAX_STREAM_CHANNELS, SYNC_RATE, SYNC_LATENCY, syncRingFrames(SYNC_MAX_RATE)))
+            return false;
+        gSyncFrames.resize(SYNC_CHUNK_FRAMES * MAX_STREAMS * MAX_STREAM_CHANNELS);
+        gSyncTimestamps.resize(SYNC_CHUNK_FRAMES);
+    }
+    
+    // Event playout runs on the digital frame clock
+    if (!gEvents.setup(EVENT_CAPACITY, context->digitalSampleRate, EVENT_LATENCY))
+        return false;
+    if (TRIGGER_PIN >= 0) {
+        if ((unsigned int)TRIGGER_PIN >= context->digitalChannels)
+            return false;
+        pinMode(context, 0, TRIGGER_PIN, OUTPUT);
+        gTriggerPulseFrames = std::max(1.0f, TRIGGER_PULSE_MS * 0.001f * context->digitalSampleRate);
+    }
+    
+    // One wide outlet for the sensors on the analog inputs
+    if (SENSOR_OUTLET_ENABLED && context->analogFrames > 0) {
+        for (const auto& group : SENSOR_GROUPS) {
+            if (group.firstChannel + group.channels > context->analogInChannels)
+                return false;
+            gSensors.addSource(group.name, group.type, group.channels);
+        }
+        gSensorBuffer = gMemoryBudget.reserve(gSensors.getNumChannels(), lsl::cf_float32, SENSOR_RATE,
+            MemoryBudget::interactive);
+        if (!gSensorBuffer) {
+            rt_printf("Not enough memory left to buffer the sensor outlet\n");
+            return false;
+        }
+        addOwnSourceId(SENSOR_OUTLET_NAME);
+        try {
+            if (!gSensors.open(SENSOR_OUTLET_NAME, "Sensors", SENSOR_RATE, SENSOR_OUTLET_NAME, 32, 1024,
+                               gSensorBuffer.samples))
+                return false;
+        } catch (std::exception& e) {
+            rt_printf("Error creating sensor outlet: %s\n", e.what());
+            return false;
+        }
+        gSensorInterval = std::max(1u, (unsigned int)(context->analogSampleRate / SENSOR_RATE + 0.5));
+        if ((gPublishSensorsTask = Bela_createAuxiliaryTask(&publishSensors, 40, "publish-sensors")) == 0)
+            return false;
+        rt_printf("Publishing %u sensors (%u channels) as %s\n", gSensors.getNumSources(),
+                  gSensors.getNumChannels(), SENSOR_OUTLET_NAME.c_str());
+    }
+    
+    if (ANALOG_OUTLET_ENABLED && context->analogInChannels > 0) {
+        unsigned int channels = context->analogInChannels;
+        lsl::stream_info info(ANALOG_OUTLET_NAME, "Analog", channels, context->analogSampleRate,
+            lsl::cf_int16, ANALOG_OUTLET_NAME);
+        // One string sample per packet
+        gAnalogBuffer = gMemoryBudget.reserve(1, lsl::cf_string, context->analogSampleRate / ANALOG_PACKET_FRAMES,
+            MemoryBudget::interactive);
+        if (!gAnalogBuffer) {
+            rt_printf("Not enough memory left to buffer the analog outlet\n");
+            return false;
+        }
+        addOwnSourceId(ANALOG_OUTLET_NAME);
+        try {
+            if (!gAnalogOutlet.open(info, ANALOG_PACKET_FRAMES, gAnalogBuffer.samples))
+                return false;
+        } catch (std::exception& e) {
+            rt_printf("Error creating analog outlet: %s\n", e.what());
+            return false;
+        }
+        // A tenth of a second of slack for the publish task
+        unsigned int frames = std::max(context->analogFrames, ANALOG_PACKET_FRAMES);
+        if (!gAnalogRing.setup(channels, std::max(frames * 2, (unsigned int)(context->analogSampleRate / 10))))
+            return false;
+        gAnalogFrames.resize(context->analogFrames * channels);
+        gAnalogTimestamps.resize(context->analogFrames);
+        gAnalogPacket.resize(ANALOG_PACKET_FRAMES * channels);
+        gAnalogPacketTimestamps.resize(ANALOG_PACKET_FRAMES);
+        gAnalogSamples.resize(ANALOG_PACKET_FRAMES * channels);
+        if ((gPublishAnalogTask = Bela_createAuxiliaryTask(&publishAnalog, 40, "publish-analog")) == 0)
+            return false;
+        rt_printf("Publishing %u analog inputs as delta-packed %s\n", channels, ANALOG_OUTLET_NAME.c_str());
+    }
+    
+    // Compile the sonification mappings, if any
+    std::ifstream configFile(SONIFICATION_CONFIG);
+    if (configFile) {
+        std::stringstream config;
+        config << configFile.rdbuf();
+        if (!gSonifier.compile(config.str())) {
+            rt_printf("Error in %s: %s\n", SONIFICATION_CONFIG.c_str(), gSonifier.getError().c_str());
+            return false;
+        }
+    }
+    gSonifier.setup(context->audioSampleRate);
+    gSonificationBuffer.resize(context->audioFrames * context->audioOutChannels);
+    rt_printf("Sonification: %u voices, %u mappings\n", gSonifier.getNumVoices(), gSonifier.getNumMappings());
+    
     // Create continuous resolver
     resolver = new lsl::continuous_resolver();
     
@@ -59,20 +839,114 @@ void render(BelaContext *context, void *userData)
         }
     }
     
-    // If we have active streams, schedule sample pulling for every render cycle
-    if(!streamInlets.empty()) {
+    // Relays are serviced every block, independently of the streams bound here
+    if(!RELAY_STREAM_NAMES.empty())
+        Bela_scheduleAuxiliaryTask(gRelayStreamsTask);
+    
+    // If we have active streams, start the pull loop
+    if(streamsResolved && !gPulling.exchange(true)) {
         Bela_scheduleAuxiliaryTask(gPullSamplesTask);
     }
+    
+    // Play the events due in this block at their frames
+    uint64_t digitalFramesElapsed = context->audioFramesElapsed * context->digitalFrames / context->audioFrames;
+    gEvents.beginBlock(digitalFramesElapsed, context->digitalFrames, lsl::local_clock());
+    unsigned int eventFrame = 0;
+    const EventScheduler::Event* event = gEvents.next(eventFrame);
+    for(unsigned int n = 0; n < context->digitalFrames; n++) {
+        while(event && eventFrame == n) {
+            gTriggerRemaining = gTriggerPulseFrames;
+            event = gEvents.next(eventFrame);
+        }
+        if(TRIGGER_PIN >= 0)
+            digitalWriteOnce(context, n, TRIGGER_PIN, gTriggerRemaining > 0);
+        if(gTriggerRemaining > 0)
+            gTriggerRemaining--;
+    }
+    
+    // Newest frame of the first latest-value stream on the analog outputs
+    if(LATEST_VALUE_ANALOG_OUT) {
+        for(unsigned int n = 0; n < gStreams.getNumSlots(); n++) {
+            StreamState& state = streamStates[n];
+            if(!gStreams[n].isActive() || state.mode != latestValue)
+                continue;
+            if(state.latest.update()) {
+                const float* frame = state.latest.getReadBuffer();
+                unsigned int channels = std::min(gStreams[n].channels, context->analogOutChannels);
+                for(unsigned int ch = 0; ch < channels; ch++)
+                    analogWrite(context, 0, ch, std::min(std::max(frame[ch], 0.0f), 1.0f));
+            }
+            break;
+        }
+    }
+    
+    // Sample the sensors at their own rate
+    if(gSensors.isOpen()) {
+        for(unsigned int n = 0; n < context->analogFrames; n++) {
+            if(gSensorCountdown-- > 0)
+                continue;
+            gSensorCountdown = gSensorInterval - 1;
+            float values[MAX_STREAM_CHANNELS];
+            for(unsigned int g = 0; g < SENSOR_GROUPS.size(); g++) {
+                for(unsigned int ch = 0; ch < SENSOR_GROUPS[g].channels; ch++)
+                    values[ch] = analogRead(context, n, SENSOR_GROUPS[g].firstChannel + ch);
+                gSensors.update(g, values);
+            }
+            gSensors.commit(lsl::local_clock());
+        }
+        Bela_scheduleAuxiliaryTask(gPublishSensorsTask);
+    }
+    
+    // Queue the analog inputs for the delta-packed outlet
+    if(gAnalogOutlet.isOpen()) {
+        double blockTime = lsl::local_clock();
+        for(unsigned int n = 0; n < context->analogFrames; n++) {
+            for(unsigned int ch = 0; ch < context->analogInChannels; ch++)
+                gAnalogFrames[n * context->analogInChannels + ch] = analogRead(context, n, ch);
+            gAnalogTimestamps[n] = blockTime + n / context->analogSampleRate;
+        }
+        gAnalogRing.write(gAnalogFrames.data(), gAnalogTimestamps.data(), context->analogFrames);
+        Bela_scheduleAuxiliaryTask(gPublishAnalogTask);
+    }
+    
+    // Render the sonification voices
+    gSonifier.process(gSonificationBuffer.data(), context->audioFrames, context->audioOutChannels);
+    for(unsigned int n = 0; n < context->audioFrames; n++) {
+        for(unsigned int ch = 0; ch < context->audioOutChannels; ch++)
+            audioWrite(context, n, ch, gSonificationBuffer[n * context->audioOutChannels + ch]);
+    }
 }
 
 void cleanup(BelaContext *context, void *userData)
 {
-    // Close and clean up stream inlets
-    for(auto inlet : streamInlets) {
-        inlet->close_stream();
-        delete inlet;
+    // The pull loop must be out of the inlets before they are released. It
+    // sees the stop request within PULL_WAIT plus one round of pulls.
+    for(double waited = 0.0; gPulling && waited < PULL_STOP_TIMEOUT; waited += 0.001)
+        usleep(1000);
+    if(gPulling) {
+        rt_printf("The pull loop did not stop; leaving the inlets open\n");
+        return;
+    }
+    
+    // Close the stream inlets and feature outlets
+    for(unsigned int n = 0; n < gStreams.getNumSlots(); n++) {
+        if(gStreams[n].inlet)
+            releaseStream(gStreams[n]);
     }
-    streamInlets.clear();
+    // The analysis task no longer runs to close them
+    for(auto& state : streamStates) {
+        closeStreamFeatures(state);
+        state.featuresState = featuresClosed;
+    }
+    
+    delete gSyncOutlet;
+    
+    if(gEvents.getLate() > 0 || gEvents.getDropped() > 0)
+        rt_printf("Events: %lu played late, %lu dropped; raise EVENT_LATENCY or EVENT_CAPACITY\n",
+                  gEvents.getLate(), gEvents.getDropped());
+    
+    for(auto& relay : gRelays)
+        relay.close();
     
     // Clean up resolver
     delete resolver;
@@ -81,8 +955,9 @@ void cleanup(BelaContext *context, void *userData)
 // Function to resolve available LSL streams
 void resolveStreams(void*)
 {
-    // Check if any inlets are open
-    bool needToReopen = streamInlets.empty();
+    // Check if any streams are open, waiting for their metadata, or released
+    // to be bound again
+    bool needToReopen = gStreams.getNumActive() == 0 || gAwaitingMetadata || gRebindStreams.exchange(false);
     
     // Get results from the continuous resolver
     availableStreams = resolver->results();
@@ -92,101 +967,419 @@ void resolveStreams(void*)
         return;
     }
     
+    // Fetch the full metadata of new streams in the background
+    for(const auto& info : availableStreams)
+        gMetadata.request(info);
+    if(gMetadata.hasPending())
+        Bela_scheduleAuxiliaryTask(gFetchMetadataTask);
+    
+    if(!RELAY_STREAM_NAMES.empty())
+        openRelays();
+    
     if(needToReopen) {
         rt_printf("Found %zu LSL streams:\n", availableStreams.size());
+        gAwaitingMetadata = false;
         
-        // Clean up existing inlets (shouldn't be any if needToReopen is true)
-        for(auto inlet : streamInlets) {
-            inlet->close_stream();
-            delete inlet;
-        }
-        streamInlets.clear();
-        streamData.clear();
-        streamNames.clear();
-        
-        // Create inlets for each stream
+        // Bind an inlet to a free slot for each stream
         for(size_t i = 0; i < availableStreams.size(); i++) {
             const auto& info = availableStreams[i];
+            if(gStreams.find(info.uid().c_str()))
+                continue;
             rt_printf("  Stream %zu: %s (%s), %d channels\n", 
                      i, info.name().c_str(), info.type().c_str(), info.channel_count());
             
-            // Create a new inlet
+            // Streams this sketch publishes are not fed back into it
+            if(isOwnSourceId(info.source_id())) {
+                rt_printf("  Published by this sketch, skipped\n");
+                continue;
+            }
+            
+            // Relayed sources are bound through their relayed copy
+            if(isRelaySource(info)) {
+                rt_printf("  Relayed, binding the relayed copy instead\n");
+                continue;
+            }
+            
+            // Delta-packed streams can't be decoded without their metadata
+            StreamMetadataCache::Handle metadata = gMetadata.find(info.uid());
+            if(isDeltaPacked(info) && !metadata) {
+                rt_printf("  Waiting for the stream's metadata\n");
+                gAwaitingMetadata = true;
+                continue;
+            }
+            
+            bool latest = chooseConsumerMode(info) == latestValue;
+            MemoryBudget::Role role = latest ? MemoryBudget::realtime : MemoryBudget::interactive;
+            MemoryBudget::Grant buffer = gMemoryBudget.reserve(info, role);
+            if(!buffer) {
+                rt_printf("  Not enough memory left to buffer this stream\n");
+                continue;
+            }
+            
+            StreamSlotPool::Slot* slot = nullptr;
             try {
-                // Create inlet with a longer buffer and recovery option
-                lsl::stream_inlet* inlet = new lsl::stream_inlet(info, 360, 0, true);
-                streamInlets.push_back(inlet);
+                // Create inlet with a budgeted buffer and recovery option
+                slot = gStreams.bind(info, buffer.samples, 0, true, transp_bufsize_samples);
+                if(!slot) {
+                    rt_printf("  No free stream slot, or more than %u channels\n", MAX_STREAM_CHANNELS);
+                    gMemoryBudget.release(buffer);
+                    continue;
+                }
+                StreamState& state = streamStates[slot->index];
+                state.buffer = buffer;
+                if(SYNC_ENABLED || latest || info.nominal_srate() == lsl::IRREGULAR_RATE)
+                    slot->inlet->set_postprocessing(lsl::post_clocksync);
                 
-                // Prepare vector for data
-                streamData.push_back(std::vector<float>(info.channel_count()));
-                streamNames.push_back(info.name());
+                // Delta-packed streams are decoded back to their original format
+                lsl::stream_info dataInfo = info;
+                unsigned int frames = CHUNK_FRAMES;
+                if(isDeltaPacked(info)) {
+                    if(!setupStreamDecoder(state.decoder, metadata->info, info, dataInfo)) {
+                        rt_printf("  Unsupported delta-packed stream\n");
+                        releaseStream(*slot);
+                        continue;
+                    }
+                    state.decoded = true;
+                    frames = state.decoder.packetFrames;
+                    slot->channels = dataInfo.channel_count();
+                    slot->format = dataInfo.channel_format();
+                    slot->sampleRate = dataInfo.nominal_srate();
+                    rt_printf("  Decoding %d channels of delta-packed data\n", dataInfo.channel_count());
+                }
+                
+                state.mode = chooseConsumerMode(dataInfo);
+                if(state.mode == latestValue && !state.decoded)
+                    frames = LATEST_VALUE_LOOKAHEAD;
+                state.filtered = setupStreamFilter(state.filter, dataInfo, frames);
+                if(state.mode == queued)
+                    openStreamFeatures(state, dataInfo);
+                else {
+                    state.lookahead.restart(dataInfo.channel_count());
+                    rt_printf("  Passing the latest value to render()\n");
+                }
+                state.monitored = state.integrity.setup(dataInfo.nominal_srate());
+                state.guarded = !state.decoded &&
+                    state.overload.setup(dataInfo.nominal_srate(), dataInfo.channel_count(),
+                                         chooseOverloadSettings(dataInfo, state));
                 
                 // Open the stream
-                inlet->open_stream(1.0); // 1.0 second timeout
+                slot->inlet->open_stream(1.0); // 1.0 second timeout
+                gStreams.activate(slot);
                 rt_printf("  Stream opened successfully\n");
             } catch(std::exception& e) {
                 rt_printf("  Error creating inlet: %s\n", e.what());
+                if(slot)
+                    releaseStream(*slot);
+                else
+                    gMemoryBudget.release(buffer);
             }
         }
         
-        streamsResolved = true;
+        streamsResolved = gStreams.getNumActive() > 0;
     }
 }
 
-// Function to pull samples from active streams
-void pullSamples(void*)
+// Print one frame of stream data
+void printFrame(const char* name, const float* frame, unsigned int channels, double timestamp)
 {
-    if(!streamsResolved || streamInlets.empty())
+    rt_printf("%s: [", name);
+    for(unsigned int j = 0; j < channels; j++) {
+        rt_printf("%f", frame[j]);
+        if(j < channels - 1)
+            rt_printf(", ");
+    }
+    rt_printf("] (t=%f)\n", timestamp);
+}
+
+// Apply a stream's metadata once the worker has fetched it
+void describeStream(StreamSlotPool::Slot& slot, StreamState& state)
+{
+    unsigned int version = gMetadata.getVersion();
+    if(version == state.metadataVersion)
+        return;
+    state.metadataVersion = version;
+    StreamMetadataCache::Handle metadata = gMetadata.find(slot.uid);
+    if(!metadata)
         return;
+    state.described = true;
     
-    for(size_t i = 0; i < streamInlets.size(); i++) {
-        try {
-            double timestamp = streamInlets[i]->pull_sample(streamData[i], sampleTimeout);
-            
-            if(timestamp != 0.0) {
-                // Print stream data
-                rt_printf("%s: [", streamNames[i].c_str());
-                for(size_t j = 0; j < streamData[i].size(); j++) {
-                    rt_printf("%f", streamData[i][j]);
-                    if(j < streamData[i].size() - 1)
-                        rt_printf(", ");
-                }
-                rt_printf("] (t=%f)\n", timestamp);
+    // Aggregated streams are handled per source
+    if(!state.decoded && slot.format != lsl::cf_string) {
+        state.demultiplexed = state.demux.setup(metadata->info);
+        if(state.demultiplexed)
+            rt_printf("%s: aggregate of %u sources\n", slot.name, state.demux.getNumViews());
+    }
+}
+
+// Audio and control streams are latency-critical, markers next; everything
+// else is bulk data
+PullScheduler::Priority choosePriority(const StreamSlotPool::Slot& slot, const StreamState& state)
+{
+    if(state.mode == latestValue || std::string(slot.type) == "Audio")
+        return PullScheduler::critical;
+    if(slot.sampleRate == lsl::IRREGULAR_RATE)
+        return PullScheduler::events;
+    return PullScheduler::bulk;
+}
+
+// Function to pull samples from the active streams until they are all gone
+void pullSamples(void*)
+{
+    while(streamsResolved && !Bela_stopRequested()) {
+        // Follow the streams bound and released since the last round
+        for(unsigned int n = 0; n < gStreams.getNumSlots(); n++) {
+            StreamSlotPool::Slot& slot = gStreams[n];
+            if(slot.isActive() && !gInletWaiter.isWatched(n))
+                gInletWaiter.watch(n, slot.inlet, slot.sampleRate);
+            else if(!slot.isActive() && gInletWaiter.isWatched(n))
+                gInletWaiter.unwatch(n);
+        }
+        // Wake in time for samples waiting in a lookahead to become due
+        double timeout = PULL_WAIT;
+        double now = lsl::local_clock();
+        for(unsigned int n = 0; n < gStreams.getNumSlots(); n++) {
+            const DeadlinePuller& lookahead = streamStates[n].lookahead;
+            if(gStreams[n].isActive() && streamStates[n].mode == latestValue && lookahead.getLookahead() > 0)
+                timeout = std::min(timeout, lookahead.getNextTimestamp() + LATEST_VALUE_DELAY - now);
+        }
+        gInletWaiter.wait(std::max(timeout, 0.0));
+        serviceStreams();
+    }
+    gPulling = false;
+}
+
+// Pull up to maxFrames of one stream and pass on what it delivered. Sets
+// `drained` if the stream had no more, and `lost` if it is gone.
+unsigned int pullStream(StreamSlotPool::Slot& slot, unsigned int maxFrames, bool& drained, bool& lost)
+{
+    StreamState& state = streamStates[slot.index];
+    drained = true;
+    try {
+        float* data = slot.data;
+        double* timestamps = slot.timestamps;
+        size_t channels = slot.channels;
+        size_t frames = 0;
+        // Shed the backlog first if the stream has fallen behind; dropped
+        // samples are not the network's fault, so the monitor starts over
+        if(state.guarded && state.overload.admit(*slot.inlet, data, timestamps, slot.maxFrames) > 0
+           && state.monitored)
+            state.integrity.restart();
+        if(state.decoded) {
+            // One packet at a time
+            frames = pullDeltaPacked(*slot.inlet, state.decoder, data, timestamps);
+            drained = frames == 0;
+        } else if(state.mode == latestValue) {
+            // Everything due by now, in place in the lookahead
+            frames = state.lookahead.pullUntil(*slot.inlet, lsl::local_clock() - LATEST_VALUE_DELAY);
+            data = state.lookahead.getData();
+            timestamps = state.lookahead.getTimestamps();
+        } else {
+            frames = slot.inlet->pull_chunk_multiplexed(
+                data, timestamps, maxFrames * channels, maxFrames, sampleTimeout) / channels;
+            drained = frames < maxFrames;
+        }
+        
+        if(state.monitored)
+            state.integrity.check(timestamps, frames);
+        if(state.filtered)
+            state.filter.process(data, frames);
+        if(state.guarded && state.mode == queued)
+            frames = state.overload.thin(data, timestamps, frames);
+        
+        // Control-style streams: only the newest frame matters
+        if(state.mode == latestValue) {
+            if(frames > 0) {
+                const float* newest = &data[(frames - 1) * channels];
+                std::copy(newest, newest + channels, state.latest.getWriteBuffer());
+                state.latest.publish(timestamps[frames - 1]);
+                gSonifier.update(slot.name, newest, channels);
             }
-        } catch(lsl::lost_error& e) {
-            rt_printf("Stream %s lost: %s\n", streamNames[i].c_str(), e.what());
-            
-            // Close stream and mark for reopening
-            streamInlets[i]->close_stream();
-            delete streamInlets[i];
-            streamInlets[i] = nullptr;
-            
-            // Trigger stream resolution on next cycle
-            shouldResolveStreams = true;
-        } catch(std::exception& e) {
-            rt_printf("Error pulling sample from %s: %s\n", streamNames[i].c_str(), e.what());
+            return frames;
+        }
+        
+        if(state.featuresState == featuresOpen)
+            state.features.push(data, timestamps, frames);
+        if(gSynchroniser.isAttached(slot.index))
+            gSynchroniser.push(slot.index, data, timestamps, frames);
+        if(slot.sampleRate == lsl::IRREGULAR_RATE) {
+            for(size_t f = 0; f < frames; f++)
+                gEvents.schedule(timestamps[f], slot.index, &data[f * channels], channels);
+        }
+        
+        // Aggregated streams are printed and sonified per source
+        if(state.demultiplexed) {
+            for(unsigned int v = 0; v < state.demux.getNumViews(); v++) {
+                const StreamDemultiplexer::View& view = state.demux.getView(v);
+                for(size_t f = 0; f < frames; f++)
+                    printFrame(view.name.c_str(), state.demux.getFrame(v, data, f), view.channels, timestamps[f]);
+                if(frames > 0)
+                    gSonifier.update(view.name.c_str(), state.demux.getFrame(v, data, frames - 1), view.channels);
+            }
+            return frames;
+        }
+        
+        for(size_t f = 0; f < frames; f++)
+            printFrame(slot.name, &data[f * channels], channels, timestamps[f]);
+        
+        // Drive the sonification from the newest frame
+        if(frames > 0)
+            gSonifier.update(slot.name, &data[(frames - 1) * channels], channels);
+        return frames;
+    } catch(lsl::lost_error& e) {
+        rt_printf("Stream %s lost: %s\n", slot.name, e.what());
+        
+        // Close the stream and free its slot
+        releaseStream(slot);
+        gPullScheduler.remove(slot.index);
+        gInletWaiter.unwatch(slot.index);
+        gLiveness.unwatch(slot.index);
+        lost = true;
+        
+        // Trigger stream resolution on next cycle
+        shouldResolveStreams = true;
+    } catch(std::exception& e) {
+        rt_printf("Error pulling sample from %s: %s\n", slot.name, e.what());
+    }
+    return 0;
+}
+
+// Pull the streams that have samples, most latency-critical first, and pass
+// on what they delivered
+void serviceStreams()
+{
+    bool lost = false;
+    bool layoutChanged = false;
+    gLiveness.advance(lsl::local_clock());
+    for(unsigned int n = 0; n < gStreams.getNumSlots(); n++) {
+        StreamSlotPool::Slot& slot = gStreams[n];
+        if(!slot.isActive()) {
+            gPullScheduler.remove(n);
+            gLiveness.unwatch(n);
+            continue;
+        }
+        StreamState& state = streamStates[n];
+        // Release streams silent for too long, so the resolver binds them again
+        if(state.expired) {
+            releaseStream(slot);
+            gPullScheduler.remove(n);
+            gInletWaiter.unwatch(n);
+            gLiveness.unwatch(n);
+            gRebindStreams = true;
+            lost = true;
+            continue;
         }
+        if(!gLiveness.isWatched(n))
+            gLiveness.watch(n, slot.sampleRate, lsl::local_clock());
+        if(!state.described)
+            describeStream(slot, state);
+        layoutChanged |= attachToSynchroniser(slot);
+        if(!gPullScheduler.isAdded(n))
+            gPullScheduler.add(n, choosePriority(slot, state), slot.sampleRate);
+        // Latest-value streams may have samples waiting in their lookahead
+        bool due = state.mode == latestValue && state.lookahead.getLookahead() > 0;
+        gPullScheduler.setReady(n, gInletWaiter.isReady(n) || due);
     }
     
-    // Clean up any closed streams
-    auto it = streamInlets.begin();
-    auto nameIt = streamNames.begin();
-    auto dataIt = streamData.begin();
+    gPullScheduler.beginRound(lsl::local_clock());
+    int n;
+    unsigned int maxFrames;
+    while((n = gPullScheduler.next(maxFrames)) >= 0) {
+        double start = lsl::local_clock();
+        bool drained;
+        unsigned int frames = pullStream(gStreams[n], maxFrames, drained, lost);
+        double end = lsl::local_clock();
+        if(frames > 0)
+            gLiveness.arrived(n, end);
+        gPullScheduler.complete(n, frames, drained, end - start);
+    }
+    layoutChanged |= lost;
     
-    while(it != streamInlets.end()) {
-        if(*it == nullptr) {
-            it = streamInlets.erase(it);
-            nameIt = streamNames.erase(nameIt);
-            dataIt = streamData.erase(dataIt);
-        } else {
-            ++it;
-            ++nameIt;
-            ++dataIt;
+    gSonifier.publish();
+    Bela_scheduleAuxiliaryTask(gAnalyseStreamsTask);
+    
+    double now = lsl::local_clock();
+    if(now >= gNextIntegrityReport) {
+        reportIntegrity();
+        reportOverload();
+        if(SYNC_ENABLED)
+            reportSyncDrops();
+        gNextIntegrityReport = now + INTEGRITY_REPORT_INTERVAL;
+    }
+    
+    // Publish the frames that all streams have reached
+    if(SYNC_ENABLED) {
+        if(layoutChanged)
+            createSyncOutlet();
+        unsigned int frames;
+        while((frames = gSynchroniser.assemble(gSyncFrames.data(), gSyncTimestamps.data(), SYNC_CHUNK_FRAMES)) > 0) {
+            if(gSyncOutlet)
+                gSyncOutlet->push_chunk_multiplexed(gSyncFrames.data(), gSyncTimestamps.data(),
+                    frames * gSynchroniser.getNumChannels());
         }
     }
     
     // If all streams were lost, set flag to resolve again
-    if(streamInlets.empty()) {
+    if(lost && gStreams.getNumActive() == 0) {
         streamsResolved = false;
         rt_printf("All streams lost, will try to resolve again\n");
     }
-}
\ No newline at end of file
+}
+
+// Function to forward everything the relays have received
+void relayStreams(void*)
+{
+    for(auto& relay : gRelays) {
+        if(!relay.isOpen())
+            continue;
+        try {
+            relay.relay();
+        } catch(lsl::lost_error& e) {
+            rt_printf("Relayed stream %s lost: %s\n", relay.getName().c_str(), e.what());
+            relay.close();
+            shouldResolveStreams = true;
+        } catch(std::exception& e) {
+            rt_printf("Error relaying %s: %s\n", relay.getName().c_str(), e.what());
+        }
+    }
+}
+
+// Function to fetch the full metadata of newly found streams
+void fetchMetadata(void*)
+{
+    gMetadata.process();
+}
+
+// Function to push the queued sensor frames to their outlet
+void publishSensors(void*)
+{
+    gSensors.publish();
+}
+
+// Function to pack the queued analog input frames and push them to their outlet
+void publishAnalog(void*)
+{
+    unsigned int channels = gAnalogRing.getNumChannels();
+    unsigned int frames;
+    while((frames = gAnalogRing.read(gAnalogPacket.data(), gAnalogPacketTimestamps.data(), ANALOG_PACKET_FRAMES)) > 0) {
+        // 0..1 maps onto the ADC's 16-bit range
+        for(unsigned int i = 0; i < frames * channels; i++) {
+            float value = std::min(std::max(gAnalogPacket[i], 0.0f), 1.0f) * 65535.0f - 32768.0f;
+            gAnalogSamples[i] = (int16_t)lrintf(value);
+        }
+        gAnalogOutlet.push(gAnalogSamples.data(), frames, gAnalogPacketTimestamps[0]);
+    }
+}
+
+// Function to compute band power features on the streams that have an extractor
+void analyseStreams(void*)
+{
+    for(auto& state : streamStates) {
+        int features = state.featuresState;
+        if(features == featuresClosing) {
+            closeStreamFeatures(state);
+            state.featuresState = featuresClosed;
+        } else if(features == featuresOpen && state.features.isPending()) {
+            state.features.process();
+        }
+    }
+}
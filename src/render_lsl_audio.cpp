@@ -5,11 +5,45 @@
 #include <atomic>
 #include <cstring>
 #include <cmath>
+#include <cstdlib>
+#include "AdpcmCodec.h"
+#include "FrameClock.h"
+#include "FrameRing.h"
+#include "LslLoader.h"
+#include "MemoryBudget.h"
+#include "SpectrumAnalyser.h"
+#include "StreamMetadataCache.h"
+#include "StreamSlotPool.h"
+#include "SyncedPlayback.h"
 
 // Configuration
 const std::string AUDIO_STREAM_NAME = "audio";
 const int AUDIO_BUFFER_FRAMES = 8192;  // Fixed buffer size in frames
 const int MAX_CHANNELS = 8;            // Maximum supported channels
+const int MAX_PULL_FRAMES = 512;       // Largest chunk pulled from the inlet
+
+// Spectrum analysis of the received audio
+const bool SPECTRUM_ENABLED = true;
+const unsigned int SPECTRUM_SIZE = 1024;     // FFT length in frames
+const float SPECTRUM_FRAME_RATE = 15.0f;     // Spectra per second
+const std::string SPECTRUM_OUTLET_NAME = ""; // e.g. "bela-spectrum" to publish spectra over LSL
+
+// Compressed audio transport: IMA ADPCM packets sent as byte-buffer samples
+const std::string COMPRESSED_AUDIO_TYPE = "audio-adpcm";
+const bool AUDIO_OUTLET_ENABLED = false;            // Publish the Bela's audio inputs
+const std::string AUDIO_OUTLET_NAME = "bela-audio";
+const unsigned int ADPCM_PACKET_FRAMES = 128;       // ~3 ms at 44.1 kHz
+
+// Synchronised start: every board playing the stream starts on the same
+// sample and holds alignment with the others (see SyncedPlayback.h). All
+// boards must use the same settings.
+const bool SYNC_START_ENABLED = false;
+SyncedPlayback::Settings makeSyncSettings() {
+    SyncedPlayback::Settings settings;
+    settings.delay = 0.2;      // source timestamp to playout (s)
+    settings.startGrid = 0.5;  // boards start on multiples of this source time (s)
+    return settings;
+}
 
 // Global state flags
 std::atomic<bool> shouldResolveStreams{true};
@@ -18,29 +52,69 @@ std::atomic<bool> audioStreamActive{false};
 // LSL resolver
 lsl::continuous_resolver* resolver = nullptr;
 
-// Audio stream handling
-lsl::stream_inlet* audioInlet = nullptr;
+// Audio stream handling: the inlet and its pull buffers live in a slot
+// allocated in setup(), so reconnecting does not touch the heap
+StreamSlotPool gAudioStreams;
+StreamSlotPool::Slot* audioSlot = nullptr;
 float audioSampleRate = 0.0f;
 int audioChannels = 0;
 double belaSampleRate = 0.0f;
 
+// The inlet and outlet buffers are sized from the RAM free at startup
+// rather than liblsl's 360 s default (over 500 MB for 8 channels at 44.1 kHz)
+const double MEMORY_BUDGET_FRACTION = 0.25; // of the RAM free at startup
+MemoryBudget gMemoryBudget;
+MemoryBudget::Grant audioInletBuffer;
+MemoryBudget::Grant audioOutletBuffer;
+MemoryBudget::Grant spectrumBuffer;
+
+// Decoding of a compressed audio stream. Its format is in the stream's
+// metadata, which is fetched on a worker task rather than in resolve.
+StreamMetadataCache gMetadata;
+bool audioCompressed = false;
+unsigned int audioPacketFrames = 0;
+AdpcmCodec gAudioDecoder;
+
+// Encoding of the Bela's audio inputs into a compressed outlet
+lsl::stream_outlet* audioOutlet = nullptr;
+AdpcmCodec gAudioEncoder;
+FrameRing gAudioInputRing;                 // render() -> encode task
+std::vector<float> inputFrames;            // audioFrames * audioInChannels
+std::vector<double> inputTimestamps;       // audioFrames
+std::vector<float> encodeBuffer;           // ADPCM_PACKET_FRAMES * audioInChannels
+double encodeTimestamps[ADPCM_PACKET_FRAMES] = {0};
+std::vector<char> encodedPacket;
+
 // Fixed-size buffers (no dynamic allocation during runtime)
 float audioBuffer[AUDIO_BUFFER_FRAMES * MAX_CHANNELS] = {0};
-float pullBuffer[1024 * MAX_CHANNELS] = {0};      // Temp buffer for pulling samples
-double timestampBuffer[1024] = {0};              // Temp buffer for timestamps
 
 // Buffer management
 int readPos = 0;
 int writePos = 0;
 int bufferMask = AUDIO_BUFFER_FRAMES - 1;  // For fast modulo with power-of-2 sizes
 
+// Synchronised playback, fed alongside the ring buffer
+SyncedPlayback gPlayback;
+FrameClock gFrameClock;
+std::vector<float> playbackBuffer;         // audioFrames * MAX_CHANNELS
+
+// Spectrum analyser, fed from the ring buffer without consuming it
+SpectrumAnalyser gSpectrum;
+bool spectrumReady = false;
+
 // Auxiliary tasks
 AuxiliaryTask gResolveStreamsTask;
 AuxiliaryTask gFillAudioBufferTask;
+AuxiliaryTask gAnalyseSpectrumTask;
+AuxiliaryTask gEncodeAudioTask;
+AuxiliaryTask gFetchMetadataTask;
 
 // Function prototypes
 void resolveStreams(void*);
 void fillAudioBuffer(void*);
+void analyseSpectrum(void*);
+void encodeAudio(void*);
+void fetchMetadata(void*);
 
 // Return available frames in ring buffer
 int samplesAvailable() {
@@ -50,32 +124,75 @@ int samplesAvailable() {
     return available;
 }
 
+// Pull and decode compressed packets into the temp buffers, up to maxFrames
+int pullCompressedAudio(int maxFrames) {
+    int framesPulled = 0;
+    while (maxFrames - framesPulled >= (int)audioPacketFrames) {
+        char* packet = nullptr;
+        uint32_t packetBytes = 0;
+        int32_t ec = 0;
+        double timestamp = lsl_pull_sample_buf(audioSlot->inlet->handle().get(), &packet, &packetBytes, 1, 0.0, &ec);
+        lsl::check_error(ec);
+        if (timestamp == 0.0)
+            break;
+        
+        unsigned int frames = gAudioDecoder.decode(packet, packetBytes,
+            audioSlot->data + framesPulled * audioChannels, maxFrames - framesPulled);
+        lsl_destroy_string(packet);
+        
+        // The packet timestamp belongs to its first frame
+        for (unsigned int f = 0; f < frames; f++)
+            audioSlot->timestamps[framesPulled + f] = timestamp + f / audioSampleRate;
+        framesPulled += frames;
+    }
+    return framesPulled;
+}
+
 // Fill the audio buffer with samples from LSL
 void fillAudioBuffer(void*) {
-    if (!audioStreamActive || !audioInlet || audioChannels <= 0 || audioChannels > MAX_CHANNELS)
+    if (!audioStreamActive || !audioSlot || audioChannels <= 0 || audioChannels > MAX_CHANNELS)
         return;
     
     try {
-        // Calculate available space
-        int readPosSnapshot = readPos; // Take a snapshot to avoid race conditions
-        int available = readPosSnapshot - writePos - 1;
-        if (available <= 0) available += AUDIO_BUFFER_FRAMES;
+        // Calculate available space; in sync mode render() plays from gPlayback
+        // and the ring buffer only feeds the spectrum analyser
+        int available;
+        if (SYNC_START_ENABLED) {
+            available = gPlayback.getWriteAvailable();
+            try {
+                gPlayback.setCorrection(audioSlot->inlet->time_correction(0.0));
+            } catch (lsl::timeout_error&) {
+                // no estimate yet; keep the previous one
+            }
+        } else {
+            int readPosSnapshot = readPos; // Take a snapshot to avoid race conditions
+            available = readPosSnapshot - writePos - 1;
+            if (available <= 0) available += AUDIO_BUFFER_FRAMES;
+        }
         
         // Limit pull size to our temp buffer and available space
-        int maxFramesToPull = std::min(512, available);
+        int maxFramesToPull = std::min(MAX_PULL_FRAMES, available);
         if (maxFramesToPull <= 0) return;
         
         // Pull samples into our temp buffer
-        std::size_t samples_read = audioInlet->pull_chunk_multiplexed(
-            pullBuffer, 
-            timestampBuffer, 
-            maxFramesToPull * audioChannels, 
-            maxFramesToPull, 
-            0.0);
+        int framesPulled = 0;
+        if (audioCompressed) {
+            framesPulled = pullCompressedAudio(maxFramesToPull);
+        } else {
+            std::size_t samples_read = audioSlot->inlet->pull_chunk_multiplexed(
+                audioSlot->data, 
+                audioSlot->timestamps, 
+                maxFramesToPull * audioChannels, 
+                maxFramesToPull, 
+                0.0);
+            framesPulled = samples_read / audioChannels;
+        }
         
-        // Calculate frames pulled and copy to ring buffer
-        int framesPulled = samples_read / audioChannels;
+        // Copy to ring buffer
         if (framesPulled > 0) {
+            if (SYNC_START_ENABLED)
+                gPlayback.write(audioSlot->data, audioSlot->timestamps, framesPulled);
+            
             // Copy frames to the ring buffer
             for (int f = 0; f < framesPulled; f++) {
                 int bufferIndex = (writePos & bufferMask) * audioChannels;
@@ -83,7 +200,7 @@ void fillAudioBuffer(void*) {
                 
                 // Copy one frame of audio (all channels)
                 for (int ch = 0; ch < audioChannels; ch++) {
-                    audioBuffer[bufferIndex + ch] = pullBuffer[pullIndex + ch];
+                    audioBuffer[bufferIndex + ch] = audioSlot->data[pullIndex + ch];
                 }
                 
                 writePos = (writePos + 1) & bufferMask;
@@ -92,7 +209,13 @@ void fillAudioBuffer(void*) {
             // Occasionally report status
             static int reportCounter = 0;
             if (++reportCounter % 1000 == 0) {
-                rt_printf("Audio buffer: %d/%d frames\n", samplesAvailable(), AUDIO_BUFFER_FRAMES);
+                if (SYNC_START_ENABLED)
+                    rt_printf("Synchronised playback: %s, error %.1f us, rate %.6f, %lu relocks, %lu underruns\n",
+                              gPlayback.getState() == SyncedPlayback::playing ? "playing" : "waiting",
+                              gPlayback.getError() * 1e6, gPlayback.getRate(),
+                              gPlayback.getRelocks(), gPlayback.getUnderruns());
+                else
+                    rt_printf("Audio buffer: %d/%d frames\n", samplesAvailable(), AUDIO_BUFFER_FRAMES);
             }
         }
     } catch (std::exception &e) {
@@ -101,6 +224,76 @@ void fillAudioBuffer(void*) {
     }
 }
 
+// Fetch the metadata of compressed streams
+void fetchMetadata(void*) {
+    gMetadata.process();
+}
+
+// Encode captured input audio and push it to the compressed outlet
+void encodeAudio(void*) {
+    if (!audioOutlet)
+        return;
+    
+    while (gAudioInputRing.getReadAvailable() >= ADPCM_PACKET_FRAMES) {
+        gAudioInputRing.read(encodeBuffer.data(), encodeTimestamps, ADPCM_PACKET_FRAMES);
+        const char* packet = encodedPacket.data();
+        uint32_t packetBytes = gAudioEncoder.encode(encodeBuffer.data(), ADPCM_PACKET_FRAMES, encodedPacket.data());
+        // Timestamp of the first frame; the receiver derives the rest
+        lsl_push_sample_buftp(audioOutlet->handle().get(), &packet, &packetBytes, encodeTimestamps[0], 1);
+    }
+}
+
+// Create the compressed outlet for the Bela's audio inputs
+bool setupAudioOutlet(BelaContext *context) {
+    unsigned int channels = context->audioInChannels;
+    if (!gAudioEncoder.setup(channels) || !gAudioInputRing.setup(channels, 8 * ADPCM_PACKET_FRAMES))
+        return false;
+    inputFrames.resize(context->audioFrames * channels);
+    inputTimestamps.resize(context->audioFrames);
+    encodeBuffer.resize(ADPCM_PACKET_FRAMES * channels);
+    encodedPacket.resize(AdpcmCodec::getPacketBytes(channels, ADPCM_PACKET_FRAMES));
+    
+    lsl::stream_info info(AUDIO_OUTLET_NAME, COMPRESSED_AUDIO_TYPE, 1,
+        belaSampleRate / ADPCM_PACKET_FRAMES, lsl::cf_string, AUDIO_OUTLET_NAME + "-adpcm");
+    info.desc().append_child("encoding")
+        .append_child_value("codec", "ima-adpcm")
+        .append_child_value("channels", std::to_string(channels))
+        .append_child_value("sample_rate", std::to_string(belaSampleRate))
+        .append_child_value("frames_per_packet", std::to_string(ADPCM_PACKET_FRAMES));
+    audioOutletBuffer = gMemoryBudget.reserve(info, MemoryBudget::interactive);
+    if (!audioOutletBuffer) {
+        rt_printf("Not enough memory left to buffer the compressed outlet\n");
+        return false;
+    }
+    audioOutlet = new lsl::stream_outlet(info, 0, audioOutletBuffer.samples, transp_bufsize_samples);
+    rt_printf("Publishing %u input channels as %s (%u bytes per %u frames)\n",
+              channels, AUDIO_OUTLET_NAME.c_str(), (unsigned int)encodedPacket.size(), ADPCM_PACKET_FRAMES);
+    return true;
+}
+
+// Analyse the most recent audio in the ring buffer
+void analyseSpectrum(void*) {
+    if (!audioStreamActive || !spectrumReady)
+        return;
+    
+    // Only the write position is read; readPos and writePos are never modified here
+    int writePosSnapshot = writePos;
+    gSpectrum.analyse(audioBuffer, AUDIO_BUFFER_FRAMES, audioChannels, writePosSnapshot, lsl::local_clock());
+    
+    // Occasionally report the dominant frequency
+    static int reportCounter = 0;
+    if (++reportCounter % (int)(2 * SPECTRUM_FRAME_RATE) == 0 && gSpectrum.update()) {
+        rt_printf("Spectrum peak: %.1f Hz\n", gSpectrum.getPeakFrequency());
+    }
+}
+
+// Close the audio inlet and return its buffer to the budget
+void releaseAudioSlot(StreamSlotPool::Slot* slot) {
+    gAudioStreams.unbind(slot);
+    gMemoryBudget.release(audioInletBuffer);
+    audioInletBuffer = MemoryBudget::Grant();
+}
+
 // Find and connect to LSL streams
 void resolveStreams(void*) {
     if (!resolver) return;
@@ -117,44 +310,106 @@ void resolveStreams(void*) {
         // Look for an audio stream
         for (const auto& info : streams) {
             if (info.name() == AUDIO_STREAM_NAME) {
-                // Check sample rate compatibility
-                if (std::abs(info.nominal_srate() - belaSampleRate) < belaSampleRate * 0.001) {
-                    try {
-                        // Create the inlet
-                        audioChannels = info.channel_count();
-                        if (audioChannels <= 0 || audioChannels > MAX_CHANNELS) {
-                            rt_printf("Invalid channel count: %d (max %d)\n", audioChannels, MAX_CHANNELS);
-                            continue;
-                        }
-                        
-                        audioSampleRate = info.nominal_srate();
-                        
-                        // Create new inlet
-                        if (audioInlet) {
-                            audioInlet->close_stream();
-                            delete audioInlet;
-                        }
-                        
-                        audioInlet = new lsl::stream_inlet(info, 360, 0, true);
-                        audioInlet->open_stream(1.0);
-                        
-                        // Reset buffer positions
-                        readPos = 0;
-                        writePos = 0;
-                        
-                        // Mark as active
-                        audioStreamActive = true;
-                        rt_printf("Connected to audio stream: %d channels, %.1f Hz\n", 
-                                 audioChannels, audioSampleRate);
-                        
-                    } catch (std::exception &e) {
-                        rt_printf("Error creating audio inlet: %s\n", e.what());
-                    }
-                    break;
-                } else {
+                bool compressed = info.channel_format() == lsl::cf_string && info.type() == COMPRESSED_AUDIO_TYPE;
+                if (!compressed && std::abs(info.nominal_srate() - belaSampleRate) >= belaSampleRate * 0.001) {
                     rt_printf("Audio stream found but sample rate mismatch: %.1f Hz vs %.1f Hz\n",
                              info.nominal_srate(), belaSampleRate);
+                    continue;
+                }
+                
+                // Compressed streams are bound once their format is known
+                StreamMetadataCache::Handle metadata = gMetadata.find(info.uid());
+                if (compressed && !metadata) {
+                    if (gMetadata.request(info))
+                        rt_printf("Fetching the format of compressed audio stream %s\n", info.uid().c_str());
+                    Bela_scheduleAuxiliaryTask(gFetchMetadataTask);
+                    continue;
                 }
+                
+                StreamSlotPool::Slot* slot = nullptr;
+                try {
+                    // Bind a new inlet to the audio slot
+                    if (audioSlot) {
+                        releaseAudioSlot(audioSlot);
+                        audioSlot = nullptr;
+                    }
+                    audioInletBuffer = gMemoryBudget.reserve(info, MemoryBudget::realtime);
+                    if (!audioInletBuffer) {
+                        rt_printf("Not enough memory left to buffer the audio stream\n");
+                        continue;
+                    }
+                    slot = gAudioStreams.bind(info, audioInletBuffer.samples, 0, true, transp_bufsize_samples);
+                    if (!slot) {
+                        gMemoryBudget.release(audioInletBuffer);
+                        audioInletBuffer = MemoryBudget::Grant();
+                        rt_printf("Invalid channel count: %d (max %d)\n", info.channel_count(), MAX_CHANNELS);
+                        continue;
+                    }
+                    
+                    // Compressed streams describe the audio format in their metadata
+                    int channels = info.channel_count();
+                    double sampleRate = info.nominal_srate();
+                    unsigned int packetFrames = 0;
+                    if (compressed) {
+                        lsl::stream_info full = metadata->info;
+                        lsl::xml_element encoding = full.desc().child("encoding");
+                        channels = atoi(encoding.child_value("channels"));
+                        sampleRate = atof(encoding.child_value("sample_rate"));
+                        packetFrames = atoi(encoding.child_value("frames_per_packet"));
+                    }
+                    
+                    // Check channel count and sample rate compatibility
+                    if (channels <= 0 || channels > MAX_CHANNELS) {
+                        rt_printf("Invalid channel count: %d (max %d)\n", channels, MAX_CHANNELS);
+                        releaseAudioSlot(slot);
+                        continue;
+                    }
+                    if (std::abs(sampleRate - belaSampleRate) >= belaSampleRate * 0.001 ||
+                        (compressed && (packetFrames == 0 || packetFrames > (unsigned int)MAX_PULL_FRAMES || !gAudioDecoder.setup(channels)))) {
+                        rt_printf("Audio stream found but format mismatch: %.1f Hz vs %.1f Hz\n",
+                                 sampleRate, belaSampleRate);
+                        releaseAudioSlot(slot);
+                        continue;
+                    }
+                    
+                    // Source-to-local clock offset, and smooth timestamps to play them against
+                    if (SYNC_START_ENABLED) {
+                        slot->inlet->set_postprocessing(lsl::post_dejitter);
+                        double correction = slot->inlet->time_correction(2.0);
+                        // Fits in the buffers allocated in setup()
+                        gPlayback.setup(channels, belaSampleRate, AUDIO_BUFFER_FRAMES, makeSyncSettings());
+                        gPlayback.setCorrection(correction);
+                    }
+                    
+                    audioChannels = channels;
+                    audioSampleRate = sampleRate;
+                    audioCompressed = compressed;
+                    audioPacketFrames = packetFrames;
+                    slot->channels = channels;
+                    slot->sampleRate = sampleRate;
+                    audioSlot = slot;
+                    audioSlot->inlet->open_stream(1.0);
+                    gAudioStreams.activate(audioSlot);
+                    
+                    // Reset buffer positions
+                    readPos = 0;
+                    writePos = 0;
+                    
+                    // Mark as active
+                    audioStreamActive = true;
+                    rt_printf("Connected to %saudio stream: %d channels, %.1f Hz\n", 
+                             audioCompressed ? "compressed " : "", audioChannels, audioSampleRate);
+                    
+                } catch (std::exception &e) {
+                    rt_printf("Error creating audio inlet: %s\n", e.what());
+                    if (slot && slot != audioSlot)
+                        releaseAudioSlot(slot);
+                    else if (!slot) {
+                        gMemoryBudget.release(audioInletBuffer);
+                        audioInletBuffer = MemoryBudget::Grant();
+                    }
+                }
+                break;
             }
         }
     }
@@ -165,6 +420,27 @@ bool setup(BelaContext *context, void *userData) {
     belaSampleRate = context->audioSampleRate;
     rt_printf("Bela running at sample rate: %.1f Hz\n", belaSampleRate);
     
+    // liblsl is loaded at run time; say why if it can't be
+    if (!loadLsl()) {
+        rt_printf("Error loading liblsl: %s\n", getLslLoadError());
+        return false;
+    }
+    
+    if (!gMemoryBudget.setup(MEMORY_BUDGET_FRACTION))
+        return false;
+    
+    // One slot for the audio inlet and its pull buffers
+    if (!gAudioStreams.setup(1, MAX_CHANNELS, MAX_PULL_FRAMES))
+        return false;
+    
+    // Size the synchronised playback for the widest stream
+    if (SYNC_START_ENABLED) {
+        if (!gPlayback.setup(MAX_CHANNELS, belaSampleRate, AUDIO_BUFFER_FRAMES, makeSyncSettings()))
+            return false;
+        gFrameClock.setup(belaSampleRate);
+        playbackBuffer.resize(context->audioFrames * MAX_CHANNELS);
+    }
+    
     // Create auxiliary tasks
     if ((gResolveStreamsTask = Bela_createAuxiliaryTask(&resolveStreams, 50, "resolve-streams")) == 0)
         return false;
@@ -172,6 +448,42 @@ bool setup(BelaContext *context, void *userData) {
     if ((gFillAudioBufferTask = Bela_createAuxiliaryTask(&fillAudioBuffer, 80, "fill-audio-buffer")) == 0)
         return false;
     
+    if ((gFetchMetadataTask = Bela_createAuxiliaryTask(&fetchMetadata, 30, "fetch-metadata")) == 0)
+        return false;
+    gMetadata.setup();
+    
+    // Set up the spectrum analyser on a low-priority task
+    if (SPECTRUM_ENABLED) {
+        // One channel per bin
+        spectrumBuffer = gMemoryBudget.reserve(SPECTRUM_SIZE / 2 + 1, lsl::cf_float32, SPECTRUM_FRAME_RATE,
+            MemoryBudget::interactive);
+        try {
+            if (spectrumBuffer)
+                spectrumReady = gSpectrum.setup(SPECTRUM_SIZE, belaSampleRate, SPECTRUM_FRAME_RATE,
+                                                SPECTRUM_OUTLET_NAME, spectrumBuffer.samples);
+            else
+                rt_printf("Not enough memory left to buffer the spectrum outlet\n");
+        } catch (std::exception &e) {
+            rt_printf("Error creating spectrum outlet: %s\n", e.what());
+        }
+        if (spectrumReady &&
+            (gAnalyseSpectrumTask = Bela_createAuxiliaryTask(&analyseSpectrum, 10, "analyse-spectrum")) == 0)
+            return false;
+    }
+    
+    // Set up the compressed outlet for the audio inputs
+    if (AUDIO_OUTLET_ENABLED) {
+        try {
+            if (!setupAudioOutlet(context))
+                return false;
+        } catch (std::exception &e) {
+            rt_printf("Error creating audio outlet: %s\n", e.what());
+            return false;
+        }
+        if ((gEncodeAudioTask = Bela_createAuxiliaryTask(&encodeAudio, 60, "encode-audio")) == 0)
+            return false;
+    }
+    
     // Create resolver
     resolver = new lsl::continuous_resolver();
     
@@ -196,6 +508,40 @@ void render(BelaContext *context, void *userData) {
         Bela_scheduleAuxiliaryTask(gFillAudioBufferTask);
     }
     
+    // Schedule spectrum analysis at the configured frame rate
+    static unsigned int spectrumCounter = 0;
+    unsigned int spectrumInterval = std::max(1u, (unsigned int)(context->audioSampleRate / context->audioFrames / SPECTRUM_FRAME_RATE));
+    if (spectrumReady && audioStreamActive && ++spectrumCounter % spectrumInterval == 0) {
+        Bela_scheduleAuxiliaryTask(gAnalyseSpectrumTask);
+    }
+    
+    // Capture the inputs for the compressed outlet
+    if (audioOutlet) {
+        unsigned int channels = context->audioInChannels;
+        double blockTime = lsl::local_clock();
+        for (unsigned int n = 0; n < context->audioFrames; n++) {
+            for (unsigned int ch = 0; ch < channels; ch++)
+                inputFrames[n * channels + ch] = audioRead(context, n, ch);
+            inputTimestamps[n] = blockTime + n / context->audioSampleRate;
+        }
+        gAudioInputRing.write(inputFrames.data(), inputTimestamps.data(), context->audioFrames);
+        if (gAudioInputRing.getReadAvailable() >= ADPCM_PACKET_FRAMES)
+            Bela_scheduleAuxiliaryTask(gEncodeAudioTask);
+    }
+    
+    // Output audio in step with the other boards
+    if (SYNC_START_ENABLED) {
+        double blockTime = gFrameClock.update(context->audioFramesElapsed, lsl::local_clock());
+        unsigned int channels = audioStreamActive ? gPlayback.getNumChannels() : 0;
+        if (channels > 0)
+            gPlayback.process(playbackBuffer.data(), context->audioFrames, blockTime);
+        for (unsigned int n = 0; n < context->audioFrames; n++) {
+            for (unsigned int ch = 0; ch < context->audioOutChannels; ch++)
+                audioWrite(context, n, ch, ch < channels ? playbackBuffer[n * channels + ch] : 0.0f);
+        }
+        return;
+    }
+    
     // Output audio
     for (unsigned int n = 0; n < context->audioFrames; n++) {
         if (audioStreamActive && samplesAvailable() > 0) {
@@ -220,10 +566,15 @@ void render(BelaContext *context, void *userData) {
 
 void cleanup(BelaContext *context, void *userData) {
     // Clean up audio inlet
-    if (audioInlet) {
-        audioInlet->close_stream();
-        delete audioInlet;
-        audioInlet = nullptr;
+    if (audioSlot) {
+        releaseAudioSlot(audioSlot);
+        audioSlot = nullptr;
+    }
+    
+    // Clean up audio outlet
+    if (audioOutlet) {
+        delete audioOutlet;
+        audioOutlet = nullptr;
     }
     
     // Clean up resolver
@@ -0,0 +1,143 @@
+#include <Bela.h>
+#include <lsl_cpp.h>
+#include <string>
+#include <vector>
+#include "GraphNodes.h"
+#include "LslLoader.h"
+#include "ProcessingGraph.h"
+
+// The receive / filter / publish plumbing of the other examples, declared as
+// a ProcessingGraph instead of hand-written rings and tasks:
+//
+//   audio inlet -> resampler -> mixer -> audio out
+//   audio in ----> router ----'
+//   EEG inlet ---> biquad ----> outlet "<EEG_STREAM_TYPE>-filtered"
+//                         '---> recorder
+//
+// Nodes that may block run on the graph-worker task; the rest run in render()
+// when they feed the audio output.
+
+// Configuration
+const std::string AUDIO_QUERY = "name='audio'";
+const unsigned int AUDIO_CHANNELS = 2;
+const double AUDIO_SAMPLE_RATE = 22050.0;    // Rate of the incoming stream
+const float MONITOR_GAIN = 0.0f;             // Bela inputs mixed into the output
+
+const std::string EEG_STREAM_TYPE = "EEG";
+const unsigned int EEG_CHANNELS = 8;
+const double EEG_SAMPLE_RATE = 250.0;
+const std::string EEG_RECORDING = "eeg-filtered.bin"; // empty to disable
+
+ProcessingGraph gGraph;
+AudioInputNode* gAudioIn = nullptr;
+AudioOutputNode* gAudioOut = nullptr;
+InletSourceNode* gAudioInlet = nullptr;
+
+AuxiliaryTask gGraphWorkerTask;
+
+void processGraphWorker(void*)
+{
+    gGraph.processWorker();
+}
+
+bool buildGraph(BelaContext *context)
+{
+    const PortType output{AUDIO_CHANNELS, context->audioSampleRate};
+    const PortType input{context->audioInChannels, context->audioSampleRate};
+    const PortType eeg{EEG_CHANNELS, EEG_SAMPLE_RATE};
+
+    // Audio: network stream resampled to the Bela rate, plus the inputs
+    gAudioInlet = gGraph.add<InletSourceNode>(AUDIO_QUERY, AUDIO_CHANNELS, AUDIO_SAMPLE_RATE);
+    ResamplerNode* resampler = gGraph.add<ResamplerNode>(AUDIO_CHANNELS, AUDIO_SAMPLE_RATE, context->audioSampleRate);
+    gAudioIn = gGraph.add<AudioInputNode>(input);
+    std::vector<int> monitorChannels;
+    for (unsigned int ch = 0; ch < AUDIO_CHANNELS; ch++)
+        monitorChannels.push_back(ch < context->audioInChannels ? ch : -1);
+    RouterNode* monitor = gGraph.add<RouterNode>(input, monitorChannels);
+    MixerNode* mixer = gGraph.add<MixerNode>(2, output);
+    mixer->setGain(1, MONITOR_GAIN);
+    gAudioOut = gGraph.add<AudioOutputNode>(output);
+
+    bool connected = gGraph.connect(gAudioInlet, 0, resampler, 0)
+        && gGraph.connect(resampler, 0, mixer, 0)
+        && gGraph.connect(gAudioIn, 0, monitor, 0)
+        && gGraph.connect(monitor, 0, mixer, 1)
+        // The mixer makes one block per render(), so two blocks ahead of the
+        // output are enough, and a burst cannot add latency there
+        && gGraph.connect(mixer, 0, gAudioOut, 0, 2 * context->audioFrames);
+
+    // EEG: mains notch and band limit, republished and recorded
+    InletSourceNode* eegInlet = gGraph.add<InletSourceNode>("type='" + EEG_STREAM_TYPE + "'", EEG_CHANNELS, EEG_SAMPLE_RATE);
+    BiquadNode* filter = gGraph.add<BiquadNode>(eeg, std::vector<BiquadBank::Stage>{
+        {BiquadBank::notch, 50.0f, 30.0f},
+        {BiquadBank::highpass, 0.5f, 0.707f},
+        {BiquadBank::lowpass, 100.0f, 0.707f},
+    });
+    lsl::stream_info info(EEG_STREAM_TYPE + "-filtered", EEG_STREAM_TYPE, EEG_CHANNELS, EEG_SAMPLE_RATE, lsl::cf_float32, "bela-graph-eeg");
+    OutletSinkNode* outlet = gGraph.add<OutletSinkNode>(info);
+
+    connected = connected
+        && gGraph.connect(eegInlet, 0, filter, 0)
+        && gGraph.connect(filter, 0, outlet, 0);
+    if (connected && !EEG_RECORDING.empty()) {
+        RecorderNode* recorder = gGraph.add<RecorderNode>(EEG_RECORDING, eeg);
+        connected = gGraph.connect(filter, 0, recorder, 0);
+    }
+
+    return connected && gGraph.build(context->audioFrames);
+}
+
+bool setup(BelaContext *context, void *userData)
+{
+    if (!loadLsl()) {
+        rt_printf("Error loading liblsl: %s\n", getLslLoadError());
+        return false;
+    }
+    rt_printf("Using LSL library version: %d.%d\n",
+              lsl::library_version() / 100,
+              lsl::library_version() % 100);
+
+    if (!buildGraph(context)) {
+        rt_printf("Error building the processing graph: %s\n", gGraph.getError().c_str());
+        return false;
+    }
+    for (unsigned int n = 0; n < gGraph.getNumNodes(); n++) {
+        const GraphNode* node = gGraph.getNode(n);
+        rt_printf("  %-32s %s\n", node->getName().c_str(), gGraph.isRealtime(node) ? "render" : "worker");
+    }
+
+    if ((gGraphWorkerTask = Bela_createAuxiliaryTask(&processGraphWorker, 80, "graph-worker")) == 0)
+        return false;
+
+    return true;
+}
+
+void render(BelaContext *context, void *userData)
+{
+    float* in = gAudioIn->getBlock();
+    for (unsigned int n = 0; n < context->audioFrames; n++)
+        for (unsigned int ch = 0; ch < context->audioInChannels; ch++)
+            in[n * context->audioInChannels + ch] = audioRead(context, n, ch);
+    gAudioIn->setTimestamp(lsl::local_clock());
+
+    gGraph.processRealtime();
+
+    const float* out = gAudioOut->getBlock();
+    for (unsigned int n = 0; n < context->audioFrames; n++)
+        for (unsigned int ch = 0; ch < context->audioOutChannels; ch++)
+            audioWrite(context, n, ch, ch < AUDIO_CHANNELS ? out[n * AUDIO_CHANNELS + ch] : 0.0f);
+
+    Bela_scheduleAuxiliaryTask(gGraphWorkerTask);
+}
+
+void cleanup(BelaContext *context, void *userData)
+{
+    // Per-node timing, e.g. to see what a stage costs on the board
+    for (unsigned int n = 0; n < gGraph.getNumNodes(); n++) {
+        const GraphNode* node = gGraph.getNode(n);
+        const GraphNode::Stats& stats = node->getStats();
+        rt_printf("%-32s %10lu frames, mean %.1f us, max %.1f us\n", node->getName().c_str(), stats.frames,
+                  stats.calls ? stats.totalMicroseconds / stats.calls : 0.0, stats.maxMicroseconds);
+    }
+    rt_printf("Audio underruns: %lu\n", gAudioOut->getUnderruns());
+}
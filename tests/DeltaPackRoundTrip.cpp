@@ -0,0 +1,81 @@
+// Round-trip check for DeltaPackCodec: every packet must decode to exactly
+// the samples it was encoded from, for every integer format, including
+// swings between a format's extremes (the widest deltas it can produce).
+//
+// Host only; from the repository root:
+//   g++ -std=c++14 -O2 -Isrc -Isrc/include tests/DeltaPackRoundTrip.cpp src/DeltaPackCodec.cpp -o /tmp/delta-round-trip
+//   /tmp/delta-round-trip
+#include "DeltaPackCodec.h"
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+enum Pattern { randomWalk, uniform, extremes, constant, kNumPatterns };
+
+template <class T>
+static T sample(Pattern pattern, std::mt19937_64& random, T previous, unsigned int frame)
+{
+    const T low = std::numeric_limits<T>::min();
+    const T high = std::numeric_limits<T>::max();
+    switch (pattern) {
+    case randomWalk: {
+        long long step = (long long)(random() % 65) - 32;
+        long long next = (long long)previous + step;
+        return next < (long long)low ? low : next > (long long)high ? high : (T)next;
+    }
+    case uniform: return (T)random();
+    case extremes: return (frame & 1) ? high : low;
+    default: return (T)12345;
+    }
+}
+
+template <class T>
+static unsigned int check(lsl::channel_format_t format, const char* name)
+{
+    std::mt19937_64 random(1);
+    const unsigned int maxFrames = 256;
+    const unsigned int frameCounts[] = {1, 2, 3, 7, 64, 255, 256};
+    const unsigned int channelCounts[] = {1, 3, 4, 5, 16, 64};
+    unsigned int failures = 0;
+    unsigned int packets = 0;
+    for (unsigned int channels : channelCounts) {
+        DeltaPackCodec encoder, decoder;
+        if (!encoder.setup(channels, format, maxFrames) || !decoder.setup(channels, format, maxFrames)) {
+            printf("%s: setup failed for %u channels\n", name, channels);
+            return 1;
+        }
+        std::vector<T> in(maxFrames * channels), out(maxFrames * channels);
+        std::vector<char> packet(encoder.getMaxPacketBytes(maxFrames));
+        for (unsigned int frames : frameCounts) {
+            for (int p = 0; p < kNumPatterns; p++) {
+                for (unsigned int ch = 0; ch < channels; ch++) {
+                    T value = sample<T>((Pattern)p, random, 0, ch);
+                    for (unsigned int f = 0; f < frames; f++) {
+                        value = sample<T>((Pattern)p, random, value, f + ch);
+                        in[f * channels + ch] = value;
+                    }
+                }
+                unsigned int bytes = encoder.encode(in.data(), frames, packet.data());
+                std::fill(out.begin(), out.end(), 0);
+                unsigned int decoded = decoder.decode(packet.data(), bytes, out.data(), maxFrames);
+                packets++;
+                if (bytes > encoder.getMaxPacketBytes(frames) || decoded != frames ||
+                    memcmp(in.data(), out.data(), frames * channels * sizeof(T)) != 0) {
+                    printf("%s: mismatch with %u channels, %u frames, pattern %d\n", name, channels, frames, p);
+                    failures++;
+                }
+            }
+        }
+    }
+    printf("%s: %u packets, %u failures\n", name, packets, failures);
+    return failures;
+}
+
+int main()
+{
+    unsigned int failures = check<int8_t>(lsl::cf_int8, "int8") + check<int16_t>(lsl::cf_int16, "int16") +
+        check<int32_t>(lsl::cf_int32, "int32") + check<int64_t>(lsl::cf_int64, "int64");
+    return failures ? 1 : 0;
+}
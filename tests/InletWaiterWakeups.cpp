@@ -0,0 +1,107 @@
+// InletWaiter against simulated inlets, in real time: one stream delivering
+// a chunk every 20 ms and two that stay silent, waited on as render.cpp's
+// pull loop does (at most PULL_WAIT per wait). Every chunk must be noticed
+// before the next one is due, the waiter must wake far less often than a
+// per-block poll would (2756 times per second at 44.1 kHz in 16-frame
+// blocks), and the silent streams must still be reported every maxIdle.
+//
+// The liblsl calls InletWaiter makes are stubbed below, so it needs neither
+// the library nor a network. Host only; from the repository root:
+//   g++ -std=c++14 -O2 -Isrc -Isrc/include tests/InletWaiterWakeups.cpp src/InletWaiter.cpp -o /tmp/inlet-waiter-wakeups
+//   /tmp/inlet-waiter-wakeups
+#include "InletWaiter.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+namespace {
+const unsigned int kStreams = 3;
+const double kRates[kStreams] = {500.0, 100.0, 0.0}; // nominal; only the first delivers
+const double kChunkInterval = 0.02;                  // s between the first stream's chunks
+const double kPullWait = 0.01;                       // as PULL_WAIT in render.cpp
+const double kDuration = 3.0;                        // s
+const double kPollRate = 44100.0 / 16.0;             // wake-ups per second when polling every block
+
+double gStart = 0.0;
+double gNextChunk = kChunkInterval; // when the first stream's next chunk lands
+bool gChunkQueued = false;
+
+double monotonic()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+} // namespace
+
+// Inlet handles are the stream number plus one
+extern "C" {
+double lsl_local_clock() { return monotonic() - gStart; }
+lsl_inlet lsl_create_inlet_ex(lsl_streaminfo, int32_t, int32_t, int32_t, lsl_transport_options_t)
+{
+    static long next = 1;
+    return (lsl_inlet)next++;
+}
+int32_t lsl_get_channel_count(lsl_streaminfo) { return 1; }
+void lsl_destroy_inlet(lsl_inlet) {}
+void lsl_destroy_streaminfo(lsl_streaminfo) {}
+uint32_t lsl_samples_available(lsl_inlet inlet)
+{
+    if ((long)inlet != 1)
+        return 0;
+    if (!gChunkQueued && lsl_local_clock() >= gNextChunk)
+        gChunkQueued = true;
+    return gChunkQueued ? 10 : 0;
+}
+}
+
+int main()
+{
+    gStart = monotonic();
+    lsl::stream_info info((lsl_streaminfo)1);
+    lsl::stream_inlet inlets[kStreams] = {lsl::stream_inlet(info), lsl::stream_inlet(info), lsl::stream_inlet(info)};
+    InletWaiter::Settings settings;
+    InletWaiter waiter;
+    waiter.setup(kStreams, settings);
+    for (unsigned int n = 0; n < kStreams; n++)
+        waiter.watch(n, &inlets[n], kRates[n]);
+
+    unsigned int chunks = 0;
+    double totalLatency = 0.0;
+    double maxLatency = 0.0;
+    double lastReported[kStreams] = {};
+    double maxSilentGap = 0.0;
+    while (lsl_local_clock() < kDuration) {
+        waiter.wait(kPullWait);
+        double now = lsl_local_clock();
+        if (waiter.isReady(0) && gChunkQueued) {
+            double latency = now - gNextChunk;
+            totalLatency += latency;
+            maxLatency = std::max(maxLatency, latency);
+            chunks++;
+            gChunkQueued = false;
+            gNextChunk += kChunkInterval;
+        }
+        for (unsigned int n = 1; n < kStreams; n++) {
+            if (waiter.isReady(n)) {
+                maxSilentGap = std::max(maxSilentGap, now - lastReported[n]);
+                lastReported[n] = now;
+            }
+        }
+    }
+    double end = lsl_local_clock();
+    for (unsigned int n = 1; n < kStreams; n++)
+        maxSilentGap = std::max(maxSilentGap, end - lastReported[n]);
+
+    unsigned int expected = (unsigned int)(end / kChunkInterval);
+    double wakeupRate = waiter.getWakeups() / end;
+    double meanLatency = chunks ? totalLatency / chunks : 0.0;
+    bool ok = chunks + 1 >= expected && maxLatency < kChunkInterval && wakeupRate < kPollRate / 4.0 &&
+              maxSilentGap < settings.maxIdle + 2.0 * settings.maxSleep;
+    printf("%u of %u chunks, mean detection latency %.2f ms, worst %.2f ms\n", chunks, expected, meanLatency * 1000.0,
+           maxLatency * 1000.0);
+    printf("%.0f wake-ups per second (%.0f when polling every block), %.0f%% empty\n", wakeupRate, kPollRate,
+           100.0 * waiter.getEmptyWakeups() / std::max(waiter.getWakeups(), 1ul));
+    printf("silent streams reported at least every %.0f ms%s\n", maxSilentGap * 1000.0, ok ? "" : "\nFAILED");
+    return ok ? 0 : 1;
+}
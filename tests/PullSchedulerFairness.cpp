@@ -0,0 +1,120 @@
+// PullScheduler in simulated time, as render.cpp's pull loop drives it: a
+// 44.1 kHz audio stream (critical), a marker stream (events) and two bulk
+// streams that connect with a backlog, 20000 frames at 2 kHz and 3000 at
+// 250 Hz. Every pull costs a fixed overhead plus a cost per frame, with bulk
+// frames (64 channels) much dearer than audio ones.
+//
+// The audio must never carry a backlog from one round into the next, so
+// what is left of it after a round is only what arrived during that round.
+// Markers must be served in the round they arrive, no round may run much
+// past the class budgets, and the bulk backlogs must be worked off.
+//
+// Host only; from the repository root:
+//   g++ -std=c++14 -O2 -Isrc tests/PullSchedulerFairness.cpp src/PullScheduler.cpp -o /tmp/pull-scheduler-fairness
+//   /tmp/pull-scheduler-fairness
+#include "PullScheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+const unsigned int kChunkFrames = 64; // CHUNK_FRAMES in render.cpp
+const double kPullOverhead = 20e-6;   // s per pull
+const double kMinRound = 0.001;       // s; the waiter wakes about this often for audio
+const double kDuration = 10.0;        // s of simulated time
+const double kMarkerInterval = 0.05;  // s between bursts of kMarkerBurst markers
+const unsigned int kMarkerBurst = 3;
+
+struct Stream {
+    const char* name;
+    PullScheduler::Priority priority;
+    double rate;          // Hz, 0 for irregular
+    double frameCost;     // s per frame pulled
+    double queued;        // frames waiting in the inlet
+    double drainedAt;     // s when a backlog was first worked off, or -1
+};
+} // namespace
+
+int main()
+{
+    Stream streams[] = {
+        {"audio", PullScheduler::critical, 44100.0, 2e-6, 0.0, 0.0},
+        {"markers", PullScheduler::events, 0.0, 5e-6, 0.0, 0.0},
+        {"eeg", PullScheduler::bulk, 2000.0, 64e-6, 20000.0, -1.0},
+        {"slow", PullScheduler::bulk, 250.0, 64e-6, 3000.0, -1.0},
+    };
+    const unsigned int numStreams = sizeof(streams) / sizeof(streams[0]);
+    PullScheduler::Settings settings;
+    PullScheduler scheduler;
+    scheduler.setup(numStreams, kChunkFrames, settings);
+    for (unsigned int n = 0; n < numStreams; n++)
+        scheduler.add(n, streams[n].priority, streams[n].rate);
+
+    double t = 0.0;
+    double nextMarkers = kMarkerInterval;
+    double maxAudioBacklog = 0.0; // s of audio left after a round
+    unsigned long audioCarried = 0; // rounds that left more than had arrived during them
+    double maxRound = 0.0;
+    unsigned long rounds = 0;
+    unsigned long lateMarkers = 0;
+    // Pulls take time, during which more frames arrive
+    auto advance = [&](double seconds) {
+        for (unsigned int n = 0; n < numStreams; n++)
+            streams[n].queued += streams[n].rate * seconds;
+        t += seconds;
+        if (t >= nextMarkers) {
+            streams[1].queued += kMarkerBurst;
+            nextMarkers += kMarkerInterval;
+        }
+    };
+
+    while (t < kDuration) {
+        double roundStart = t;
+        for (unsigned int n = 0; n < numStreams; n++)
+            scheduler.setReady(n, streams[n].queued >= 1.0);
+        bool markersWaiting = streams[1].queued >= 1.0;
+        scheduler.beginRound(t);
+        int n;
+        unsigned int maxFrames;
+        while ((n = scheduler.next(maxFrames)) >= 0) {
+            Stream& stream = streams[n];
+            unsigned int frames = std::min((unsigned int)stream.queued, maxFrames);
+            double cost = kPullOverhead + frames * stream.frameCost;
+            stream.queued -= frames;
+            bool drained = stream.queued < 1.0;
+            advance(cost);
+            scheduler.complete(n, frames, drained, cost);
+        }
+        rounds++;
+        maxRound = std::max(maxRound, t - roundStart);
+        // Markers that were waiting at the start must be gone by the end
+        if (markersWaiting && streams[1].queued >= kMarkerBurst)
+            lateMarkers++;
+        // What audio is left must have arrived during this round
+        maxAudioBacklog = std::max(maxAudioBacklog, streams[0].queued / streams[0].rate);
+        if (streams[0].queued > streams[0].rate * (t - roundStart) + 1.0)
+            audioCarried++;
+        for (unsigned int s = 2; s < numStreams; s++) {
+            if (streams[s].drainedAt < 0.0 && streams[s].queued <= streams[s].rate * settings.latency[PullScheduler::bulk])
+                streams[s].drainedAt = t;
+        }
+        if (t < roundStart + kMinRound)
+            advance(roundStart + kMinRound - t);
+    }
+
+    double roundLimit = settings.streamTime[PullScheduler::critical] + settings.streamTime[PullScheduler::events] +
+                        settings.classTime[PullScheduler::bulk] + kPullOverhead + kChunkFrames * 64e-6;
+    bool ok = audioCarried == 0 && lateMarkers == 0 && maxRound <= roundLimit;
+    printf("%lu rounds, longest %.2f ms (limit %.2f ms)\n", rounds, maxRound * 1000.0, roundLimit * 1000.0);
+    printf("audio left after a round at most %.2f ms, carried over in %lu rounds; markers left waiting in %lu rounds\n",
+           maxAudioBacklog * 1000.0, audioCarried, lateMarkers);
+    for (unsigned int s = 2; s < numStreams; s++) {
+        bool drained = streams[s].drainedAt >= 0.0;
+        printf("%s: backlog worked off after %.2f s, %.0f frames queued at the end\n", streams[s].name,
+               drained ? streams[s].drainedAt : kDuration, streams[s].queued);
+        ok = ok && drained;
+    }
+    printf("deferrals: critical %lu, events %lu, bulk %lu%s\n", scheduler.getDeferrals(PullScheduler::critical),
+           scheduler.getDeferrals(PullScheduler::events), scheduler.getDeferrals(PullScheduler::bulk), ok ? "" : "\nFAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,325 @@
+// SharedMemoryOutlet to SharedMemoryInlet through a real POSIX shared-memory
+// ring, with the liblsl calls they make stubbed below. Checks that:
+//   - chunks and their timestamps arrive intact, and the TCP outlet gets
+//     every push too
+//   - a blocking pull sleeps until a push from another thread wakes it
+//   - a chunk that does not fit keeps its oldest frames, stamped as part of
+//     the whole chunk, and the rest are counted as dropped
+//   - rewriting the capacity in the shared header after the ring is opened
+//     changes nothing at either end
+//   - destroying the outlet wakes a blocked pull with lsl::lost_error
+//   - stale or foreign rings (bad magic, channel count, capacity that is not
+//     a power of two or does not fit the mapping, outlet gone, already
+//     claimed) are refused and the inlet falls back to TCP
+//
+// Host only; from the repository root:
+//   g++ -std=c++14 -O2 -pthread -Isrc -Isrc/include tests/SharedMemoryStreamRing.cpp src/SharedMemoryStream.cpp -lrt -o /tmp/shared-memory-stream-ring
+//   /tmp/shared-memory-stream-ring
+#include "SharedMemoryStream.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+struct FakeInfo {
+    std::string name, type, sourceId, uid;
+    int32_t channels;
+    double rate;
+    lsl_channel_format_t format;
+};
+struct FakeOutlet {
+    FakeInfo info;
+};
+
+std::atomic<double> gClock{0.0}; // lsl::local_clock(); negative for the real clock
+unsigned int gInletsCreated = 0; // TCP fallbacks
+unsigned long gFramesPushed = 0; // to the TCP outlets
+
+double monotonic()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// The ring header as SharedMemoryStream.cpp lays it out
+struct Header {
+    uint32_t magic;
+    uint32_t channels;
+    uint32_t capacity;
+    uint32_t alive;
+    uint32_t claimed;
+    uint32_t waiting;
+    uint32_t writeCount;
+    uint32_t readCount;
+};
+const uint32_t kMagic = 0x4c534c31;
+} // namespace
+
+extern "C" {
+double lsl_local_clock()
+{
+    double clock = gClock.load();
+    return clock >= 0.0 ? clock : monotonic();
+}
+lsl_streaminfo lsl_create_streaminfo(const char* name, const char* type, int32_t channels, double rate,
+                                     lsl_channel_format_t format, const char* sourceId)
+{
+    static unsigned int next = 0;
+    std::string uid = "shm-test-" + std::to_string(getpid()) + "-" + std::to_string(next++);
+    return (lsl_streaminfo) new FakeInfo{name, type, sourceId, uid, channels, rate, format};
+}
+void lsl_destroy_streaminfo(lsl_streaminfo info) { delete (FakeInfo*)info; }
+lsl_streaminfo lsl_copy_streaminfo(lsl_streaminfo info) { return (lsl_streaminfo) new FakeInfo(*(FakeInfo*)info); }
+int32_t lsl_get_channel_count(lsl_streaminfo info) { return ((FakeInfo*)info)->channels; }
+double lsl_get_nominal_srate(lsl_streaminfo info) { return ((FakeInfo*)info)->rate; }
+lsl_channel_format_t lsl_get_channel_format(lsl_streaminfo info) { return ((FakeInfo*)info)->format; }
+const char* lsl_get_uid(lsl_streaminfo info) { return ((FakeInfo*)info)->uid.c_str(); }
+const char* lsl_get_hostname(lsl_streaminfo)
+{
+    static char hostname[256] = {};
+    gethostname(hostname, sizeof(hostname) - 1);
+    return hostname;
+}
+lsl_outlet lsl_create_outlet_ex(lsl_streaminfo info, int32_t, int32_t, lsl_transport_options_t)
+{
+    return (lsl_outlet) new FakeOutlet{*(FakeInfo*)info};
+}
+void lsl_destroy_outlet(lsl_outlet outlet) { delete (FakeOutlet*)outlet; }
+lsl_streaminfo lsl_get_info(lsl_outlet outlet) { return (lsl_streaminfo) new FakeInfo(((FakeOutlet*)outlet)->info); }
+int32_t lsl_push_chunk_ftnp(lsl_outlet outlet, const float*, unsigned long elements, const double*, int32_t)
+{
+    gFramesPushed += elements / ((FakeOutlet*)outlet)->info.channels;
+    return 0;
+}
+int32_t lsl_push_chunk_ftp(lsl_outlet outlet, const float*, unsigned long elements, double, int32_t)
+{
+    gFramesPushed += elements / ((FakeOutlet*)outlet)->info.channels;
+    return 0;
+}
+lsl_inlet lsl_create_inlet_ex(lsl_streaminfo, int32_t, int32_t, int32_t, lsl_transport_options_t)
+{
+    gInletsCreated++;
+    return (lsl_inlet)1;
+}
+void lsl_destroy_inlet(lsl_inlet) {}
+void lsl_open_stream(lsl_inlet, double, int32_t* ec) { *ec = 0; }
+double lsl_time_correction(lsl_inlet, double, int32_t* ec)
+{
+    *ec = 0;
+    return 0.0;
+}
+unsigned long lsl_pull_chunk_f(lsl_inlet, float*, double*, unsigned long, unsigned long, double, int32_t* ec)
+{
+    *ec = 0;
+    return 0;
+}
+const char* lsl_last_error(void) { return ""; }
+}
+
+namespace {
+const unsigned int kChannels = 3;
+const double kRate = 100.0;
+unsigned int gFailures = 0;
+
+void check(bool ok, const char* what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAILED", what);
+    if (!ok)
+        gFailures++;
+}
+
+lsl::stream_info makeInfo(unsigned int channels = kChannels)
+{
+    return lsl::stream_info("shm-test", "Test", channels, kRate, lsl::cf_float32, "shm-test");
+}
+
+// Write a ring as a stale or foreign process might have left it
+bool writeRing(const std::string& uid, const Header& header, std::size_t bytes)
+{
+    std::string path = "/lsl-" + uid;
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        return false;
+    bool ok = ftruncate(fd, bytes) == 0 && pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+    close(fd);
+    return ok;
+}
+
+Header* mapHeader(const std::string& uid)
+{
+    int fd = shm_open(("/lsl-" + uid).c_str(), O_RDWR, 0);
+    if (fd < 0)
+        return nullptr;
+    void* mapping = mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return mapping == MAP_FAILED ? nullptr : static_cast<Header*>(mapping);
+}
+
+std::size_t ringBytes(unsigned int channels, unsigned int capacity)
+{
+    return sizeof(Header) + capacity * (sizeof(double) + channels * sizeof(float));
+}
+
+void roundTrip()
+{
+    gClock = -1.0;
+    SharedMemoryOutlet outlet(makeInfo(), 64);
+    SharedMemoryInlet inlet(outlet.info());
+    check(inlet.isSharedMemory() && outlet.hasSharedReader(), "same-host inlet reads the ring");
+
+    std::vector<float> data(10 * kChannels), received(64 * kChannels);
+    std::vector<double> timestamps(10), receivedTimestamps(64);
+    bool intact = true;
+    for (unsigned int chunk = 0; chunk < 20; chunk++) {
+        for (unsigned int f = 0; f < 10; f++) {
+            timestamps[f] = 1000.0 + (chunk * 10 + f) / kRate;
+            for (unsigned int ch = 0; ch < kChannels; ch++)
+                data[f * kChannels + ch] = chunk * 1000.0f + f * 10.0f + ch;
+        }
+        outlet.push_chunk_multiplexed(data.data(), timestamps.data(), data.size());
+        std::size_t elements = inlet.pull_chunk_multiplexed(received.data(), receivedTimestamps.data(),
+                                                             received.size(), receivedTimestamps.size());
+        intact = intact && elements == data.size() &&
+                 std::memcmp(received.data(), data.data(), data.size() * sizeof(float)) == 0 &&
+                 std::memcmp(receivedTimestamps.data(), timestamps.data(), timestamps.size() * sizeof(double)) == 0;
+    }
+    check(intact, "200 frames in chunks of 10 arrive intact with their timestamps");
+    check(outlet.getDropped() == 0, "nothing dropped while the reader keeps up");
+    check(gFramesPushed == 200, "the TCP outlet gets every frame too");
+    check(inlet.pull_chunk_multiplexed(received.data(), receivedTimestamps.data(), received.size(),
+                                       receivedTimestamps.size()) == 0, "an empty ring gives nothing");
+
+    // A blocking pull wakes as soon as another thread pushes
+    double pushedAt = 0.0;
+    std::thread writer([&] {
+        usleep(50000);
+        pushedAt = monotonic();
+        outlet.push_chunk_multiplexed(data.data(), timestamps.data(), data.size());
+    });
+    std::size_t elements = inlet.pull_chunk_multiplexed(received.data(), receivedTimestamps.data(), received.size(),
+                                                         receivedTimestamps.size(), 2.0);
+    double wokenAt = monotonic();
+    writer.join();
+    check(elements == data.size() && wokenAt - pushedAt < 0.02, "a blocking pull wakes on the next push");
+
+    // Another process rewriting the geometry must not move either end
+    Header* header = mapHeader(outlet.info().uid());
+    if (header) {
+        header->capacity = 1u << 30;
+        outlet.push_chunk_multiplexed(data.data(), timestamps.data(), data.size());
+        elements = inlet.pull_chunk_multiplexed(received.data(), receivedTimestamps.data(), received.size(),
+                                                receivedTimestamps.size());
+        check(elements == data.size() && std::memcmp(received.data(), data.data(), data.size() * sizeof(float)) == 0,
+              "a rewritten header capacity is ignored by both ends");
+        munmap(header, sizeof(Header));
+    } else {
+        check(false, "map the ring header");
+    }
+}
+
+void overflow()
+{
+    gClock = 50.0;
+    SharedMemoryOutlet outlet(makeInfo(), 64);
+    SharedMemoryInlet inlet(outlet.info());
+    const unsigned int frames = 100;
+    std::vector<float> data(frames * kChannels);
+    for (unsigned int n = 0; n < data.size(); n++)
+        data[n] = n;
+    outlet.push_chunk_multiplexed(data.data(), data.size());
+
+    std::vector<float> received(frames * kChannels);
+    std::vector<double> timestamps(frames);
+    std::size_t elements = inlet.pull_chunk_multiplexed(received.data(), timestamps.data(), received.size(),
+                                                         timestamps.size());
+    bool stamped = elements == 64 * kChannels;
+    for (unsigned int f = 0; stamped && f < 64; f++)
+        stamped = std::fabs(timestamps[f] - (50.0 - (frames - 1 - f) / kRate)) < 1e-9;
+    check(elements == 64 * kChannels && std::memcmp(received.data(), data.data(), elements * sizeof(float)) == 0,
+          "a chunk larger than the ring keeps its oldest frames");
+    check(stamped, "the kept frames are stamped as part of the whole chunk");
+    check(outlet.getDropped() == frames - 64, "the frames that did not fit are counted as dropped");
+    gClock = -1.0;
+}
+
+void lost()
+{
+    SharedMemoryOutlet* outlet = new SharedMemoryOutlet(makeInfo(), 64);
+    SharedMemoryInlet inlet(outlet->info());
+    float data[kChannels];
+    double timestamp;
+    bool thrown = false;
+    double destroyedAt = 0.0;
+    std::thread destroyer([&] {
+        usleep(50000);
+        destroyedAt = monotonic();
+        delete outlet;
+    });
+    try {
+        inlet.pull_chunk_multiplexed(data, &timestamp, kChannels, 1, 2.0);
+    } catch (lsl::lost_error&) {
+        thrown = true;
+    }
+    double wokenAt = monotonic();
+    destroyer.join();
+    check(thrown && wokenAt - destroyedAt < 0.02, "destroying the outlet wakes a blocked pull with lost_error");
+}
+
+void staleRings()
+{
+    struct Case {
+        const char* what;
+        Header header;
+        unsigned int mappedCapacity;
+    };
+    const Case cases[] = {
+        {"a ring with the wrong magic", {0x12345678, kChannels, 64, 1, 0, 0, 0, 0}, 64},
+        {"a ring with another channel count", {kMagic, kChannels + 1, 64, 1, 0, 0, 0, 0}, 64},
+        {"a capacity that is not a power of two", {kMagic, kChannels, 48, 1, 0, 0, 0, 0}, 64},
+        {"a zero capacity", {kMagic, kChannels, 0, 1, 0, 0, 0, 0}, 64},
+        {"a capacity larger than the mapping", {kMagic, kChannels, 1u << 20, 1, 0, 0, 0, 0}, 64},
+        {"a ring whose outlet is gone", {kMagic, kChannels, 64, 0, 0, 0, 0, 0}, 64},
+        {"a ring another reader has claimed", {kMagic, kChannels, 64, 1, 1, 0, 0, 0}, 64},
+    };
+    for (const Case& c : cases) {
+        lsl::stream_info info = makeInfo();
+        std::string uid = info.uid();
+        if (!writeRing(uid, c.header, ringBytes(kChannels, c.mappedCapacity))) {
+            check(false, "create a stale ring");
+            continue;
+        }
+        unsigned int fallbacks = gInletsCreated;
+        {
+            SharedMemoryInlet inlet(info);
+            std::string what = std::string("falls back to TCP for ") + c.what;
+            check(!inlet.isSharedMemory() && gInletsCreated == fallbacks + 1, what.c_str());
+        }
+        shm_unlink(("/lsl-" + uid).c_str());
+    }
+
+    // The same with a live outlet: the second reader is turned away
+    SharedMemoryOutlet outlet(makeInfo(), 64);
+    SharedMemoryInlet first(outlet.info());
+    SharedMemoryInlet second(outlet.info());
+    check(first.isSharedMemory() && !second.isSharedMemory(), "a second same-host inlet falls back to TCP");
+}
+} // namespace
+
+int main()
+{
+    roundTrip();
+    overflow();
+    lost();
+    staleRings();
+    printf("%u failures\n", gFailures);
+    return gFailures ? 1 : 0;
+}
@@ -0,0 +1,156 @@
+// Several boards playing one audio stream with SyncedPlayback: each board
+// has its own local clock offset, an audio clock skewed from nominal, late
+// and jittery render() calls, a noisy time_correction() and its own connect
+// time. Every board must start on the same source frame, and its true
+// alignment error (the source time it plays minus the one due when its DAC
+// plays the frame) must stay within relockError with no relocks or
+// underruns.
+//
+// Host only; from the repository root:
+//   g++ -std=c++14 -O2 -Isrc tests/SyncedPlaybackBoards.cpp src/SyncedPlayback.cpp src/FrameRing.cpp -o /tmp/synced-playback-boards
+//   /tmp/synced-playback-boards
+#include "FrameClock.h"
+#include "SyncedPlayback.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+const double kSampleRate = 44100.0;
+const unsigned int kBlockFrames = 16;
+const unsigned int kChunkFrames = 32;     // frames per chunk the source pushes
+const double kSourceEpoch = 100.0;        // source clock at true time 0
+const double kNetworkLatency = 0.005;     // s, plus up to kNetworkJitter
+const double kNetworkJitter = 0.002;      // s
+const double kRenderJitter = 0.0002;      // s render() may run late
+const double kCorrectionNoise = 0.0002;   // s either way
+const double kCorrectionInterval = 2.0;   // s between time_correction() updates
+const double kDuration = 60.0;            // s of true time
+const double kStep = 0.0005;              // s of true time per simulation step
+
+struct Board {
+    double skew;          // audio clock error, e.g. 1e-4 for 100 ppm fast
+    double clockOffset;   // local clock minus true time
+    double connectTime;   // true time the inlet opened
+    SyncedPlayback playback;
+    FrameClock clock;
+    uint64_t framesElapsed = 0;
+    double nextCorrection = 0.0;
+    bool started = false;
+    long startFrame = -1; // source frame index the board started on
+    double worstError = 0.0;
+    std::vector<float> out;
+};
+} // namespace
+
+int main()
+{
+    std::mt19937_64 random(1);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    const double skews[] = {-80e-6, -20e-6, 35e-6, 100e-6};
+    std::vector<Board> boards(sizeof(skews) / sizeof(skews[0]));
+    SyncedPlayback::Settings settings;
+    for (unsigned int b = 0; b < boards.size(); b++) {
+        Board& board = boards[b];
+        board.skew = skews[b];
+        board.clockOffset = 5000.0 + 1000.0 * unit(random);
+        board.connectTime = 0.3 * unit(random); // all before the first grid point is due
+        if (!board.playback.setup(1, kSampleRate, 16384, settings)) {
+            printf("setup failed\n");
+            return 1;
+        }
+        board.clock.setup(kSampleRate);
+        board.out.resize(kBlockFrames);
+    }
+
+    // Each source frame carries its index, so the output says what is playing
+    std::vector<float> chunk(kChunkFrames);
+    std::vector<double> timestamps(kChunkFrames);
+    long nextSourceFrame = 0;
+    std::vector<std::pair<double, long>> inFlight; // arrival time, first frame
+
+    unsigned int failures = 0;
+    for (double t = 0.0; t < kDuration; t += kStep) {
+        // The source pushes a chunk once its last frame has been sampled
+        while ((nextSourceFrame + kChunkFrames) / kSampleRate <= t) {
+            inFlight.push_back({t + kNetworkLatency + kNetworkJitter * unit(random), nextSourceFrame});
+            nextSourceFrame += kChunkFrames;
+        }
+        // Chunks can overtake each other in flight, but TCP delivers in order
+        while (!inFlight.empty() && inFlight.front().first <= t) {
+            long first = inFlight.front().second;
+            inFlight.erase(inFlight.begin());
+            for (unsigned int f = 0; f < kChunkFrames; f++) {
+                chunk[f] = (float)(first + f);
+                timestamps[f] = kSourceEpoch + (first + f) / kSampleRate;
+            }
+            for (Board& board : boards) {
+                if (first / kSampleRate < board.connectTime)
+                    continue;
+                if (board.playback.write(chunk.data(), timestamps.data(), kChunkFrames) != kChunkFrames) {
+                    printf("ring overflow\n");
+                    return 1;
+                }
+            }
+        }
+
+        for (unsigned int b = 0; b < boards.size(); b++) {
+            Board& board = boards[b];
+            if (t < board.connectTime)
+                continue;
+            if (t >= board.nextCorrection) {
+                double noise = kCorrectionNoise * (2.0 * unit(random) - 1.0);
+                board.playback.setCorrection(board.clockOffset - kSourceEpoch + noise);
+                board.nextCorrection = t + kCorrectionInterval;
+            }
+            // Every block whose first frame the DAC has reached by now
+            for (;;) {
+                double due = board.connectTime + board.framesElapsed / (kSampleRate * (1.0 + board.skew));
+                if (due > t)
+                    break;
+                double now = t + board.clockOffset + kRenderJitter * unit(random);
+                double blockTime = board.clock.update(board.framesElapsed, now);
+                bool wasPlaying = board.playback.getState() == SyncedPlayback::playing;
+                board.playback.process(board.out.data(), kBlockFrames, blockTime);
+                board.framesElapsed += kBlockFrames;
+                if (board.playback.getState() != SyncedPlayback::playing)
+                    continue;
+
+                // The block playback starts in is silent up to the start frame
+                if (!wasPlaying) {
+                    for (unsigned int n = 0; n < kBlockFrames && !board.started; n++) {
+                        if (board.out[n] != 0.0f) {
+                            board.startFrame = (long)std::floor(board.out[n]);
+                            board.started = true;
+                        }
+                    }
+                    continue;
+                }
+                // The source time this frame plays against the one due when it
+                // reaches the DAC
+                double played = board.out[0] / kSampleRate;
+                double expected = due - settings.delay;
+                double error = played - expected;
+                board.worstError = std::max(board.worstError, std::fabs(error));
+            }
+        }
+    }
+
+    long startFrame = boards[0].startFrame;
+    for (unsigned int b = 0; b < boards.size(); b++) {
+        const Board& board = boards[b];
+        bool ok = board.startFrame >= 0 && board.startFrame == startFrame && board.worstError <= settings.relockError &&
+                  board.playback.getRelocks() == 0 && board.playback.getUnderruns() == 0;
+        printf("board %u: %+.0f ppm, connected at %.3f s, started on frame %ld, worst error %.3f ms, "
+               "rate %.6f, %lu relocks, %lu underruns%s\n",
+               b, board.skew * 1e6, board.connectTime, board.startFrame, board.worstError * 1000.0,
+               board.playback.getRate(), board.playback.getRelocks(), board.playback.getUnderruns(),
+               ok ? "" : "  FAILED");
+        if (!ok)
+            failures++;
+    }
+    return failures ? 1 : 0;
+}